@@ -13,6 +13,9 @@ LOCAL_SRC_FILES := $(SDL_GPU_DIR)/src/SDL_gpu.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_matrix.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_renderer.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_shapes.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_simd.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_atlas.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_compressed.c \
 				   $(SDL_GPU_DIR)/src/renderer_GLES_1.c \
 				   $(SDL_GPU_DIR)/src/renderer_GLES_2.c \
 				   $(STB_IMAGE_DIR)/stb_image.c \
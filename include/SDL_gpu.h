@@ -202,7 +202,13 @@ typedef enum {
     GPU_FORMAT_ALPHA = 5,
     GPU_FORMAT_RG = 6,
     GPU_FORMAT_YCbCr422 = 7,
-    GPU_FORMAT_YCbCr420P = 8
+    GPU_FORMAT_YCbCr420P = 8,
+    // Block-compressed formats, which only come from compressed data (see GPU_CreateImageFromCompressedData()).  Their bytes_per_pixel is that of the RGBA they decode to.
+    GPU_FORMAT_BC1 = 9,  // DXT1
+    GPU_FORMAT_BC2 = 10,  // DXT3
+    GPU_FORMAT_BC3 = 11,  // DXT5
+    GPU_FORMAT_ETC2_RGB = 12,  // Also reads ETC1 data
+    GPU_FORMAT_ETC2_RGBA = 13  // ETC2 with EAC alpha
 } GPU_FormatEnum;
 
 /*! \ingroup ImageControls
@@ -240,6 +246,7 @@ typedef struct GPU_Image
 	int bytes_per_pixel;
 	Uint16 base_w, base_h;  // Original image dimensions
 	Uint16 texture_w, texture_h;  // Underlying texture dimensions
+	Uint16 texture_x, texture_y;  // Position of the image within the underlying texture (nonzero for atlas entries)
 	Uint8 has_mipmaps;
 	
 	SDL_Color color;
@@ -256,6 +263,45 @@ typedef struct GPU_Image
 } GPU_Image;
 
 
+/*! \ingroup ImageControls
+ * Packs many small images into a few large textures (pages), so that blitting them does not need a texture change.
+ * Each entry is returned as a GPU_Image that refers to its region of a page.
+ * \see GPU_CreateAtlas()
+ * \see GPU_AddToAtlas()
+ */
+typedef struct GPU_Atlas
+{
+	Uint16 page_w, page_h;
+	int padding;  // Empty pixels between entries
+	int extrude;  // Edge pixels repeated around each entry, so that filtering does not pull in a neighbor
+	int num_pages;
+	GPU_Image** pages;
+	
+	void* data;
+} GPU_Atlas;
+
+
+/*! \ingroup ImageControls
+ * Texture memory of the renderer's images, estimated from their texture sizes, formats, and mipmaps.  Drivers may add their own padding or conversions on top of this.
+ * \see GPU_GetMemoryStats()
+ * \see GPU_SetMemoryBudget()
+ */
+typedef struct GPU_MemoryStats
+{
+    Uint64 total_bytes;  /*!< image_bytes + target_bytes + pool_bytes, which is what the budget limits */
+    Uint64 image_bytes;  /*!< Textures of images without a render target */
+    Uint64 target_bytes;  /*!< Textures of images with a render target (see GPU_LoadTarget()) */
+    Uint64 pool_bytes;  /*!< Textures of freed images that are kept for new images of the same size and format */
+    Uint64 padding_bytes;  /*!< Part of image_bytes and target_bytes that only pads images out to a power of two, when the renderer lacks GPU_FEATURE_NON_POWER_OF_TWO */
+    Uint64 evicted_bytes;  /*!< Client memory holding the pixels of evicted images */
+    Uint64 budget_bytes;  /*!< 0 when there is no budget */
+    unsigned int num_images;  /*!< Images with a texture of their own, including evicted ones.  Aliases and atlas entries share their original's. */
+    unsigned int num_evicted_images;
+    unsigned int evictions;  /*!< Textures that were evicted since GPU_Init() */
+    unsigned int restores;  /*!< Evicted textures that were uploaded again since GPU_Init() */
+} GPU_MemoryStats;
+
+
 /*! \ingroup TargetControls
  * Camera object that determines viewing transform.
  * \see GPU_SetCamera() 
@@ -302,6 +348,7 @@ typedef struct GPU_MatrixStack
 {
     unsigned int size;
     float matrix[GPU_MATRIX_STACK_MAX][16];
+    unsigned int version;  /*!< Incremented whenever the stack might have changed, including when a pointer to one of its matrices is returned.  Renderers use it to skip rebuilding and uploading unchanged matrices. */
 } GPU_MatrixStack;
 
 
@@ -395,6 +442,8 @@ static const GPU_FeatureEnum GPU_FEATURE_FRAGMENT_SHADER = 0x200;
 static const GPU_FeatureEnum GPU_FEATURE_PIXEL_SHADER = 0x200;
 static const GPU_FeatureEnum GPU_FEATURE_GEOMETRY_SHADER = 0x400;
 static const GPU_FeatureEnum GPU_FEATURE_WRAP_REPEAT_MIRRORED = 0x800;
+static const GPU_FeatureEnum GPU_FEATURE_COMPRESSED_BC = 0x1000;
+static const GPU_FeatureEnum GPU_FEATURE_COMPRESSED_ETC2 = 0x2000;
 
 /*! Combined feature flags */
 #define GPU_FEATURE_ALL_BASE GPU_FEATURE_RENDER_TARGETS
@@ -402,6 +451,7 @@ static const GPU_FeatureEnum GPU_FEATURE_WRAP_REPEAT_MIRRORED = 0x800;
 #define GPU_FEATURE_ALL_GL_FORMATS (GPU_FEATURE_GL_BGR | GPU_FEATURE_GL_BGRA | GPU_FEATURE_GL_ABGR)
 #define GPU_FEATURE_BASIC_SHADERS (GPU_FEATURE_FRAGMENT_SHADER | GPU_FEATURE_VERTEX_SHADER)
 #define GPU_FEATURE_ALL_SHADERS (GPU_FEATURE_FRAGMENT_SHADER | GPU_FEATURE_VERTEX_SHADER | GPU_FEATURE_GEOMETRY_SHADER)
+#define GPU_FEATURE_ALL_COMPRESSED_FORMATS (GPU_FEATURE_COMPRESSED_BC | GPU_FEATURE_COMPRESSED_ETC2)
 
 
 typedef Uint32 GPU_WindowFlagEnum;
@@ -409,6 +459,10 @@ typedef Uint32 GPU_WindowFlagEnum;
 /*! \ingroup Initialization
  * Initialization flags for changing default init parameters.  Can be bitwise OR'ed together.
  * Default (0) is to use late swap vsync and double buffering.
+ * Renderers that support instancing (OpenGL 3.3+) draw sprite batches that use the default shader with one instance per sprite; GPU_INIT_DISABLE_INSTANCING turns this off.
+ * Renderers that support texture slots (OpenGL 3) keep several textures bound at once so sprite batches only break when all slots are taken; GPU_INIT_DISABLE_TEXTURE_SLOTS turns this off.
+ * GPU_INIT_BATCH_SHAPES_WITH_SPRITES draws filled shapes through the textured batch with a 1x1 white texture, so shapes and sprites that share blending do not break each other's batches.  GPU_Pixel(), GPU_Tri(), and GPU_Polygon() still use the untextured path.
+ * GPU_INIT_USE_PACKED_COLORS and GPU_INIT_USE_PACKED_TEX_COORDS shrink the batched vertex format by storing colors as bytes and texture coordinates as 16-bit normalized values.  Packed texture coordinates are clamped to [0, 1], so they do not suit GPU_WRAP_REPEAT blits that go past the image edge.
  * \see GPU_SetPreInitFlags()
  * \see GPU_GetPreInitFlags()
  */
@@ -418,6 +472,12 @@ static const GPU_InitFlagEnum GPU_INIT_DISABLE_VSYNC = 0x2;
 static const GPU_InitFlagEnum GPU_INIT_DISABLE_DOUBLE_BUFFER = 0x4;
 static const GPU_InitFlagEnum GPU_INIT_DISABLE_AUTO_VIRTUAL_RESOLUTION = 0x8;
 static const GPU_InitFlagEnum GPU_INIT_REQUEST_COMPATIBILITY_PROFILE = 0x10;
+static const GPU_InitFlagEnum GPU_INIT_USE_32BIT_INDICES = 0x20;
+static const GPU_InitFlagEnum GPU_INIT_USE_PACKED_COLORS = 0x40;
+static const GPU_InitFlagEnum GPU_INIT_USE_PACKED_TEX_COORDS = 0x80;
+static const GPU_InitFlagEnum GPU_INIT_DISABLE_INSTANCING = 0x100;
+static const GPU_InitFlagEnum GPU_INIT_DISABLE_TEXTURE_SLOTS = 0x200;
+static const GPU_InitFlagEnum GPU_INIT_BATCH_SHAPES_WITH_SPRITES = 0x400;
 
 #define GPU_DEFAULT_INIT_FLAGS 0
 
@@ -434,6 +494,7 @@ static const GPU_BatchFlagEnum GPU_BATCH_XYZ = 0x2;
 static const GPU_BatchFlagEnum GPU_BATCH_ST = 0x4;
 static const GPU_BatchFlagEnum GPU_BATCH_RGB = 0x8;
 static const GPU_BatchFlagEnum GPU_BATCH_RGBA = 0x10;
+static const GPU_BatchFlagEnum GPU_BATCH_NATIVE = 0x20;  // Values are already in the current context's vertex layout (see GPU_GetNativeVertexLayout()), so the other flags are ignored
 
 #define GPU_BATCH_XY_ST (GPU_BATCH_XY | GPU_BATCH_ST)
 #define GPU_BATCH_XYZ_ST (GPU_BATCH_XYZ | GPU_BATCH_ST)
@@ -444,6 +505,108 @@ static const GPU_BatchFlagEnum GPU_BATCH_RGBA = 0x10;
 #define GPU_BATCH_XY_ST_RGBA (GPU_BATCH_XY | GPU_BATCH_ST | GPU_BATCH_RGBA)
 #define GPU_BATCH_XYZ_ST_RGBA (GPU_BATCH_XYZ | GPU_BATCH_ST | GPU_BATCH_RGBA)
 
+/*! \ingroup Rendering
+ * Bit flags for sprite batching.  Each sprite is described by a position (x, y), a src rect (x, y, w, h in image pixels), a rotation (degrees, only with GPU_USE_ROTATIONS), a scale (x, y, only with GPU_USE_SCALES), and a color (r, g, b, a from 0 to 255), interleaved in that order.
+ * The passthrough flags replace the per-sprite value with 4 per-vertex values instead: x, y pairs, normalized s, t pairs, or normalized r, g, b, a.
+ * \see GPU_BlitBatch()
+ * \see GPU_BlitBatchSeparate()
+ */
+typedef Uint32 GPU_BlitFlagEnum;
+static const GPU_BlitFlagEnum GPU_PASSTHROUGH_VERTICES = 0x1;
+static const GPU_BlitFlagEnum GPU_PASSTHROUGH_TEXCOORDS = 0x2;
+static const GPU_BlitFlagEnum GPU_PASSTHROUGH_COLORS = 0x4;
+static const GPU_BlitFlagEnum GPU_USE_DEFAULT_POSITIONS = 0x8;
+static const GPU_BlitFlagEnum GPU_USE_DEFAULT_SRC_RECTS = 0x10;
+static const GPU_BlitFlagEnum GPU_USE_DEFAULT_COLORS = 0x20;
+static const GPU_BlitFlagEnum GPU_USE_ROTATIONS = 0x40;
+static const GPU_BlitFlagEnum GPU_USE_SCALES = 0x80;
+
+#define GPU_PASSTHROUGH_ALL (GPU_PASSTHROUGH_VERTICES | GPU_PASSTHROUGH_TEXCOORDS | GPU_PASSTHROUGH_COLORS)
+
+/*! \ingroup Rendering
+ * Batching modes.  GPU_BATCH_MODE_IMMEDIATE adds each blit to the current batch as it is called, so every texture, blend mode, or target switch flushes.
+ * GPU_BATCH_MODE_SORTED records blits instead and draws them on the next flush, stably sorted by target, layer, blend mode, and texture.
+ * Blits with the same sort key keep their call order, so anything that has to stay in order across textures or blend modes belongs in its own layer.
+ * \see GPU_SetBatchMode()
+ * \see GPU_SetBatchLayer()
+ */
+typedef enum {
+    GPU_BATCH_MODE_IMMEDIATE = 0,
+    GPU_BATCH_MODE_SORTED = 1
+} GPU_BatchModeEnum;
+
+/*! \ingroup Rendering
+ * Reasons for the blit buffer to be flushed, as counted by GPU_FrameStats.
+ * \see GPU_GetFrameStats()
+ */
+typedef enum {
+    GPU_FLUSH_CAUSE_USER = 0,  /*!< GPU_FlushBlitBuffer() or another explicit request, such as switching batch modes */
+    GPU_FLUSH_CAUSE_TEXTURE = 1,  /*!< A blit used a different texture (or no texture slot was free) */
+    GPU_FLUSH_CAUSE_TARGET = 2,  /*!< Rendering moved to a different target, window, or context */
+    GPU_FLUSH_CAUSE_SHADER = 3,  /*!< A shader program, shader image, uniform, or attribute changed */
+    GPU_FLUSH_CAUSE_STATE = 4,  /*!< Blending, texturing, primitive type, line thickness, clipping, camera, or resolution changed */
+    GPU_FLUSH_CAUSE_BUFFER_FULL = 5,  /*!< The batch reached its maximum size */
+    GPU_FLUSH_CAUSE_IMAGE_UPDATE = 6,  /*!< An image or target in the batch was updated, cleared, or freed */
+    GPU_FLUSH_CAUSE_READBACK = 7,  /*!< Pixels were read back from a target or image */
+    GPU_FLUSH_CAUSE_FLIP = 8  /*!< GPU_Flip() */
+} GPU_FlushCauseEnum;
+
+#define GPU_NUM_FLUSH_CAUSES 9
+
+/*! \ingroup Rendering
+ * Kinds of GL state that the renderer shadows, as counted by GPU_FrameStats.
+ * \see GPU_GetFrameStats()
+ */
+typedef enum {
+    GPU_STATE_TEXTURE = 0,  /*!< Texture bindings and the active texture unit */
+    GPU_STATE_PROGRAM = 1,  /*!< The shader program in use */
+    GPU_STATE_FRAMEBUFFER = 2,  /*!< The bound framebuffer */
+    GPU_STATE_VERTEX_ARRAY = 3,  /*!< The bound vertex array object */
+    GPU_STATE_BUFFER = 4,  /*!< Array and element array buffer bindings */
+    GPU_STATE_SCISSOR = 5,  /*!< The scissor test and scissor box */
+    GPU_STATE_VIEWPORT = 6,  /*!< The viewport */
+    GPU_STATE_BLEND = 7,  /*!< Blend function and equation */
+    GPU_STATE_VERTEX_ATTRIBUTE = 8  /*!< Enabled vertex attribute arrays */
+} GPU_StateEnum;
+
+#define GPU_NUM_STATES 9
+
+/*! \ingroup Rendering
+ * Rendering counters for the current context, accumulated since the last call to GPU_ResetFrameStats().
+ * Building SDL_gpu with SDL_GPU_DISABLE_FRAME_STATS removes the counting and leaves every counter at 0.
+ * \see GPU_GetFrameStats()
+ */
+typedef struct GPU_FrameStats
+{
+    unsigned int draw_calls;
+    unsigned int vertices;  /*!< Vertices submitted by draw calls, 4 per instanced sprite */
+    unsigned int indices;  /*!< Indices submitted by draw calls */
+    unsigned int bytes_uploaded;  /*!< Vertex, index, instance, and attribute data copied to buffer objects */
+    unsigned int flushes;  /*!< Flushes that drew something */
+    unsigned int flushes_by_cause[GPU_NUM_FLUSH_CAUSES];  /*!< Indexed by GPU_FlushCauseEnum */
+    unsigned int texture_binds;
+    unsigned int shader_switches;  /*!< Shader program changes, including the renderer's internal programs */
+    unsigned int target_switches;  /*!< Framebuffer and context changes */
+    unsigned int culled_primitives;  /*!< Blits and shapes dropped by GPU_SetCulling() before they were batched */
+    unsigned int state_calls[GPU_NUM_STATES];  /*!< GL state calls that were made, indexed by GPU_StateEnum */
+    unsigned int redundant_state_calls[GPU_NUM_STATES];  /*!< GL state calls that were skipped because they would not have changed anything, indexed by GPU_StateEnum */
+} GPU_FrameStats;
+
+/*! \ingroup Rendering
+ * Vertex data (and optional indices) kept in GPU memory, so geometry that rarely changes can be drawn again without being uploaded again.
+ * The vertex layout is given by GPU_BatchFlagEnum flags, just like for GPU_TriangleBatch().
+ * \see GPU_CreateVertexBuffer()
+ * \see GPU_DrawVertexBuffer()
+ */
+typedef struct GPU_VertexBuffer
+{
+    struct GPU_Renderer* renderer;
+    GPU_BatchFlagEnum flags;
+    unsigned int num_vertices;
+    unsigned int num_indices;  /*!< 0 if the vertices are drawn in order */
+    void* data;
+} GPU_VertexBuffer;
+
 /*! \ingroup ShaderInterface
  * Type enumeration for GPU_AttributeFormat specifications.
  */
@@ -458,6 +621,33 @@ static const GPU_TypeEnum GPU_TYPE_UNSIGNED_INT = 0x1405;
 static const GPU_TypeEnum GPU_TYPE_FLOAT = 0x1406;
 static const GPU_TypeEnum GPU_TYPE_DOUBLE = 0x140A;
 
+/*! \ingroup Rendering
+ * Describes the interleaved vertex format that the current context batches with.  Values passed to GPU_TriangleBatch() with GPU_BATCH_NATIVE are copied as they are, so they have to match it.
+ * Positions are always 2 floats (x, y).
+ * \see GPU_GetNativeVertexLayout()
+ */
+typedef struct GPU_NativeVertexLayout
+{
+    int stride;  /*!< Bytes per vertex */
+    int position_offset;  /*!< Offsets are in bytes from the start of a vertex */
+    int texcoord_offset;
+    GPU_TypeEnum texcoord_type;  /*!< GPU_TYPE_FLOAT (s, t), or GPU_TYPE_UNSIGNED_SHORT (0 - 65535 each) with GPU_INIT_USE_PACKED_TEX_COORDS */
+    int color_offset;
+    GPU_TypeEnum color_type;  /*!< GPU_TYPE_FLOAT (r, g, b, a from 0.0 to 1.0), or GPU_TYPE_UNSIGNED_BYTE (0 - 255 each) with GPU_INIT_USE_PACKED_COLORS */
+    int texture_slot_offset;  /*!< -1 if there is no texture slot.  Otherwise it is a float that native data has to leave at 0. */
+    unsigned int max_vertices;  /*!< Most vertices that one GPU_TriangleBatch() call with GPU_BATCH_NATIVE can take */
+} GPU_NativeVertexLayout;
+
+/*! \ingroup Matrix
+ * Instruction sets that sprite vertices can be generated with.
+ * \see GPU_SetSIMD()
+ */
+typedef enum {
+    GPU_SIMD_NONE = 0,
+    GPU_SIMD_SSE2 = 1,
+    GPU_SIMD_NEON = 2
+} GPU_SIMDEnum;
+
 
 
 
@@ -639,6 +829,13 @@ DECLSPEC void SDLCALL GPU_SetRequiredFeatures(GPU_FeatureEnum features);
 /*! Returns the current required features to use for initialization. */
 DECLSPEC GPU_FeatureEnum SDLCALL GPU_GetRequiredFeatures(void);
 
+/*! Set the number of vertices that a single batch can grow to before it is flushed. Set this before calling GPU_Init().
+ * \param max_vertices Batch capacity in vertices.  0 (the default) picks a capacity that suits the index type.  Without GPU_INIT_USE_32BIT_INDICES (or if 32-bit indices are not supported), the capacity is limited to 60000 vertices. */
+DECLSPEC void SDLCALL GPU_SetMaxBatchVertices(unsigned int max_vertices);
+
+/*! Returns the batch capacity to use for initialization, as set by GPU_SetMaxBatchVertices(). */
+DECLSPEC unsigned int SDLCALL GPU_GetMaxBatchVertices(void);
+
 /*! Gets the default initialization renderer IDs for the current platform copied into the 'order' array and the number of renderer IDs into 'order_size'.  Pass NULL for 'order' to just get the size of the renderer order array.  Will return at most GPU_RENDERER_ORDER_MAX renderers. */
 DECLSPEC void SDLCALL GPU_GetDefaultRendererOrder(int* order_size, GPU_RendererID* order);
 
@@ -978,9 +1175,19 @@ DECLSPEC GPU_Image* SDLCALL GPU_CreateImage(Uint16 w, Uint16 h, GPU_FormatEnum f
 /*! Create a new image that uses the given native texture handle as the image texture. */
 DECLSPEC GPU_Image* SDLCALL GPU_CreateImageUsingTexture(Uint32 handle, Uint8 take_ownership);
 
-/*! Load image from an image file that is supported by this renderer.  Don't forget to GPU_FreeImage() it. */
+/*! Load image from an image file that is supported by this renderer.  Don't forget to GPU_FreeImage() it.
+ * DDS and KTX files (.dds, .ktx) of compressed formats are loaded with their mipmaps, as with GPU_CreateImageFromCompressedData(). */
 DECLSPEC GPU_Image* SDLCALL GPU_LoadImage(const char* filename);
 
+/*! Create a new image from block-compressed data.  Don't forget to GPU_FreeImage() it.
+ * \param w Image width in pixels
+ * \param h Image height in pixels
+ * \param format One of the compressed formats, like GPU_FORMAT_BC1.
+ * \param num_levels Number of mipmap levels given, starting from the full size and halving down from there.
+ * \param level_data The blocks of each level, in rows of 4x4 texel blocks.
+ * If the renderer does not support the format (see GPU_FEATURE_COMPRESSED_BC and GPU_FEATURE_COMPRESSED_ETC2), the data is decompressed into a GPU_FORMAT_RGBA image instead. */
+DECLSPEC GPU_Image* SDLCALL GPU_CreateImageFromCompressedData(Uint16 w, Uint16 h, GPU_FormatEnum format, int num_levels, const unsigned char* const* level_data);
+
 /*! Creates an image that aliases the given image.  Aliases can be used to store image settings (e.g. modulation color) for easy switching.
  * GPU_FreeImage() frees the alias's memory, but does not affect the original. */
 DECLSPEC GPU_Image* SDLCALL GPU_CreateAliasImage(GPU_Image* image);
@@ -1003,6 +1210,18 @@ DECLSPEC void SDLCALL GPU_UpdateImage(GPU_Image* image, const GPU_Rect* image_re
 /*! Update an image from an array of pixel data.  Ignores virtual resolution on the image so the number of pixels needed from the surface is known. */
 DECLSPEC void SDLCALL GPU_UpdateImageBytes(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
 
+/*! Like GPU_UpdateImageBytes(), but the pixels are staged in a pixel buffer so the copy to the texture overlaps later rendering instead of blocking the caller.
+ * The bytes can be reused as soon as this returns.  Falls back to GPU_UpdateImageBytes() on renderers without pixel buffers and fences. */
+DECLSPEC void SDLCALL GPU_UpdateImageBytesAsync(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
+
+/*! Returns memory to write new pixels for the given rectangle (or the whole image if NULL) into, which saves a copy over GPU_UpdateImageBytesAsync().
+ * Rows are tightly packed and *bytes_per_row apart.  The memory is a mapped staging buffer where supported, else client memory.
+ * Only one image can be locked at a time.  Call GPU_UnlockImageBytes() to upload the pixels.  Returns NULL on failure. */
+DECLSPEC unsigned char* SDLCALL GPU_LockImageBytes(GPU_Image* image, const GPU_Rect* image_rect, int* bytes_per_row);
+
+/*! Uploads the pixels written since GPU_LockImageBytes().  The memory that was returned can't be used afterward. */
+DECLSPEC void SDLCALL GPU_UnlockImageBytes(GPU_Image* image);
+
 /*! Save image to a file.
  * With a format of GPU_FILE_AUTO, the file type is deduced from the extension.  Supported formats are: png, bmp, tga.
  * Returns 0 on failure. */
@@ -1051,6 +1270,43 @@ DECLSPEC void SDLCALL GPU_SetSnapMode(GPU_Image* image, GPU_SnapEnum mode);
 /*! Sets the image wrapping mode, if supported by the renderer. */
 DECLSPEC void SDLCALL GPU_SetWrapMode(GPU_Image* image, GPU_WrapEnum wrap_mode_x, GPU_WrapEnum wrap_mode_y);
 
+/*! Creates an empty atlas.  Pages of the given size (GPU_FORMAT_RGBA) are created as they are needed.  Don't forget to GPU_FreeAtlas() it. */
+DECLSPEC GPU_Atlas* SDLCALL GPU_CreateAtlas(Uint16 page_w, Uint16 page_h, int padding, int extrude);
+
+/*! Copies the surface into a free spot on one of the atlas pages.
+ * The returned image blits like any other, and blits of images from the same page are batched together.
+ * Filter modes, wrap modes, render targets, and reading pixels back apply to the whole page.
+ * Remove it with GPU_RemoveFromAtlas() instead of GPU_FreeImage().
+ * \return NULL if the surface does not fit on an empty page. */
+DECLSPEC GPU_Image* SDLCALL GPU_AddToAtlas(GPU_Atlas* atlas, SDL_Surface* surface);
+
+/*! Frees an image returned by GPU_AddToAtlas().  Its space is reused once the rest of its row is freed too, or after GPU_DefragmentAtlas(). */
+DECLSPEC void SDLCALL GPU_RemoveFromAtlas(GPU_Atlas* atlas, GPU_Image* image);
+
+/*! Repacks the remaining entries into as few pages as possible and frees the pages that are left empty.
+ * The entry images stay valid and are updated in place.  This reads the pages back from the GPU, so it is slow.
+ * \return 0 on failure, in which case the atlas is unchanged. */
+DECLSPEC Uint8 SDLCALL GPU_DefragmentAtlas(GPU_Atlas* atlas);
+
+/*! Frees the atlas, its pages, and all of its entry images. */
+DECLSPEC void SDLCALL GPU_FreeAtlas(GPU_Atlas* atlas);
+
+/*! Returns the bytes of texture memory counted for the given image, which an evicted image takes up again once it is restored.  Aliases and atlas entries report the whole texture that they share. */
+DECLSPEC Uint64 SDLCALL GPU_GetImageMemoryUsage(GPU_Image* image);
+
+/*! Returns the texture memory totals of the current renderer.
+ * \see GPU_MemoryStats */
+DECLSPEC GPU_MemoryStats SDLCALL GPU_GetMemoryStats(void);
+
+/*! Limits the texture memory of the current renderer, or removes the limit with 0 (the default).
+ * Whenever the total goes over the budget, textures kept for reuse are deleted first, and then the least recently bound images are evicted: their pixels are copied into client memory and their textures are deleted.
+ * An evicted image is uploaded again the next time it is bound, so it keeps working as usual.
+ * Images with a render target, mipmaps, or compressed data are never evicted, and neither are textures shared with aliases or atlas entries. */
+DECLSPEC void SDLCALL GPU_SetMemoryBudget(Uint64 bytes);
+
+/*! Returns the texture memory budget of the current renderer, or 0 if there is none. */
+DECLSPEC Uint64 SDLCALL GPU_GetMemoryBudget(void);
+
 // End of ImageControls
 /*! @} */
 
@@ -1149,6 +1405,24 @@ DECLSPEC void SDLCALL GPU_Rotate(float degrees, float x, float y, float z);
 /*! Multiplies a given matrix into the current matrix. */
 DECLSPEC void SDLCALL GPU_MultMatrix(float* matrix4x4);
 
+
+// Vertex generation
+
+/*! Computes the sine and cosine of an angle (in radians) in single precision.  Faster than sin() and cos() and accurate to about 1e-6 for angles within +/-8192. */
+DECLSPEC void SDLCALL GPU_SinCos(float radians, float* sin_result, float* cos_result);
+
+/*! Returns the instruction set used for generating sprite vertices.  The first call picks the best one that the CPU supports. */
+DECLSPEC GPU_SIMDEnum SDLCALL GPU_GetSIMD(void);
+
+/*! Changes the instruction set used for generating sprite vertices, e.g. to compare against GPU_SIMD_NONE.  Unsupported sets fall back to GPU_SIMD_NONE.
+ * \return The instruction set now in use. */
+DECLSPEC GPU_SIMDEnum SDLCALL GPU_SetSIMD(GPU_SIMDEnum simd);
+
+/*! Writes the 4 vertices of a sprite as x, y, s, t, r, g, b, a floats each, in the order (dx1, dy1), (dx2, dy1), (dx2, dy2), (dx1, dy2).
+ * The corners are relative to (x, y) and rotated about it by the angle given as its sine and cosine.  This needs no renderer.
+ * \param floats_per_vertex Distance between the starts of consecutive vertices in 'result' (at least 8).  Floats past the first 8 of each vertex are left alone. */
+DECLSPEC void SDLCALL GPU_MakeSpriteVertices(float* result, int floats_per_vertex, float dx1, float dy1, float dx2, float dy2, float x, float y, float sin_angle, float cos_angle, float s1, float t1, float s2, float t2, float r, float g, float b, float a);
+
 // End of Matrix
 /*! @} */
 
@@ -1214,15 +1488,97 @@ DECLSPEC void SDLCALL GPU_BlitTransform(GPU_Image* image, GPU_Rect* src_rect, GP
 DECLSPEC void SDLCALL GPU_BlitTransformX(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY);
 
 /*! Renders triangles from the given set of vertices.  This lets you render arbitrary 2D geometry.  It is a direct path to the GPU, so the format is different than typical SDL_gpu calls.
+ * 2D triangles join the current batch, so consecutive calls with the same image, shader, and blending are drawn together.  Vertices without colors use the image color (or white without an image).
  * \param values A tightly-packed array of vertex position (e.g. x,y), texture coordinates (e.g. s,t), and color (e.g. r,g,b,a) values.  Texture coordinates and color values are expected to be already normalized to 0.0 - 1.0.  Pass NULL to render with only custom shader attributes.
  * \param indices If not NULL, this is used to specify which vertices to use and in what order (i.e. it indexes the vertices in the 'values' array).
- * \param flags Bit flags to control the interpretation of the 'values' array parameters.
+ * \param flags Bit flags to control the interpretation of the 'values' array parameters.  GPU_BATCH_NATIVE copies the values without converting them.
  */
 DECLSPEC void SDLCALL GPU_TriangleBatch(GPU_Image* image, GPU_Target* target, unsigned short num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags);
 
-/*! Send all buffered blitting data to the current context target. */
+/*! Draws many sprites from one image at once.  The sprites are expanded straight into the blit buffer, which is much faster than a GPU_Blit() call per sprite.
+ * \param values Interleaved per-sprite data, laid out as described by GPU_BlitFlagEnum.  Pass NULL to use the defaults for everything (e.g. with custom shader attributes).
+ * \param flags Bit flags that select which per-sprite values are present and how they are interpreted.
+ */
+DECLSPEC void SDLCALL GPU_BlitBatch(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags);
+
+/*! Draws many sprites from one image at once, taking each kind of per-sprite data from its own tightly-packed array.
+ * \param positions x, y per sprite (or 4 x, y pairs with GPU_PASSTHROUGH_VERTICES).  NULL puts every sprite at (0, 0).
+ * \param src_rects x, y, w, h per sprite (or 4 s, t pairs with GPU_PASSTHROUGH_TEXCOORDS).  NULL uses the whole image.
+ * \param rotations Angle in degrees per sprite.  NULL for no rotation.
+ * \param scales x, y stretch factors per sprite.  NULL for no scaling.
+ * \param colors r, g, b, a (0 - 255) per sprite (or 4 normalized r, g, b, a sets with GPU_PASSTHROUGH_COLORS).  NULL uses the image color.
+ * \param flags Bit flags to control the interpretation of the arrays.
+ */
+DECLSPEC void SDLCALL GPU_BlitBatchSeparate(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* rotations, float* scales, float* colors, GPU_BlitFlagEnum flags);
+
+/*! Creates a vertex buffer for the current context that keeps triangle data in GPU memory.  Renderers without buffer objects keep a copy in system memory instead.
+ * \param num_vertices Number of vertices in the buffer.
+ * \param values Vertex data in the layout given by 'flags' (see GPU_TriangleBatch()), or NULL to leave the vertices undefined until GPU_UpdateVertexBuffer().
+ * \param num_indices Number of indices in the buffer, or 0 to draw the vertices in order.
+ * \param indices Index data, or NULL to leave the indices undefined until GPU_UpdateVertexBufferIndices().
+ * \param flags Bit flags for the vertex layout.
+ * \return The new vertex buffer, or NULL on failure. */
+DECLSPEC GPU_VertexBuffer* SDLCALL GPU_CreateVertexBuffer(unsigned int num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags);
+
+/*! Replaces a range of vertices in the given vertex buffer.
+ * \param first_vertex Index of the first vertex to replace.
+ * \param num_vertices Number of vertices to replace.
+ * \param values Vertex data in the buffer's layout. */
+DECLSPEC void SDLCALL GPU_UpdateVertexBuffer(GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, float* values);
+
+/*! Replaces a range of indices in the given vertex buffer. */
+DECLSPEC void SDLCALL GPU_UpdateVertexBufferIndices(GPU_VertexBuffer* buffer, unsigned int first_index, unsigned int num_indices, unsigned short* indices);
+
+/*! Draws the triangles of a vertex buffer with the current shader, matrices, and camera.  Nothing is uploaded except uniforms and custom shader attributes.
+ * \param image The texture to draw with, or NULL for untextured triangles. */
+DECLSPEC void SDLCALL GPU_DrawVertexBuffer(GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer);
+
+/*! Deletes a vertex buffer and its GPU memory. */
+DECLSPEC void SDLCALL GPU_FreeVertexBuffer(GPU_VertexBuffer* buffer);
+
+/*! Send all buffered blitting data to the current context target.
+ * Drawing leaves the scissor test enabled and the vertex array bound between batches, so this also turns the scissor test off and unbinds the vertex array, ready for direct OpenGL calls.
+ * \see GPU_ResetRendererState() */
 DECLSPEC void SDLCALL GPU_FlushBlitBuffer(void);
 
+/*! Returns the index type used for batching in the current context.
+ * \return GPU_TYPE_UNSIGNED_INT if GPU_INIT_USE_32BIT_INDICES was requested and is supported, otherwise GPU_TYPE_UNSIGNED_SHORT. */
+DECLSPEC GPU_TypeEnum SDLCALL GPU_GetIndexType(void);
+
+/*! Returns the interleaved vertex format of the current context, for building data to pass to GPU_TriangleBatch() with GPU_BATCH_NATIVE.  The stride is 0 if there is no current context.
+ * \see GPU_NativeVertexLayout */
+DECLSPEC GPU_NativeVertexLayout SDLCALL GPU_GetNativeVertexLayout(void);
+
+/*! Sets the batching mode of the current context.  Switching modes submits any recorded blits.
+ * In GPU_BATCH_MODE_SORTED, blits are submitted by GPU_FlushBlitBuffer(), GPU_Flip(), any other kind of drawing, shader or uniform changes, and changes to a recorded image or target.
+ * Matrices and cameras are read when the blits are submitted, just like for the immediate batch.
+ * \see GPU_BatchModeEnum */
+DECLSPEC void SDLCALL GPU_SetBatchMode(GPU_BatchModeEnum mode);
+
+/*! Returns the batching mode of the current context. */
+DECLSPEC GPU_BatchModeEnum SDLCALL GPU_GetBatchMode(void);
+
+/*! Sets the layer for blits recorded from now on in GPU_BATCH_MODE_SORTED.  Lower layers are drawn first.  Defaults to 0. */
+DECLSPEC void SDLCALL GPU_SetBatchLayer(int layer);
+
+/*! Returns the layer that recorded blits are given in GPU_BATCH_MODE_SORTED. */
+DECLSPEC int SDLCALL GPU_GetBatchLayer(void);
+
+/*! Enables or disables CPU culling in the current context.  Off by default.
+ * When enabled, GPU_Blit(), the GPU_BlitTransformX() family, and the shape functions compare a bounding box against the target's size (its virtual resolution, if set) and clip rect as seen through its camera.  Anything that cannot touch the visible area is dropped before it is batched and counted in GPU_FrameStats::culled_primitives.
+ * Geometry that is moved by a custom shader can be culled wrongly, so leave this off for such drawing. */
+DECLSPEC void SDLCALL GPU_SetCulling(Uint8 enable);
+
+/*! Returns 1 if CPU culling is enabled in the current context, otherwise 0. */
+DECLSPEC Uint8 SDLCALL GPU_GetCulling(void);
+
+/*! Returns the rendering counters of the current context since the last GPU_ResetFrameStats().  Call GPU_ResetFrameStats() once per frame (e.g. right after GPU_Flip()) to get per-frame numbers.
+ * \see GPU_FrameStats */
+DECLSPEC GPU_FrameStats SDLCALL GPU_GetFrameStats(void);
+
+/*! Sets all of the rendering counters of the current context back to 0. */
+DECLSPEC void SDLCALL GPU_ResetFrameStats(void);
+
 /*! Updates the given target's associated window. */
 DECLSPEC void SDLCALL GPU_Flip(GPU_Target* target);
 
@@ -1511,7 +1867,9 @@ DECLSPEC void SDLCALL GPU_GetUniformiv(Uint32 program_object, int location, int*
     This is equivalent to calling GPU_SetUniformiv(location, 1, 1, &value). */
 DECLSPEC void SDLCALL GPU_SetUniformi(int location, int value);
 
-/*! Sets the value of the integer uniform shader variable at the given location. */
+/*! Sets the value of the integer uniform shader variable at the given location.
+    Uniform values are remembered per shader program.  Setting the value a uniform already has does nothing (and does not flush the blit buffer).
+    New values are sent to GL right before the next draw with the current shader program. */
 DECLSPEC void SDLCALL GPU_SetUniformiv(int location, int num_elements_per_value, int num_values, int* values);
 
 /*! Fills "values" with the value of the uniform shader variable at the given location. */
@@ -32,10 +32,33 @@
 #define GPU_CONTEXT_DATA ContextData_OpenGL_1_BASE
 #define GPU_IMAGE_DATA ImageData_OpenGL_1_BASE
 #define GPU_TARGET_DATA TargetData_OpenGL_1_BASE
+#define GPU_POOLED_TEXTURE_DATA PooledTextureData_OpenGL_1_BASE
+
+// Texture units whose bindings are shadowed, so redundant binds can be skipped
+#define GPU_SHADOWED_TEXTURE_UNITS 8
+
+// Textures of freed images that are kept for new images of the same size and format
+#ifndef GPU_TEXTURE_POOL_SIZE
+#define GPU_TEXTURE_POOL_SIZE 16
+#endif
+
+// Distinct images and targets that the recorded sorted blits use, so changes to anything else don't have to submit them
+#define GPU_SORTED_BLIT_TRACKED_IMAGES 16
+#define GPU_SORTED_BLIT_TRACKED_TARGETS 4
 
 
 
 
+// A texture of a freed image, kept for the next image that needs the same storage
+typedef struct PooledTextureData_OpenGL_1_BASE
+{
+	Uint32 handle;
+	Uint16 w, h;
+	Uint32 format;
+	Uint8 immutable;
+	Uint64 bytes;  // Counted in GPU_MemoryStats::pool_bytes
+} PooledTextureData_OpenGL_1_BASE;
+
 typedef struct ContextData_OpenGL_1_BASE
 {
 	SDL_Color last_color;
@@ -46,15 +69,82 @@ typedef struct ContextData_OpenGL_1_BASE
 	GPU_Rect last_viewport;
 	GPU_Camera last_camera;
 	Uint8 last_camera_inverted;
+	GPU_Target* last_camera_target;  // The matrices hold this target's camera until the values below change
+	Uint16 last_camera_w, last_camera_h;
+	int last_camera_coordinate_mode;
+	unsigned int last_camera_projection_version;  // Matrix stack versions right after the camera was applied
+	unsigned int last_camera_modelview_version;
 	
 	GPU_Image* last_image;
 	GPU_Target* last_target;
 	float* blit_buffer;  // Holds sets of 4 vertices and 4 tex coords interleaved (e.g. [x0, y0, z0, s0, t0, ...]).
-	unsigned short blit_buffer_num_vertices;
-	unsigned short blit_buffer_max_num_vertices;
-	unsigned short* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad)
+	unsigned int blit_buffer_num_vertices;
+	unsigned int blit_buffer_max_num_vertices;
+	unsigned int blit_buffer_vertex_limit;  // Most vertices a batch can grow to before it has to be flushed
+	unsigned int blit_buffer_floats_per_vertex;  // Vertex size in 4-byte units (8 for the default all-float layout)
+	unsigned int blit_buffer_color_offset;  // In 4-byte units from the start of a vertex
+	Uint8 packed_tex_coords;  // Tex coords are stored as normalized unsigned shorts instead of floats
+	Uint8 packed_colors;  // Colors are stored as normalized unsigned bytes instead of floats
+	void* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad).  Holds unsigned shorts or unsigned ints, depending on index_type.
+	unsigned int index_type;  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
 	unsigned int index_buffer_num_vertices;
 	unsigned int index_buffer_max_num_vertices;
+	void* quad_index_buffer;  // Pre-built indices for a blit buffer full of sprites (0, 1, 2, 0, 2, 3, 4, 5, 6, ...), in index_type format
+	unsigned int quad_index_buffer_num_indices;
+	Uint8 blit_buffer_uses_index_buffer;  // Triangles were batched with the sprites, so the batch is drawn with index_buffer instead of quad_index_buffer
+	GPU_Image* white_texel;  // 1x1 white image that filled shapes sample to join sprite batches (GPU_INIT_BATCH_SHAPES_WITH_SPRITES)
+	Uint8 shapes_use_white_texel;  // The current shapes are going into the sprite batch
+	
+	Uint8 batch_mode;  // GPU_BATCH_MODE_IMMEDIATE or GPU_BATCH_MODE_SORTED
+	int batch_layer;  // Layer given to blits recorded from now on
+	Uint8 use_culling;  // Blits and shapes that can't reach the visible part of their target are dropped (GPU_SetCulling())
+	struct GPU_SortedBlit* sorted_blit_buffer;  // Blits recorded in GPU_BATCH_MODE_SORTED, drawn in sorted order on the next flush
+	unsigned int sorted_blit_buffer_num_blits;
+	unsigned int sorted_blit_buffer_max_num_blits;
+	unsigned int sorted_blit_segment;  // Bumped whenever the recorded target changes, so sorting never moves a blit across a target change
+	GPU_Target* sorted_blit_last_target;
+	Uint8 submitting_sorted_blits;
+	void* sorted_blit_images[GPU_SORTED_BLIT_TRACKED_IMAGES];  // Data of the images and targets that the recorded blits use, which aliases share.  A count past the end means any of them might be used.
+	unsigned int sorted_blit_num_images;
+	void* sorted_blit_targets[GPU_SORTED_BLIT_TRACKED_TARGETS];
+	unsigned int sorted_blit_num_targets;
+	
+	PooledTextureData_OpenGL_1_BASE texture_pool[GPU_TEXTURE_POOL_SIZE];  // Oldest first
+	int texture_pool_size;
+	Uint8 use_texture_storage;  // glTexStorage2D() is available
+	Uint8 use_clear_texture;  // glClearTexImage() is available
+	unsigned char* zero_buffer;  // Zeros for clearing textures without glClearTexImage()
+	unsigned int zero_buffer_size;
+	
+	// GPU_LockImageBytes() hands out memory for one image at a time
+	GPU_Image* locked_image;  // NULL when nothing is locked
+	GPU_Rect locked_rect;
+	unsigned char* locked_bytes;  // Mapped from upload_ring or else staging_buffer
+	unsigned char* staging_buffer;  // Client memory for locks when pixel buffers can't be streamed
+	unsigned int staging_buffer_size;
+	
+	// Shadow of the GL state, used to skip calls that would not change anything.  GPU_GL_STATE_UNKNOWN (or a negative width) means the next call goes through.
+	Uint32 gl_active_texture_unit;
+	Uint32 gl_textures[GPU_SHADOWED_TEXTURE_UNITS];
+	Uint32 gl_framebuffer;
+	Uint32 gl_vertex_array;
+	Uint32 gl_array_buffer;
+	Uint32 gl_element_array_buffer;  // Part of the vertex array state
+	Uint32 gl_scissor_test;
+	int gl_scissor[4];
+	int gl_viewport[4];
+	Uint32 gl_blend_func[4];  // Source color, dest color, source alpha, dest alpha
+	Uint32 gl_blend_equation[2];  // Color, alpha
+	Uint32 gl_enabled_attributes;  // Vertex attribute arrays that are enabled, valid for the bits in gl_known_attributes
+	Uint32 gl_known_attributes;
+	Uint32 gl_maybe_enabled_attributes;  // Vertex attribute arrays that are not certainly disabled
+	Uint32 gl_all_attributes;  // One bit for each vertex attribute location that GL has
+	Uint32 gl_used_attributes;  // Vertex attribute arrays enabled for the draw call being set up
+	
+	#ifndef SDL_GPU_DISABLE_FRAME_STATS
+	GPU_FrameStats frame_stats;
+	Uint8 flush_cause;  // GPU_FlushCauseEnum counted by the next flush
+	#endif
 } ContextData_OpenGL_1_BASE;
 
 typedef struct ImageData_OpenGL_1_BASE
@@ -63,6 +153,18 @@ typedef struct ImageData_OpenGL_1_BASE
     Uint8 owns_handle;
 	Uint32 handle;
 	Uint32 format;
+	Uint8 poolable;  // The texture is a single level of texture_w x texture_h, so another image can reuse it
+	Uint8 immutable;  // Storage is from glTexStorage2D(), so it can't be respecified
+	
+	// Texture memory accounting (see GPU_GetMemoryStats())
+	GPU_Image* owner;  // Image that evicts and restores the texture, NULL once an alias has outlived it
+	Uint64 memory_bytes;  // 0 when the texture isn't counted
+	Uint64 padding_bytes;  // Part of memory_bytes that only pads the image out to a power of two
+	Uint8 memory_is_target;  // Counted as render target memory
+	unsigned char* evicted_pixels;  // Copy of the texture while it is evicted to stay within the memory budget, NULL while resident
+	struct ImageData_OpenGL_1_BASE* lru_prev;  // Counted textures are listed from least to most recently bound
+	struct ImageData_OpenGL_1_BASE* lru_next;
+	GPU_Context* memory_context;  // Context that made the counted texture, the only one that may read it back and delete it
 } ImageData_OpenGL_1_BASE;
 
 typedef struct TargetData_OpenGL_1_BASE
@@ -28,6 +28,40 @@
 #define GPU_CONTEXT_DATA ContextData_OpenGL_3
 #define GPU_IMAGE_DATA ImageData_OpenGL_3
 #define GPU_TARGET_DATA TargetData_OpenGL_3
+#define GPU_POOLED_TEXTURE_DATA PooledTextureData_OpenGL_3
+#define GPU_UNIFORM_DATA UniformData_OpenGL_3
+#define GPU_VERTEX_FORMAT_DATA VertexFormatData_OpenGL_3
+#define GPU_VERTEX_ATTRIBUTE_DATA VertexAttributeData_OpenGL_3
+#define GPU_RING_BUFFER_DATA RingBufferData_OpenGL_3
+
+// Programs that remember their last model-view-projection matrix
+#define GPU_MVP_CACHE_SIZE 4
+
+// Texture units whose bindings are shadowed, so redundant binds can be skipped
+#define GPU_SHADOWED_TEXTURE_UNITS 8
+
+// Textures of freed images that are kept for new images of the same size and format
+#ifndef GPU_TEXTURE_POOL_SIZE
+#define GPU_TEXTURE_POOL_SIZE 16
+#endif
+
+// Distinct images and targets that the recorded sorted blits use, so changes to anything else don't have to submit them
+#define GPU_SORTED_BLIT_TRACKED_IMAGES 16
+#define GPU_SORTED_BLIT_TRACKED_TARGETS 4
+
+// Vertex arrays with the blit buffer format already set up (see VertexFormatData_OpenGL_3)
+#define GPU_VERTEX_FORMAT_CACHE_SIZE 8
+
+// Vertex arrays whose element buffer and enabled attributes are remembered while another one is bound.  Room for the vertex format cache, blit_VAO and instance_VAO.
+#define GPU_SHADOWED_VERTEX_ARRAYS (GPU_VERTEX_FORMAT_CACHE_SIZE + 4)
+
+// Number of fence-guarded regions in each streaming ring buffer (roughly the number of flushes allowed in flight)
+#ifndef GPU_BLIT_RING_NUM_REGIONS
+#define GPU_BLIT_RING_NUM_REGIONS 3
+#endif
+
+// Number of textures a sprite batch can sample from at once.  The texture slot shaders below have a branch for each one.
+#define GPU_MAX_TEXTURE_SLOTS 8
 
 
 #define GPU_DEFAULT_TEXTURED_VERTEX_SHADER_SOURCE \
@@ -87,10 +121,87 @@ void main(void)\n\
 {\n\
     gl_FragColor = color;\n\
 }"
-
-
-
-
+
+// Instanced sprites expand one record per sprite into a 4-vertex triangle strip: corners relative to the pivot (x1, y1, x2, y2), translation and rotation in radians (x, y, angle), tex coords (s1, t1, s2, t2), color, and texture slot.
+#define GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE \
+"#version 130\n\
+\
+in vec4 gpu_InstanceCorners;\n\
+in vec3 gpu_InstanceTransform;\n\
+in vec4 gpu_InstanceTexCoords;\n\
+in vec4 gpu_InstanceColor;\n\
+in float gpu_InstanceTextureSlot;\n\
+uniform mat4 gpu_ModelViewProjectionMatrix;\n\
+\
+out vec4 color;\n\
+out vec2 texCoord;\n\
+flat out float textureSlot;\n\
+\
+void main(void)\n\
+{\n\
+	vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n\
+	vec2 pos = mix(gpu_InstanceCorners.xy, gpu_InstanceCorners.zw, corner);\n\
+	float cosA = cos(gpu_InstanceTransform.z);\n\
+	float sinA = sin(gpu_InstanceTransform.z);\n\
+	pos = vec2(pos.x*cosA - pos.y*sinA, pos.x*sinA + pos.y*cosA) + gpu_InstanceTransform.xy;\n\
+	color = gpu_InstanceColor;\n\
+	texCoord = mix(gpu_InstanceTexCoords.xy, gpu_InstanceTexCoords.zw, corner);\n\
+	textureSlot = gpu_InstanceTextureSlot;\n\
+	gl_Position = gpu_ModelViewProjectionMatrix * vec4(pos, 0.0, 1.0);\n\
+}"
+
+// Sprite batches that sample from several textures at once.  Each vertex carries the slot of its texture.
+#define GPU_DEFAULT_TEXTURE_SLOTS_VERTEX_SHADER_SOURCE \
+"#version 130\n\
+\
+in vec2 gpu_Vertex;\n\
+in vec2 gpu_TexCoord;\n\
+in vec4 gpu_Color;\n\
+in float gpu_TextureSlot;\n\
+uniform mat4 gpu_ModelViewProjectionMatrix;\n\
+\
+out vec4 color;\n\
+out vec2 texCoord;\n\
+flat out float textureSlot;\n\
+\
+void main(void)\n\
+{\n\
+	color = gpu_Color;\n\
+	texCoord = vec2(gpu_TexCoord);\n\
+	textureSlot = gpu_TextureSlot;\n\
+	gl_Position = gpu_ModelViewProjectionMatrix * vec4(gpu_Vertex, 0.0, 1.0);\n\
+}"
+
+// Sampler arrays may only be indexed by constants here, so each slot gets a branch.  Gradients are taken before branching.
+#define GPU_DEFAULT_TEXTURE_SLOTS_FRAGMENT_SHADER_SOURCE \
+"#version 130\n\
+\
+in vec4 color;\n\
+in vec2 texCoord;\n\
+flat in float textureSlot;\n\
+\
+uniform sampler2D gpu_TextureSlots[8];\n\
+\
+void main(void)\n\
+{\n\
+    vec2 dx = dFdx(texCoord);\n\
+    vec2 dy = dFdy(texCoord);\n\
+    int slot = int(textureSlot);\n\
+    vec4 texel;\n\
+    if(slot == 0) texel = textureGrad(gpu_TextureSlots[0], texCoord, dx, dy);\n\
+    else if(slot == 1) texel = textureGrad(gpu_TextureSlots[1], texCoord, dx, dy);\n\
+    else if(slot == 2) texel = textureGrad(gpu_TextureSlots[2], texCoord, dx, dy);\n\
+    else if(slot == 3) texel = textureGrad(gpu_TextureSlots[3], texCoord, dx, dy);\n\
+    else if(slot == 4) texel = textureGrad(gpu_TextureSlots[4], texCoord, dx, dy);\n\
+    else if(slot == 5) texel = textureGrad(gpu_TextureSlots[5], texCoord, dx, dy);\n\
+    else if(slot == 6) texel = textureGrad(gpu_TextureSlots[6], texCoord, dx, dy);\n\
+    else texel = textureGrad(gpu_TextureSlots[7], texCoord, dx, dy);\n\
+    gl_FragColor = texel * color;\n\
+}"
+
+
+
+
 // OpenGL 3.2 and 3.3 need newer shaders in case a core profile is used
 
 #define GPU_DEFAULT_TEXTURED_VERTEX_SHADER_SOURCE_CORE \
@@ -154,6 +265,159 @@ void main(void)\n\
     fragColor = color;\n\
 }"
 
+#define GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE_CORE \
+"#version 150\n\
+\
+in vec4 gpu_InstanceCorners;\n\
+in vec3 gpu_InstanceTransform;\n\
+in vec4 gpu_InstanceTexCoords;\n\
+in vec4 gpu_InstanceColor;\n\
+in float gpu_InstanceTextureSlot;\n\
+uniform mat4 gpu_ModelViewProjectionMatrix;\n\
+\
+out vec4 color;\n\
+out vec2 texCoord;\n\
+flat out float textureSlot;\n\
+\
+void main(void)\n\
+{\n\
+	vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n\
+	vec2 pos = mix(gpu_InstanceCorners.xy, gpu_InstanceCorners.zw, corner);\n\
+	float cosA = cos(gpu_InstanceTransform.z);\n\
+	float sinA = sin(gpu_InstanceTransform.z);\n\
+	pos = vec2(pos.x*cosA - pos.y*sinA, pos.x*sinA + pos.y*cosA) + gpu_InstanceTransform.xy;\n\
+	color = gpu_InstanceColor;\n\
+	texCoord = mix(gpu_InstanceTexCoords.xy, gpu_InstanceTexCoords.zw, corner);\n\
+	textureSlot = gpu_InstanceTextureSlot;\n\
+	gl_Position = gpu_ModelViewProjectionMatrix * vec4(pos, 0.0, 1.0);\n\
+}"
+
+#define GPU_DEFAULT_TEXTURE_SLOTS_VERTEX_SHADER_SOURCE_CORE \
+"#version 150\n\
+\
+in vec2 gpu_Vertex;\n\
+in vec2 gpu_TexCoord;\n\
+in vec4 gpu_Color;\n\
+in float gpu_TextureSlot;\n\
+uniform mat4 gpu_ModelViewProjectionMatrix;\n\
+\
+out vec4 color;\n\
+out vec2 texCoord;\n\
+flat out float textureSlot;\n\
+\
+void main(void)\n\
+{\n\
+	color = gpu_Color;\n\
+	texCoord = vec2(gpu_TexCoord);\n\
+	textureSlot = gpu_TextureSlot;\n\
+	gl_Position = gpu_ModelViewProjectionMatrix * vec4(gpu_Vertex, 0.0, 1.0);\n\
+}"
+
+#define GPU_DEFAULT_TEXTURE_SLOTS_FRAGMENT_SHADER_SOURCE_CORE \
+"#version 150\n\
+\
+in vec4 color;\n\
+in vec2 texCoord;\n\
+flat in float textureSlot;\n\
+\
+uniform sampler2D gpu_TextureSlots[8];\n\
+\
+out vec4 fragColor;\n\
+\
+void main(void)\n\
+{\n\
+    vec2 dx = dFdx(texCoord);\n\
+    vec2 dy = dFdy(texCoord);\n\
+    int slot = int(textureSlot);\n\
+    vec4 texel;\n\
+    if(slot == 0) texel = textureGrad(gpu_TextureSlots[0], texCoord, dx, dy);\n\
+    else if(slot == 1) texel = textureGrad(gpu_TextureSlots[1], texCoord, dx, dy);\n\
+    else if(slot == 2) texel = textureGrad(gpu_TextureSlots[2], texCoord, dx, dy);\n\
+    else if(slot == 3) texel = textureGrad(gpu_TextureSlots[3], texCoord, dx, dy);\n\
+    else if(slot == 4) texel = textureGrad(gpu_TextureSlots[4], texCoord, dx, dy);\n\
+    else if(slot == 5) texel = textureGrad(gpu_TextureSlots[5], texCoord, dx, dy);\n\
+    else if(slot == 6) texel = textureGrad(gpu_TextureSlots[6], texCoord, dx, dy);\n\
+    else texel = textureGrad(gpu_TextureSlots[7], texCoord, dx, dy);\n\
+    fragColor = texel * color;\n\
+}"
+
+
+// Last value set for a uniform of a program, so setting it again can be skipped
+typedef struct UniformData_OpenGL_3
+{
+	Uint32 program;
+	int location;
+	int type;  // Which glUniform*() call commits it
+	int num_elements;  // Per value, or rows for matrices
+	int num_columns;
+	int num_values;
+	Uint8 transpose;
+	Uint8 is_dirty;  // Not sent to GL yet
+	int size;
+	void* values;
+} UniformData_OpenGL_3;
+
+// Vertex array state that is remembered while the vertex array isn't bound
+typedef struct VertexArrayData_OpenGL_3
+{
+	Uint32 handle;
+	Uint32 element_array_buffer;
+	Uint32 enabled_attributes;
+	Uint32 known_attributes;
+	Uint32 maybe_enabled_attributes;
+} VertexArrayData_OpenGL_3;
+
+// A buffer that is streamed into one fence-guarded region at a time, so writes neither reallocate it nor wait for the GPU
+typedef struct RingBufferData_OpenGL_3
+{
+	unsigned int VBO;  // 0 when the ring isn't available
+	Uint32 target;  // GL_ARRAY_BUFFER or GL_PIXEL_UNPACK_BUFFER
+	Uint8* mapping;  // Persistent mapping of the whole ring, NULL when each write maps its own range
+	unsigned int region_size;  // Bytes per region
+	unsigned int region;  // Region currently being written
+	unsigned int offset;  // Write position within the current region
+	void* fences[GPU_BLIT_RING_NUM_REGIONS];  // GLsync objects guarding each region
+} RingBufferData_OpenGL_3;
+
+// Custom attribute pointer that a cached vertex array was last set up with
+typedef struct VertexAttributeData_OpenGL_3
+{
+	int location;  // -1 when not set up
+	int num_elems_per_value;
+	Uint32 type;
+	Uint8 normalize;
+	int stride_bytes;
+	Uint32 buffer;
+	unsigned int offset_bytes;  // Within buffer
+} VertexAttributeData_OpenGL_3;
+
+// A vertex array that already points at the blit buffer with one shader block's attribute locations, so a flush only has to bind it
+typedef struct VertexFormatData_OpenGL_3
+{
+	Uint32 VAO;
+	Uint32 VBO;  // Blit buffer that the attributes point into, 0 for an unused entry
+	int position_loc;
+	int texcoord_loc;  // -1 when the format has no tex coords
+	int color_loc;
+	int texture_slot_loc;  // -1 when the format has no texture slots
+	unsigned int floats_per_vertex;
+	unsigned int color_offset;
+	unsigned int texture_slot_offset;
+	Uint8 packed_tex_coords;
+	Uint8 packed_colors;
+	unsigned int vertex_offset;  // Byte offset of the vertices that the attributes were pointed at
+	VertexAttributeData_OpenGL_3 attributes[16];  // Custom attributes, indexed like shader_attributes
+} VertexFormatData_OpenGL_3;
+
+// A texture of a freed image, kept for the next image that needs the same storage
+typedef struct PooledTextureData_OpenGL_3
+{
+	Uint32 handle;
+	Uint16 w, h;
+	Uint32 format;
+	Uint8 immutable;
+	Uint64 bytes;  // Counted in GPU_MemoryStats::pool_bytes
+} PooledTextureData_OpenGL_3;
 
 typedef struct ContextData_OpenGL_3
 {
@@ -165,26 +429,142 @@ typedef struct ContextData_OpenGL_3
 	GPU_Rect last_viewport;
 	GPU_Camera last_camera;
 	Uint8 last_camera_inverted;
+	GPU_Target* last_camera_target;  // The matrices hold this target's camera until the values below change
+	Uint16 last_camera_w, last_camera_h;
+	int last_camera_coordinate_mode;
+	unsigned int last_camera_projection_version;  // Matrix stack versions right after the camera was applied
+	unsigned int last_camera_modelview_version;
+	
+	float mvp[16];  // Model-view-projection matrix, rebuilt only when the matrix stack versions change
+	Uint8 mvp_is_valid;
+	unsigned int mvp_projection_version;
+	unsigned int mvp_modelview_version;
+	Uint32 bound_shader_program;  // Program that glUseProgram() was last called with
+	Uint32 mvp_cache_programs[GPU_MVP_CACHE_SIZE];  // Programs whose MVP uniform already holds the matching matrix
+	float mvp_cache_matrices[GPU_MVP_CACHE_SIZE][16];
+	int mvp_cache_next;  // Entry to replace next
+	
+	UniformData_OpenGL_3* uniforms;  // Shadowed uniform values of all programs
+	int num_uniforms;
+	int uniforms_storage_size;
+	Uint8 has_dirty_uniforms;
 	
 	GPU_Image* last_image;
 	GPU_Target* last_target;
 	float* blit_buffer;  // Holds sets of 4 vertices, each with interleaved position, tex coords, and colors (e.g. [x0, y0, z0, s0, t0, r0, g0, b0, a0, ...]).
-	unsigned short blit_buffer_num_vertices;
-	unsigned short blit_buffer_max_num_vertices;
-	unsigned short* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad)
+	unsigned int blit_buffer_num_vertices;
+	unsigned int blit_buffer_max_num_vertices;
+	unsigned int blit_buffer_vertex_limit;  // Most vertices a batch can grow to before it has to be flushed
+	unsigned int blit_buffer_floats_per_vertex;  // Vertex size in 4-byte units (8 for the default all-float layout)
+	unsigned int blit_buffer_color_offset;  // In 4-byte units from the start of a vertex
+	Uint8 packed_tex_coords;  // Tex coords are stored as normalized unsigned shorts instead of floats
+	Uint8 packed_colors;  // Colors are stored as normalized unsigned bytes instead of floats
+	void* index_buffer;  // Indexes into the blit buffer so we can use 4 vertices for every 2 triangles (1 quad).  Holds unsigned shorts or unsigned ints, depending on index_type.
+	unsigned int index_type;  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
 	unsigned int index_buffer_num_vertices;
 	unsigned int index_buffer_max_num_vertices;
+	void* quad_index_buffer;  // Pre-built indices for a blit buffer full of sprites (0, 1, 2, 0, 2, 3, 4, 5, 6, ...), in index_type format
+	unsigned int quad_index_buffer_num_indices;
+	Uint8 blit_buffer_uses_index_buffer;  // Triangles were batched with the sprites, so the batch is drawn with index_buffer instead of quad_index_buffer
+	GPU_Image* white_texel;  // 1x1 white image that filled shapes sample to join sprite batches (GPU_INIT_BATCH_SHAPES_WITH_SPRITES)
+	Uint8 shapes_use_white_texel;  // The current shapes are going into the sprite batch
+	
+	Uint8 batch_mode;  // GPU_BATCH_MODE_IMMEDIATE or GPU_BATCH_MODE_SORTED
+	int batch_layer;  // Layer given to blits recorded from now on
+	Uint8 use_culling;  // Blits and shapes that can't reach the visible part of their target are dropped (GPU_SetCulling())
+	struct GPU_SortedBlit* sorted_blit_buffer;  // Blits recorded in GPU_BATCH_MODE_SORTED, drawn in sorted order on the next flush
+	unsigned int sorted_blit_buffer_num_blits;
+	unsigned int sorted_blit_buffer_max_num_blits;
+	unsigned int sorted_blit_segment;  // Bumped whenever the recorded target changes, so sorting never moves a blit across a target change
+	GPU_Target* sorted_blit_last_target;
+	Uint8 submitting_sorted_blits;
+	void* sorted_blit_images[GPU_SORTED_BLIT_TRACKED_IMAGES];  // Data of the images and targets that the recorded blits use, which aliases share.  A count past the end means any of them might be used.
+	unsigned int sorted_blit_num_images;
+	void* sorted_blit_targets[GPU_SORTED_BLIT_TRACKED_TARGETS];
+	unsigned int sorted_blit_num_targets;
+	
+	PooledTextureData_OpenGL_3 texture_pool[GPU_TEXTURE_POOL_SIZE];  // Oldest first
+	int texture_pool_size;
+	Uint8 use_texture_storage;  // glTexStorage2D() is available
+	Uint8 use_clear_texture;  // glClearTexImage() is available
+	unsigned char* zero_buffer;  // Zeros for clearing textures without glClearTexImage()
+	unsigned int zero_buffer_size;
+	
+	// GPU_LockImageBytes() hands out memory for one image at a time
+	GPU_Image* locked_image;  // NULL when nothing is locked
+	GPU_Rect locked_rect;
+	unsigned char* locked_bytes;  // Mapped from upload_ring or else staging_buffer
+	unsigned char* staging_buffer;  // Client memory for locks when pixel buffers can't be streamed
+	unsigned int staging_buffer_size;
+	RingBufferData_OpenGL_3 upload_ring;  // Pixel unpack buffer that locked pixels are written into, so the texture upload doesn't stall
+	
+	// Shadow of the GL state, used to skip calls that would not change anything.  GPU_GL_STATE_UNKNOWN (or a negative width) means the next call goes through.
+	Uint32 gl_active_texture_unit;
+	Uint32 gl_textures[GPU_SHADOWED_TEXTURE_UNITS];
+	Uint32 gl_framebuffer;
+	Uint32 gl_vertex_array;
+	Uint32 gl_array_buffer;
+	Uint32 gl_element_array_buffer;  // Part of the vertex array state
+	Uint32 gl_scissor_test;
+	int gl_scissor[4];
+	int gl_viewport[4];
+	Uint32 gl_blend_func[4];  // Source color, dest color, source alpha, dest alpha
+	Uint32 gl_blend_equation[2];  // Color, alpha
+	Uint32 gl_enabled_attributes;  // Vertex attribute arrays that are enabled, valid for the bits in gl_known_attributes
+	Uint32 gl_known_attributes;
+	Uint32 gl_maybe_enabled_attributes;  // Vertex attribute arrays that are not certainly disabled
+	Uint32 gl_all_attributes;  // One bit for each vertex attribute location that GL has
+	Uint32 gl_used_attributes;  // Vertex attribute arrays enabled for the draw call being set up
+	VertexArrayData_OpenGL_3 gl_vertex_arrays[GPU_SHADOWED_VERTEX_ARRAYS];  // State kept for vertex arrays that aren't bound
+	
+	#ifndef SDL_GPU_DISABLE_FRAME_STATS
+	GPU_FrameStats frame_stats;
+	Uint8 flush_cause;  // GPU_FlushCauseEnum counted by the next flush
+	#endif
 	
     // Tier 3 rendering
     unsigned int blit_VAO;
     unsigned int blit_VBO[2];  // For double-buffering
     unsigned int blit_IBO;
+    unsigned int blit_quad_IBO;  // Immutable copy of quad_index_buffer for sprite-only flushes
     Uint8 blit_VBO_flop;
+
+    // Streaming ring buffer for the blit buffer (replaces blit_VBO when available)
+    RingBufferData_OpenGL_3 blit_ring;
+
+    // Flushes draw with a cached vertex array for each shader block and blit buffer layout instead of setting up blit_VAO every time
+    VertexFormatData_OpenGL_3 vertex_formats[GPU_VERTEX_FORMAT_CACHE_SIZE];
+    int vertex_formats_next;  // Entry to replace next
+    Uint8 use_base_vertex;  // glDrawElementsBaseVertex() is available, so the attributes don't have to follow the vertices around the ring
+
+    // Instanced sprite rendering (GL 3.3+), used for sprite batches with the default textured shader
+    Uint8 use_instancing;
+    Uint32 instanced_shader_program;
+    int instanced_modelViewProjection_loc;
+    unsigned int instance_VAO;
+    unsigned int instance_VBO;
+    float* instance_buffer;  // Holds one record per sprite (see GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE)
+    unsigned int instance_buffer_num_instances;
+    unsigned int instance_buffer_max_num_instances;
+
+    // Texture slots let one sprite batch sample from up to GPU_MAX_TEXTURE_SLOTS textures
+    Uint8 use_texture_slots;
+    Uint32 texture_slots_shader_program;
+    GPU_ShaderBlock texture_slots_shader_block;
+    int texture_slot_loc;  // Location of gpu_TextureSlot
+    GPU_Image* texture_slots[GPU_MAX_TEXTURE_SLOTS];  // Image bound to each texture unit, starting from 0.  Slot 0 is always last_image.
+    unsigned int num_texture_slots_used;
+    unsigned int current_texture_slot;  // Slot written into new vertices
+    unsigned int blit_buffer_texture_slot_offset;  // In 4-byte units from the start of a vertex
+    Uint8 blit_buffer_uses_texture_slots;  // Some vertex in the blit buffer samples from a slot other than 0
+    Uint32 shader_image_units;  // Bit per texture unit holding an image from GPU_SetShaderImage(), which slots must not reuse
+
     GPU_ShaderBlock shader_block[2];
     GPU_ShaderBlock current_shader_block;
     
 	GPU_AttributeSource shader_attributes[16];
 	unsigned int attribute_VBO[16];
+	RingBufferData_OpenGL_3 attribute_ring;  // Holds the custom attribute data of each flush (replaces attribute_VBO when available)
 } ContextData_OpenGL_3;
 
 typedef struct ImageData_OpenGL_3
@@ -193,6 +573,18 @@ typedef struct ImageData_OpenGL_3
     Uint8 owns_handle;
 	Uint32 handle;
 	Uint32 format;
+	Uint8 poolable;  // The texture is a single level of texture_w x texture_h, so another image can reuse it
+	Uint8 immutable;  // Storage is from glTexStorage2D(), so it can't be respecified
+	
+	// Texture memory accounting (see GPU_GetMemoryStats())
+	GPU_Image* owner;  // Image that evicts and restores the texture, NULL once an alias has outlived it
+	Uint64 memory_bytes;  // 0 when the texture isn't counted
+	Uint64 padding_bytes;  // Part of memory_bytes that only pads the image out to a power of two
+	Uint8 memory_is_target;  // Counted as render target memory
+	unsigned char* evicted_pixels;  // Copy of the texture while it is evicted to stay within the memory budget, NULL while resident
+	struct ImageData_OpenGL_3* lru_prev;  // Counted textures are listed from least to most recently bound
+	struct ImageData_OpenGL_3* lru_next;
+	GPU_Context* memory_context;  // Context that made the counted texture, the only one that may read it back and delete it
 } ImageData_OpenGL_3;
 
 typedef struct TargetData_OpenGL_3
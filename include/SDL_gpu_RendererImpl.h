@@ -67,6 +67,9 @@ typedef struct GPU_RendererImpl
     /*! \see GPU_CreateAliasImage() */
 	GPU_Image* (SDLCALL *CreateAliasImage)(GPU_Renderer* renderer, GPU_Image* image);
 	
+	/*! \see GPU_CreateImageFromCompressedData() */
+	GPU_Image* (SDLCALL *CreateImageFromCompressedData)(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format, int num_levels, const unsigned char* const* level_data);
+	
 	/*! \see GPU_SaveImage() */
 	Uint8 (SDLCALL *SaveImage)(GPU_Renderer* renderer, GPU_Image* image, const char* filename, GPU_FileFormatEnum format);
 	
@@ -79,6 +82,15 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_UpdateImageBytes */
 	void (SDLCALL *UpdateImageBytes)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
 	
+	/*! \see GPU_LockImageBytes() */
+	unsigned char* (SDLCALL *LockImageBytes)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, int* bytes_per_row);
+	
+	/*! \see GPU_UnlockImageBytes() */
+	void (SDLCALL *UnlockImageBytes)(GPU_Renderer* renderer, GPU_Image* image);
+	
+	/*! \see GPU_UpdateImageBytesAsync() */
+	void (SDLCALL *UpdateImageBytesAsync)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
+	
 	/*! \see GPU_CopyImageFromSurface() */
 	GPU_Image* (SDLCALL *CopyImageFromSurface)(GPU_Renderer* renderer, SDL_Surface* surface);
 	
@@ -94,6 +106,15 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_FreeImage() */
 	void (SDLCALL *FreeImage)(GPU_Renderer* renderer, GPU_Image* image);
 	
+	/*! \see GPU_GetImageMemoryUsage() */
+	Uint64 (SDLCALL *GetImageMemoryUsage)(GPU_Renderer* renderer, GPU_Image* image);
+	
+	/*! \see GPU_GetMemoryStats() */
+	GPU_MemoryStats (SDLCALL *GetMemoryStats)(GPU_Renderer* renderer);
+	
+	/*! \see GPU_SetMemoryBudget() */
+	void (SDLCALL *SetMemoryBudget)(GPU_Renderer* renderer, Uint64 bytes);
+	
 	/*! \see GPU_LoadTarget() */
 	GPU_Target* (SDLCALL *LoadTarget)(GPU_Renderer* renderer, GPU_Image* image);
 	
@@ -115,9 +136,29 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_BlitTransformX() */
 	void (SDLCALL *BlitTransformX)(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY);
 	
+	/*! \see GPU_BlitBatch()
+	 * \see GPU_BlitBatchSeparate()
+	 * floats_per_sprite is the stride of interleaved data, or 0 when each array is tightly packed. */
+	void (SDLCALL *BlitBatch)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* rotations, float* scales, float* colors, unsigned int floats_per_sprite, GPU_BlitFlagEnum flags);
+	
 	/*! \see GPU_TriangleBatch() */
 	void (SDLCALL *TriangleBatch)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned short num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags);
 	
+	/*! \see GPU_CreateVertexBuffer() */
+	GPU_VertexBuffer* (SDLCALL *CreateVertexBuffer)(GPU_Renderer* renderer, unsigned int num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags);
+	
+	/*! \see GPU_UpdateVertexBuffer() */
+	void (SDLCALL *UpdateVertexBuffer)(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, float* values);
+	
+	/*! \see GPU_UpdateVertexBufferIndices() */
+	void (SDLCALL *UpdateVertexBufferIndices)(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_index, unsigned int num_indices, unsigned short* indices);
+	
+	/*! \see GPU_DrawVertexBuffer() */
+	void (SDLCALL *DrawVertexBuffer)(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer);
+	
+	/*! \see GPU_FreeVertexBuffer() */
+	void (SDLCALL *FreeVertexBuffer)(GPU_Renderer* renderer, GPU_VertexBuffer* buffer);
+	
 	/*! \see GPU_GenerateMipmaps() */
 	void (SDLCALL *GenerateMipmaps)(GPU_Renderer* renderer, GPU_Image* image);
 
@@ -140,6 +181,26 @@ typedef struct GPU_RendererImpl
 	void (SDLCALL *ClearRGBA)(GPU_Renderer* renderer, GPU_Target* target, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 	/*! \see GPU_FlushBlitBuffer() */
 	void (SDLCALL *FlushBlitBuffer)(GPU_Renderer* renderer);
+	/*! \see GPU_GetIndexType() */
+	GPU_TypeEnum (SDLCALL *GetIndexType)(GPU_Renderer* renderer);
+	/*! \see GPU_GetNativeVertexLayout() */
+	GPU_NativeVertexLayout (SDLCALL *GetNativeVertexLayout)(GPU_Renderer* renderer);
+	/*! \see GPU_SetBatchMode() */
+	void (SDLCALL *SetBatchMode)(GPU_Renderer* renderer, GPU_BatchModeEnum mode);
+	/*! \see GPU_GetBatchMode() */
+	GPU_BatchModeEnum (SDLCALL *GetBatchMode)(GPU_Renderer* renderer);
+	/*! \see GPU_SetBatchLayer() */
+	void (SDLCALL *SetBatchLayer)(GPU_Renderer* renderer, int layer);
+	/*! \see GPU_GetBatchLayer() */
+	int (SDLCALL *GetBatchLayer)(GPU_Renderer* renderer);
+	/*! \see GPU_SetCulling() */
+	void (SDLCALL *SetCulling)(GPU_Renderer* renderer, Uint8 enable);
+	/*! \see GPU_GetCulling() */
+	Uint8 (SDLCALL *GetCulling)(GPU_Renderer* renderer);
+	/*! \see GPU_GetFrameStats() */
+	GPU_FrameStats (SDLCALL *GetFrameStats)(GPU_Renderer* renderer);
+	/*! \see GPU_ResetFrameStats() */
+	void (SDLCALL *ResetFrameStats)(GPU_Renderer* renderer);
 	/*! \see GPU_Flip() */
 	void (SDLCALL *Flip)(GPU_Renderer* renderer, GPU_Target* target);
 	
@@ -66,6 +66,7 @@ static Uint32 _gpu_init_windowID = 0;
 
 static GPU_InitFlagEnum _gpu_preinit_flags = GPU_DEFAULT_INIT_FLAGS;
 static GPU_InitFlagEnum _gpu_required_features = 0;
+static unsigned int _gpu_max_batch_vertices = 0;
 
 static Uint8 _gpu_initialized_SDL_core = 0;
 static Uint8 _gpu_initialized_SDL = 0;
@@ -237,6 +238,16 @@ GPU_FeatureEnum GPU_GetRequiredFeatures(void)
     return _gpu_required_features;
 }
 
+void GPU_SetMaxBatchVertices(unsigned int max_vertices)
+{
+    _gpu_max_batch_vertices = max_vertices;
+}
+
+unsigned int GPU_GetMaxBatchVertices(void)
+{
+    return _gpu_max_batch_vertices;
+}
+
 static void gpu_init_error_queue(void)
 {
     if(_gpu_error_code_queue == NULL)
@@ -894,6 +905,14 @@ GPU_Image* GPU_LoadImage(const char* filename)
 	return _gpu_current_renderer->impl->LoadImage(_gpu_current_renderer, filename);
 }
 
+GPU_Image* GPU_CreateImageFromCompressedData(Uint16 w, Uint16 h, GPU_FormatEnum format, int num_levels, const unsigned char* const* level_data)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return NULL;
+	
+	return _gpu_current_renderer->impl->CreateImageFromCompressedData(_gpu_current_renderer, w, h, format, num_levels, level_data);
+}
+
 GPU_Image* GPU_CreateAliasImage(GPU_Image* image)
 {
 	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
@@ -934,6 +953,30 @@ void GPU_UpdateImageBytes(GPU_Image* image, const GPU_Rect* image_rect, const un
 	_gpu_current_renderer->impl->UpdateImageBytes(_gpu_current_renderer, image, image_rect, bytes, bytes_per_row);
 }
 
+void GPU_UpdateImageBytesAsync(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->UpdateImageBytesAsync(_gpu_current_renderer, image, image_rect, bytes, bytes_per_row);
+}
+
+unsigned char* GPU_LockImageBytes(GPU_Image* image, const GPU_Rect* image_rect, int* bytes_per_row)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return NULL;
+	
+	return _gpu_current_renderer->impl->LockImageBytes(_gpu_current_renderer, image, image_rect, bytes_per_row);
+}
+
+void GPU_UnlockImageBytes(GPU_Image* image)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->UnlockImageBytes(_gpu_current_renderer, image);
+}
+
 SDL_Surface* GPU_LoadSurface(const char* filename)
 {
 	int width, height, channels;
@@ -1147,6 +1190,39 @@ void GPU_FreeImage(GPU_Image* image)
 	_gpu_current_renderer->impl->FreeImage(_gpu_current_renderer, image);
 }
 
+Uint64 GPU_GetImageMemoryUsage(GPU_Image* image)
+{
+	if(image == NULL || _gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return 0;
+	
+	return _gpu_current_renderer->impl->GetImageMemoryUsage(_gpu_current_renderer, image);
+}
+
+GPU_MemoryStats GPU_GetMemoryStats(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+	{
+		GPU_MemoryStats stats;
+		memset(&stats, 0, sizeof(GPU_MemoryStats));
+		return stats;
+	}
+	
+	return _gpu_current_renderer->impl->GetMemoryStats(_gpu_current_renderer);
+}
+
+void GPU_SetMemoryBudget(Uint64 bytes)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->SetMemoryBudget(_gpu_current_renderer, bytes);
+}
+
+Uint64 GPU_GetMemoryBudget(void)
+{
+	return GPU_GetMemoryStats().budget_bytes;
+}
+
 
 GPU_Target* GPU_GetContextTarget(void)
 {
@@ -1276,6 +1352,159 @@ void GPU_TriangleBatch(GPU_Image* image, GPU_Target* target, unsigned short num_
     _gpu_current_renderer->impl->TriangleBatch(_gpu_current_renderer, image, target, num_vertices, values, num_indices, indices, flags);
 }
 
+void GPU_BlitBatch(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* values, GPU_BlitFlagEnum flags)
+{
+    float* positions = NULL;
+    float* src_rects = NULL;
+    float* rotations = NULL;
+    float* scales = NULL;
+    float* colors = NULL;
+    unsigned int floats_per_sprite = 0;
+    
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    
+	if(image == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
+	if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    
+    if(num_sprites == 0)
+        return;
+    
+    // Find where each kind of data sits within an interleaved sprite
+    if(values != NULL)
+    {
+        if(!(flags & GPU_USE_DEFAULT_POSITIONS))
+        {
+            positions = values + floats_per_sprite;
+            floats_per_sprite += ((flags & GPU_PASSTHROUGH_VERTICES)? 8 : 2);
+        }
+        if(!(flags & GPU_USE_DEFAULT_SRC_RECTS))
+        {
+            src_rects = values + floats_per_sprite;
+            floats_per_sprite += ((flags & GPU_PASSTHROUGH_TEXCOORDS)? 8 : 4);
+        }
+        if(flags & GPU_USE_ROTATIONS)
+        {
+            rotations = values + floats_per_sprite;
+            floats_per_sprite += 1;
+        }
+        if(flags & GPU_USE_SCALES)
+        {
+            scales = values + floats_per_sprite;
+            floats_per_sprite += 2;
+        }
+        if(!(flags & GPU_USE_DEFAULT_COLORS))
+        {
+            colors = values + floats_per_sprite;
+            floats_per_sprite += ((flags & GPU_PASSTHROUGH_COLORS)? 16 : 4);
+        }
+    }
+    
+    _gpu_current_renderer->impl->BlitBatch(_gpu_current_renderer, image, target, num_sprites, positions, src_rects, rotations, scales, colors, floats_per_sprite, flags);
+}
+
+void GPU_BlitBatchSeparate(GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* rotations, float* scales, float* colors, GPU_BlitFlagEnum flags)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    
+	if(image == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
+	if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    
+    if(num_sprites == 0)
+        return;
+    
+    if(flags & GPU_USE_DEFAULT_POSITIONS)
+        positions = NULL;
+    if(flags & GPU_USE_DEFAULT_SRC_RECTS)
+        src_rects = NULL;
+    if(flags & GPU_USE_DEFAULT_COLORS)
+        colors = NULL;
+    
+    _gpu_current_renderer->impl->BlitBatch(_gpu_current_renderer, image, target, num_sprites, positions, src_rects, rotations, scales, colors, 0, flags);
+}
+
+GPU_VertexBuffer* GPU_CreateVertexBuffer(unsigned int num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return NULL;
+	
+	return _gpu_current_renderer->impl->CreateVertexBuffer(_gpu_current_renderer, num_vertices, values, num_indices, indices, flags);
+}
+
+void GPU_UpdateVertexBuffer(GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, float* values)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    
+	if(buffer == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "buffer");
+	if(values == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "values");
+    
+    if(num_vertices == 0)
+        return;
+    
+    _gpu_current_renderer->impl->UpdateVertexBuffer(_gpu_current_renderer, buffer, first_vertex, num_vertices, values);
+}
+
+void GPU_UpdateVertexBufferIndices(GPU_VertexBuffer* buffer, unsigned int first_index, unsigned int num_indices, unsigned short* indices)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    
+	if(buffer == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "buffer");
+	if(indices == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "indices");
+    
+    if(num_indices == 0)
+        return;
+    
+    _gpu_current_renderer->impl->UpdateVertexBufferIndices(_gpu_current_renderer, buffer, first_index, num_indices, indices);
+}
+
+void GPU_DrawVertexBuffer(GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer)
+{
+    if(!CHECK_RENDERER)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    MAKE_CURRENT_IF_NONE(target);
+    if(!CHECK_CONTEXT)
+        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    
+	if(target == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+	if(buffer == NULL)
+        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "buffer");
+    
+    if(buffer->num_vertices == 0)
+        return;
+    
+    _gpu_current_renderer->impl->DrawVertexBuffer(_gpu_current_renderer, image, target, buffer);
+}
+
+void GPU_FreeVertexBuffer(GPU_VertexBuffer* buffer)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->FreeVertexBuffer(_gpu_current_renderer, buffer);
+}
+
 
 
 
@@ -1695,6 +1924,95 @@ void GPU_FlushBlitBuffer(void)
 	_gpu_current_renderer->impl->FlushBlitBuffer(_gpu_current_renderer);
 }
 
+GPU_TypeEnum GPU_GetIndexType(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return GPU_TYPE_UNSIGNED_SHORT;
+	
+	return _gpu_current_renderer->impl->GetIndexType(_gpu_current_renderer);
+}
+
+GPU_NativeVertexLayout GPU_GetNativeVertexLayout(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+	{
+		GPU_NativeVertexLayout layout;
+		memset(&layout, 0, sizeof(GPU_NativeVertexLayout));
+		layout.texture_slot_offset = -1;
+		return layout;
+	}
+	
+	return _gpu_current_renderer->impl->GetNativeVertexLayout(_gpu_current_renderer);
+}
+
+void GPU_SetBatchMode(GPU_BatchModeEnum mode)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->SetBatchMode(_gpu_current_renderer, mode);
+}
+
+GPU_BatchModeEnum GPU_GetBatchMode(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return GPU_BATCH_MODE_IMMEDIATE;
+	
+	return _gpu_current_renderer->impl->GetBatchMode(_gpu_current_renderer);
+}
+
+void GPU_SetBatchLayer(int layer)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->SetBatchLayer(_gpu_current_renderer, layer);
+}
+
+int GPU_GetBatchLayer(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return 0;
+	
+	return _gpu_current_renderer->impl->GetBatchLayer(_gpu_current_renderer);
+}
+
+void GPU_SetCulling(Uint8 enable)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->SetCulling(_gpu_current_renderer, enable);
+}
+
+Uint8 GPU_GetCulling(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return 0;
+	
+	return _gpu_current_renderer->impl->GetCulling(_gpu_current_renderer);
+}
+
+GPU_FrameStats GPU_GetFrameStats(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+	{
+		GPU_FrameStats stats;
+		memset(&stats, 0, sizeof(GPU_FrameStats));
+		return stats;
+	}
+	
+	return _gpu_current_renderer->impl->GetFrameStats(_gpu_current_renderer);
+}
+
+void GPU_ResetFrameStats(void)
+{
+	if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+		return;
+	
+	_gpu_current_renderer->impl->ResetFrameStats(_gpu_current_renderer);
+}
+
 void GPU_Flip(GPU_Target* target)
 {
     if(!CHECK_RENDERER)
@@ -0,0 +1,617 @@
+#include "SDL_gpu.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Entries are packed with the skyline bottom-left heuristic.  Each page keeps the top edge of
+// its used area as a list of horizontal segments, and a new entry goes where it leaves that edge lowest.
+
+// Minimum number of pages and entries to allocate room for
+#define GPU_ATLAS_INIT_MAX_PAGES 4
+#define GPU_ATLAS_INIT_MAX_ENTRIES 64
+
+typedef struct AtlasSegment
+{
+    int x, y, w;
+} AtlasSegment;
+
+typedef struct AtlasPage
+{
+    AtlasSegment* skyline;  // Sorted by x and covering the whole page width
+    int num_segments;
+    int num_entries;
+} AtlasPage;
+
+typedef struct AtlasEntry
+{
+    GPU_Image* image;
+    int page;
+    int x, y;  // Corner of the cell, which includes the extrusion and padding
+    int w, h;  // Size of the image itself
+} AtlasEntry;
+
+typedef struct AtlasData
+{
+    AtlasPage* pages;  // Parallel to GPU_Atlas::pages
+    int max_pages;
+    AtlasEntry* entries;
+    int num_entries;
+    int max_entries;
+} AtlasData;
+
+
+static void resetPage(GPU_Atlas* atlas, AtlasPage* page)
+{
+    // Padding is only added to the right and bottom of each cell, so it can hang off the page edge
+    page->skyline[0].x = 0;
+    page->skyline[0].y = 0;
+    page->skyline[0].w = atlas->page_w + atlas->padding;
+    page->num_segments = 1;
+    page->num_entries = 0;
+}
+
+static void initPage(GPU_Atlas* atlas, AtlasPage* page)
+{
+    page->skyline = (AtlasSegment*)SDL_malloc(sizeof(AtlasSegment));
+    resetPage(atlas, page);
+}
+
+// Sets the skyline to height y over [x, x + w)
+static void setSkyline(AtlasPage* page, int x, int w, int y)
+{
+    AtlasSegment* result;
+    int num_segments = 0;
+    int i, j;
+
+    // Splitting one segment around the new one adds two
+    result = (AtlasSegment*)SDL_malloc((page->num_segments + 2)*sizeof(AtlasSegment));
+
+    for(i = 0; i < page->num_segments && page->skyline[i].x < x; i++)
+    {
+        result[num_segments] = page->skyline[i];
+        if(result[num_segments].x + result[num_segments].w > x)
+            result[num_segments].w = x - result[num_segments].x;
+        num_segments++;
+    }
+
+    result[num_segments].x = x;
+    result[num_segments].y = y;
+    result[num_segments].w = w;
+    num_segments++;
+
+    for(i = 0; i < page->num_segments; i++)
+    {
+        int end = page->skyline[i].x + page->skyline[i].w;
+        if(end > x + w)
+        {
+            int start = (page->skyline[i].x > x + w? page->skyline[i].x : x + w);
+            result[num_segments].x = start;
+            result[num_segments].y = page->skyline[i].y;
+            result[num_segments].w = end - start;
+            num_segments++;
+        }
+    }
+
+    // Merge neighbors at the same height
+    j = 0;
+    for(i = 1; i < num_segments; i++)
+    {
+        if(result[i].y == result[j].y)
+            result[j].w += result[i].w;
+        else
+            result[++j] = result[i];
+    }
+
+    SDL_free(page->skyline);
+    page->skyline = result;
+    page->num_segments = j + 1;
+}
+
+static Uint8 findPosition(GPU_Atlas* atlas, AtlasPage* page, int cell_w, int cell_h, int* x_result, int* y_result)
+{
+    int max_w = atlas->page_w + atlas->padding;
+    int max_h = atlas->page_h + atlas->padding;
+    int best_bottom = max_h + 1;
+    int best_w = 0;
+    int i, j;
+
+    for(i = 0; i < page->num_segments; i++)
+    {
+        int x = page->skyline[i].x;
+        int y = 0;
+        int covered = 0;
+
+        if(x + cell_w > max_w)
+            break;
+
+        // The cell rests on the highest segment under it
+        for(j = i; covered < cell_w; j++)
+        {
+            if(page->skyline[j].y > y)
+                y = page->skyline[j].y;
+            covered += page->skyline[j].w;
+        }
+
+        if(y + cell_h <= max_h && (y + cell_h < best_bottom || (y + cell_h == best_bottom && page->skyline[i].w < best_w)))
+        {
+            best_bottom = y + cell_h;
+            best_w = page->skyline[i].w;
+            *x_result = x;
+            *y_result = y;
+        }
+    }
+
+    return (best_bottom <= max_h);
+}
+
+// Gives back the cell's space if nothing was packed on top of it
+static void reclaimCell(AtlasPage* page, int x, int y, int cell_w, int cell_h)
+{
+    int i;
+    for(i = 0; i < page->num_segments; i++)
+    {
+        AtlasSegment* segment = &page->skyline[i];
+        if(segment->x < x + cell_w && segment->x + segment->w > x && segment->y != y + cell_h)
+            return;
+    }
+
+    setSkyline(page, x, cell_w, y);
+}
+
+static void reservePages(GPU_Atlas* atlas, int num_pages)
+{
+    AtlasData* data = (AtlasData*)atlas->data;
+    GPU_Image** pages;
+    AtlasPage* page_data;
+    int max_pages;
+
+    if(num_pages <= data->max_pages)
+        return;
+
+    max_pages = (data->max_pages*2 > GPU_ATLAS_INIT_MAX_PAGES? data->max_pages*2 : GPU_ATLAS_INIT_MAX_PAGES);
+    if(max_pages < num_pages)
+        max_pages = num_pages;
+
+    pages = (GPU_Image**)SDL_malloc(max_pages*sizeof(GPU_Image*));
+    page_data = (AtlasPage*)SDL_malloc(max_pages*sizeof(AtlasPage));
+    if(atlas->num_pages > 0)
+    {
+        memcpy(pages, atlas->pages, atlas->num_pages*sizeof(GPU_Image*));
+        memcpy(page_data, data->pages, atlas->num_pages*sizeof(AtlasPage));
+    }
+    SDL_free(atlas->pages);
+    SDL_free(data->pages);
+    atlas->pages = pages;
+    data->pages = page_data;
+    data->max_pages = max_pages;
+}
+
+static int addPage(GPU_Atlas* atlas)
+{
+    AtlasData* data = (AtlasData*)atlas->data;
+    GPU_Image* image = GPU_CreateImage(atlas->page_w, atlas->page_h, GPU_FORMAT_RGBA);
+    if(image == NULL)
+        return -1;
+
+    reservePages(atlas, atlas->num_pages + 1);
+    atlas->pages[atlas->num_pages] = image;
+    initPage(atlas, &data->pages[atlas->num_pages]);
+    return atlas->num_pages++;
+}
+
+static void addEntry(AtlasData* data, AtlasEntry* entry)
+{
+    if(data->num_entries >= data->max_entries)
+    {
+        int max_entries = (data->max_entries == 0? GPU_ATLAS_INIT_MAX_ENTRIES : data->max_entries*2);
+        AtlasEntry* entries = (AtlasEntry*)SDL_malloc(max_entries*sizeof(AtlasEntry));
+        if(data->num_entries > 0)
+            memcpy(entries, data->entries, data->num_entries*sizeof(AtlasEntry));
+        SDL_free(data->entries);
+        data->entries = entries;
+        data->max_entries = max_entries;
+    }
+
+    data->entries[data->num_entries++] = *entry;
+}
+
+// Returns a copy of the surface with R, G, B, A bytes, or the surface itself if it already has them
+static SDL_Surface* getRGBASurface(SDL_Surface* surface)
+{
+    SDL_Surface* format_surface;
+    SDL_Surface* result;
+
+    #if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    format_surface = SDL_CreateRGBSurface(0, 1, 1, 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF);
+    #else
+    format_surface = SDL_CreateRGBSurface(0, 1, 1, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000);
+    #endif
+    if(format_surface == NULL)
+        return NULL;
+
+    if(!SDL_MUSTLOCK(surface) && surface->format->BytesPerPixel == 4 && surface->format->Rmask == format_surface->format->Rmask
+       && surface->format->Gmask == format_surface->format->Gmask && surface->format->Bmask == format_surface->format->Bmask
+       && surface->format->Amask == format_surface->format->Amask)
+        result = surface;
+    else
+        result = SDL_ConvertSurface(surface, format_surface->format, 0);
+
+    SDL_FreeSurface(format_surface);
+    return result;
+}
+
+// Uploads RGBA pixels into the cell at (x, y), repeating the edges outward by the extrusion
+static void uploadCell(GPU_Atlas* atlas, GPU_Image* page, int x, int y, const Uint8* pixels, int pitch, int w, int h)
+{
+    int extrude = atlas->extrude;
+    int cell_w = w + 2*extrude;
+    int cell_h = h + 2*extrude;
+    Uint8* buffer;
+    GPU_Rect rect;
+    int row, i;
+
+    buffer = (Uint8*)SDL_malloc(cell_w*cell_h*4);
+
+    for(row = 0; row < cell_h; row++)
+    {
+        int source_row = row - extrude;
+        const Uint8* source;
+        Uint8* dest = buffer + row*cell_w*4;
+
+        if(source_row < 0)
+            source_row = 0;
+        else if(source_row >= h)
+            source_row = h - 1;
+        source = pixels + source_row*pitch;
+
+        memcpy(dest + extrude*4, source, w*4);
+        for(i = 0; i < extrude; i++)
+        {
+            memcpy(dest + i*4, source, 4);
+            memcpy(dest + (extrude + w + i)*4, source + (w - 1)*4, 4);
+        }
+    }
+
+    rect = GPU_MakeRect(x, y, cell_w, cell_h);
+    GPU_UpdateImageBytes(page, &rect, buffer, cell_w*4);
+    SDL_free(buffer);
+}
+
+static GPU_Image* createEntryImage(GPU_Atlas* atlas, GPU_Image* page, AtlasEntry* entry)
+{
+    GPU_Image* image = GPU_CreateAliasImage(page);
+    if(image == NULL)
+        return NULL;
+
+    // Freeing an alias frees its target too, but that belongs to the page
+    image->target = NULL;
+    image->using_virtual_resolution = 0;
+    image->w = image->base_w = entry->w;
+    image->h = image->base_h = entry->h;
+    image->texture_x = entry->x + atlas->extrude;
+    image->texture_y = entry->y + atlas->extrude;
+    return image;
+}
+
+// Points an entry image at another page's texture.  The image keeps its identity, so it has to stop being the bound texture first.
+static void moveImageToPage(GPU_Image* image, GPU_Image* page)
+{
+    GPU_Image* temp;
+    void* data;
+
+    if(image->data == page->data)
+        return;
+
+    // Freeing an alias of the old texture forgets the binding if it is current
+    temp = GPU_CreateAliasImage(image);
+    temp->target = NULL;
+    GPU_FreeImage(temp);
+
+    // Trade texture references, so freeing this alias releases the old page
+    temp = GPU_CreateAliasImage(page);
+    temp->target = NULL;
+    data = image->data;
+    image->data = temp->data;
+    temp->data = data;
+    GPU_FreeImage(temp);
+}
+
+static int compareEntries(const void* a, const void* b)
+{
+    const AtlasEntry* A = (const AtlasEntry*)a;
+    const AtlasEntry* B = (const AtlasEntry*)b;
+
+    // Tallest first, which packs a skyline the tightest
+    if(A->h != B->h)
+        return (A->h > B->h? -1 : 1);
+    if(A->w != B->w)
+        return (A->w > B->w? -1 : 1);
+    return 0;
+}
+
+
+GPU_Atlas* GPU_CreateAtlas(Uint16 page_w, Uint16 page_h, int padding, int extrude)
+{
+    GPU_Atlas* atlas;
+    AtlasData* data;
+
+    if(page_w == 0 || page_h == 0)
+    {
+        GPU_PushErrorCode("GPU_CreateAtlas", GPU_ERROR_USER_ERROR, "Invalid page size (%dx%d)", page_w, page_h);
+        return NULL;
+    }
+
+    atlas = (GPU_Atlas*)SDL_malloc(sizeof(GPU_Atlas));
+    data = (AtlasData*)SDL_malloc(sizeof(AtlasData));
+    memset(data, 0, sizeof(AtlasData));
+
+    atlas->page_w = page_w;
+    atlas->page_h = page_h;
+    atlas->padding = (padding > 0? padding : 0);
+    atlas->extrude = (extrude > 0? extrude : 0);
+    atlas->num_pages = 0;
+    atlas->pages = NULL;
+    atlas->data = data;
+
+    return atlas;
+}
+
+GPU_Image* GPU_AddToAtlas(GPU_Atlas* atlas, SDL_Surface* surface)
+{
+    AtlasData* data;
+    AtlasEntry entry;
+    SDL_Surface* rgba;
+    int cell_w, cell_h;
+    int i;
+
+    if(atlas == NULL)
+    {
+        GPU_PushErrorCode("GPU_AddToAtlas", GPU_ERROR_NULL_ARGUMENT, "atlas");
+        return NULL;
+    }
+    if(surface == NULL)
+    {
+        GPU_PushErrorCode("GPU_AddToAtlas", GPU_ERROR_NULL_ARGUMENT, "surface");
+        return NULL;
+    }
+    if(surface->w < 1 || surface->h < 1 || surface->w + 2*atlas->extrude > atlas->page_w || surface->h + 2*atlas->extrude > atlas->page_h)
+    {
+        GPU_PushErrorCode("GPU_AddToAtlas", GPU_ERROR_USER_ERROR, "Surface (%dx%d) does not fit on an atlas page (%dx%d)", surface->w, surface->h, atlas->page_w, atlas->page_h);
+        return NULL;
+    }
+
+    data = (AtlasData*)atlas->data;
+    entry.w = surface->w;
+    entry.h = surface->h;
+    cell_w = entry.w + 2*atlas->extrude + atlas->padding;
+    cell_h = entry.h + 2*atlas->extrude + atlas->padding;
+
+    entry.page = -1;
+    for(i = 0; i < atlas->num_pages; i++)
+    {
+        if(findPosition(atlas, &data->pages[i], cell_w, cell_h, &entry.x, &entry.y))
+        {
+            entry.page = i;
+            break;
+        }
+    }
+    if(entry.page < 0)
+    {
+        entry.page = addPage(atlas);
+        if(entry.page < 0)
+        {
+            GPU_PushErrorCode("GPU_AddToAtlas", GPU_ERROR_BACKEND_ERROR, "Failed to create a new page.");
+            return NULL;
+        }
+        findPosition(atlas, &data->pages[entry.page], cell_w, cell_h, &entry.x, &entry.y);
+    }
+
+    rgba = getRGBASurface(surface);
+    if(rgba == NULL)
+    {
+        GPU_PushErrorCode("GPU_AddToAtlas", GPU_ERROR_DATA_ERROR, "Failed to convert surface to RGBA.");
+        return NULL;
+    }
+    uploadCell(atlas, atlas->pages[entry.page], entry.x, entry.y, (const Uint8*)rgba->pixels, rgba->pitch, entry.w, entry.h);
+    if(rgba != surface)
+        SDL_FreeSurface(rgba);
+
+    entry.image = createEntryImage(atlas, atlas->pages[entry.page], &entry);
+    if(entry.image == NULL)
+        return NULL;
+
+    setSkyline(&data->pages[entry.page], entry.x, cell_w, entry.y + cell_h);
+    data->pages[entry.page].num_entries++;
+    addEntry(data, &entry);
+    return entry.image;
+}
+
+void GPU_RemoveFromAtlas(GPU_Atlas* atlas, GPU_Image* image)
+{
+    AtlasData* data;
+    AtlasPage* page;
+    AtlasEntry* entry;
+    int i;
+
+    if(atlas == NULL || image == NULL)
+        return;
+
+    data = (AtlasData*)atlas->data;
+    for(i = 0; i < data->num_entries; i++)
+    {
+        if(data->entries[i].image == image)
+            break;
+    }
+    if(i == data->num_entries)
+    {
+        GPU_PushErrorCode("GPU_RemoveFromAtlas", GPU_ERROR_USER_ERROR, "Image is not in this atlas");
+        return;
+    }
+
+    entry = &data->entries[i];
+    page = &data->pages[entry->page];
+    page->num_entries--;
+    if(page->num_entries == 0)
+        resetPage(atlas, page);
+    else
+        reclaimCell(page, entry->x, entry->y, entry->w + 2*atlas->extrude + atlas->padding, entry->h + 2*atlas->extrude + atlas->padding);
+
+    GPU_FreeImage(image);
+    data->entries[i] = data->entries[--data->num_entries];
+}
+
+Uint8 GPU_DefragmentAtlas(GPU_Atlas* atlas)
+{
+    AtlasData* data;
+    AtlasEntry* old_entries;
+    AtlasPage* layout;
+    GPU_Image** pages;
+    SDL_Surface** surfaces;
+    int old_num_pages;
+    int max_pages;
+    int num_pages;
+    int extrude;
+    Uint8 result;
+    int i, j;
+
+    if(atlas == NULL)
+        return 0;
+
+    data = (AtlasData*)atlas->data;
+    extrude = atlas->extrude;
+    old_num_pages = atlas->num_pages;
+
+    // Draws that are already queued still see the old layout
+    GPU_FlushBlitBuffer();
+
+    surfaces = (SDL_Surface**)SDL_malloc((old_num_pages + 1)*sizeof(SDL_Surface*));
+    for(i = 0; i < old_num_pages; i++)
+    {
+        surfaces[i] = GPU_CopySurfaceFromImage(atlas->pages[i]);
+        if(surfaces[i] == NULL)
+        {
+            for(j = 0; j < i; j++)
+                SDL_FreeSurface(surfaces[j]);
+            SDL_free(surfaces);
+            GPU_PushErrorCode("GPU_DefragmentAtlas", GPU_ERROR_BACKEND_ERROR, "Failed to read back page %d.", i);
+            return 0;
+        }
+    }
+
+    old_entries = (AtlasEntry*)SDL_malloc((data->num_entries + 1)*sizeof(AtlasEntry));
+    if(data->num_entries > 0)
+        memcpy(old_entries, data->entries, data->num_entries*sizeof(AtlasEntry));
+    qsort(old_entries, data->num_entries, sizeof(AtlasEntry), &compareEntries);
+
+    // Lay out every entry before touching any texture, so running out of pages leaves the atlas alone
+    max_pages = old_num_pages + data->num_entries + 1;
+    layout = (AtlasPage*)SDL_malloc(max_pages*sizeof(AtlasPage));
+    pages = (GPU_Image**)SDL_malloc(max_pages*sizeof(GPU_Image*));
+    num_pages = 0;
+    for(i = 0; i < data->num_entries; i++)
+    {
+        AtlasEntry* entry = &data->entries[i];
+        int cell_w, cell_h;
+
+        *entry = old_entries[i];
+        cell_w = entry->w + 2*extrude + atlas->padding;
+        cell_h = entry->h + 2*extrude + atlas->padding;
+
+        for(j = 0; j < num_pages; j++)
+        {
+            if(findPosition(atlas, &layout[j], cell_w, cell_h, &entry->x, &entry->y))
+                break;
+        }
+        if(j == num_pages)
+        {
+            pages[j] = (j < old_num_pages? atlas->pages[j] : GPU_CreateImage(atlas->page_w, atlas->page_h, GPU_FORMAT_RGBA));
+            if(pages[j] == NULL)
+            {
+                GPU_PushErrorCode("GPU_DefragmentAtlas", GPU_ERROR_BACKEND_ERROR, "Failed to create a new page.");
+                break;
+            }
+            initPage(atlas, &layout[j]);
+            num_pages++;
+            findPosition(atlas, &layout[j], cell_w, cell_h, &entry->x, &entry->y);
+        }
+
+        entry->page = j;
+        setSkyline(&layout[j], entry->x, cell_w, entry->y + cell_h);
+        layout[j].num_entries++;
+    }
+
+    result = (i == data->num_entries);
+    if(!result)
+    {
+        // Put everything back
+        memcpy(data->entries, old_entries, data->num_entries*sizeof(AtlasEntry));
+        for(j = 0; j < num_pages; j++)
+        {
+            SDL_free(layout[j].skyline);
+            if(j >= old_num_pages)
+                GPU_FreeImage(pages[j]);
+        }
+    }
+    else
+    {
+        // Copy the pixels over from the old layout
+        for(i = 0; i < data->num_entries; i++)
+        {
+            AtlasEntry* entry = &data->entries[i];
+            AtlasEntry* old_entry = &old_entries[i];
+            SDL_Surface* surface = surfaces[old_entry->page];
+            const Uint8* pixels = (const Uint8*)surface->pixels + (old_entry->y + extrude)*surface->pitch + (old_entry->x + extrude)*4;
+
+            uploadCell(atlas, pages[entry->page], entry->x, entry->y, pixels, surface->pitch, entry->w, entry->h);
+            moveImageToPage(entry->image, pages[entry->page]);
+            entry->image->texture_x = entry->x + extrude;
+            entry->image->texture_y = entry->y + extrude;
+        }
+
+        // The entry images hold their own references, so unused pages can go
+        for(j = 0; j < old_num_pages; j++)
+        {
+            SDL_free(data->pages[j].skyline);
+            if(j >= num_pages)
+                GPU_FreeImage(atlas->pages[j]);
+        }
+
+        atlas->num_pages = 0;
+        reservePages(atlas, num_pages);
+        memcpy(atlas->pages, pages, num_pages*sizeof(GPU_Image*));
+        memcpy(data->pages, layout, num_pages*sizeof(AtlasPage));
+        atlas->num_pages = num_pages;
+    }
+
+    for(j = 0; j < old_num_pages; j++)
+        SDL_FreeSurface(surfaces[j]);
+    SDL_free(surfaces);
+    SDL_free(old_entries);
+    SDL_free(layout);
+    SDL_free(pages);
+
+    return result;
+}
+
+void GPU_FreeAtlas(GPU_Atlas* atlas)
+{
+    AtlasData* data;
+    int i;
+
+    if(atlas == NULL)
+        return;
+
+    data = (AtlasData*)atlas->data;
+    for(i = 0; i < data->num_entries; i++)
+        GPU_FreeImage(data->entries[i].image);
+    for(i = 0; i < atlas->num_pages; i++)
+    {
+        SDL_free(data->pages[i].skyline);
+        GPU_FreeImage(atlas->pages[i]);
+    }
+
+    SDL_free(data->entries);
+    SDL_free(data->pages);
+    SDL_free(atlas->pages);
+    SDL_free(data);
+    SDL_free(atlas);
+}
@@ -0,0 +1,630 @@
+#include "SDL_gpu.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Block-compressed texture data: sizes, DDS and KTX containers, and decoders for renderers that can't sample the formats.
+// Every supported format stores 4x4 texel blocks of 8 or 16 bytes.
+
+// Most levels a 65535x65535 image can have
+#define GPU_MAX_COMPRESSED_LEVELS 16
+
+#define DDS_HEADER_SIZE 128
+#define DDS_DX10_HEADER_SIZE 20
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDPF_FOURCC 0x4
+
+#define KTX_HEADER_SIZE 64
+
+static const unsigned char ktx_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+
+Uint64 gpu_get_compressed_size(GPU_FormatEnum format, Uint16 w, Uint16 h);
+Uint8 gpu_decompress_image(GPU_FormatEnum format, Uint16 w, Uint16 h, const unsigned char* data, unsigned char* rgba);
+unsigned char* gpu_load_compressed_file(const char* filename, GPU_FormatEnum* format, Uint16* w, Uint16* h, int* num_levels, const unsigned char** levels, int max_levels);
+
+
+static int getBlockSize(GPU_FormatEnum format)
+{
+    switch(format)
+    {
+    case GPU_FORMAT_BC1:
+    case GPU_FORMAT_ETC2_RGB:
+        return 8;
+    case GPU_FORMAT_BC2:
+    case GPU_FORMAT_BC3:
+    case GPU_FORMAT_ETC2_RGBA:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+// Returns the number of bytes in one level of the given size, or 0 if the format is not compressed.
+// A 16-byte format at 65533x65533 or more takes 4 GB, which doesn't fit in 32 bits.
+Uint64 gpu_get_compressed_size(GPU_FormatEnum format, Uint16 w, Uint16 h)
+{
+    Uint64 blocks_x = (w + 3)/4;
+    Uint64 blocks_y = (h + 3)/4;
+    if(blocks_x < 1)
+        blocks_x = 1;
+    if(blocks_y < 1)
+        blocks_y = 1;
+    return blocks_x * blocks_y * getBlockSize(format);
+}
+
+
+
+// Decoders write one 4x4 block as RGBA into 'block'
+
+static void unpack565(Uint16 c, Uint8* rgb)
+{
+    Uint8 r = (c >> 11) & 0x1F;
+    Uint8 g = (c >> 5) & 0x3F;
+    Uint8 b = c & 0x1F;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// BC2 and BC3 always use the 4-color mode, so 'has_alpha_mode' is only set for BC1
+static void decodeBC1Colors(const unsigned char* src, Uint8 has_alpha_mode, unsigned char* block)
+{
+    Uint16 c0 = src[0] | (src[1] << 8);
+    Uint16 c1 = src[2] | (src[3] << 8);
+    Uint32 indices = src[4] | (src[5] << 8) | (src[6] << 16) | ((Uint32)src[7] << 24);
+    Uint8 colors[4][4];
+    int i, j;
+
+    unpack565(c0, colors[0]);
+    unpack565(c1, colors[1]);
+    colors[0][3] = colors[1][3] = colors[2][3] = colors[3][3] = 255;
+
+    if(c0 > c1 || !has_alpha_mode)
+    {
+        for(j = 0; j < 3; j++)
+        {
+            colors[2][j] = (2*colors[0][j] + colors[1][j])/3;
+            colors[3][j] = (colors[0][j] + 2*colors[1][j])/3;
+        }
+    }
+    else
+    {
+        for(j = 0; j < 3; j++)
+        {
+            colors[2][j] = (colors[0][j] + colors[1][j])/2;
+            colors[3][j] = 0;
+        }
+        colors[3][3] = 0;
+    }
+
+    // Row-major, 2 bits per texel
+    for(i = 0; i < 16; i++)
+        memcpy(block + 4*i, colors[(indices >> (2*i)) & 0x3], 4);
+}
+
+static void decodeBC2Alpha(const unsigned char* src, unsigned char* block)
+{
+    int i;
+    for(i = 0; i < 16; i++)
+    {
+        Uint8 a = (src[i/2] >> (4*(i%2))) & 0xF;
+        block[4*i + 3] = (a << 4) | a;
+    }
+}
+
+static void decodeBC3Alpha(const unsigned char* src, unsigned char* block)
+{
+    Uint8 alphas[8];
+    Uint32 a0 = src[0];
+    Uint32 a1 = src[1];
+    Uint64 indices = 0;
+    int i;
+
+    for(i = 0; i < 6; i++)
+        indices |= (Uint64)src[2 + i] << (8*i);
+
+    alphas[0] = a0;
+    alphas[1] = a1;
+    if(a0 > a1)
+    {
+        for(i = 1; i < 7; i++)
+            alphas[1 + i] = ((7 - i)*a0 + i*a1)/7;
+    }
+    else
+    {
+        for(i = 1; i < 5; i++)
+            alphas[1 + i] = ((5 - i)*a0 + i*a1)/5;
+        alphas[6] = 0;
+        alphas[7] = 255;
+    }
+
+    for(i = 0; i < 16; i++)
+        block[4*i + 3] = alphas[(indices >> (3*i)) & 0x7];
+}
+
+
+static const int etc1_modifiers[8][2] = {{2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+static const int etc2_distances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+static const int eac_modifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12},
+    {-3, -6, -8, -12, 2, 5, 7, 11},
+    {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10},
+    {-3, -5, -8, -11, 2, 4, 7, 10},
+    {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9},
+    {-2, -4, -8, -10, 1, 3, 7, 9},
+    {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},
+    {-1, -2, -3, -10, 0, 1, 2, 9},
+    {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8}
+};
+
+static Uint8 clamp255(int value)
+{
+    return (value < 0? 0 : (value > 255? 255 : value));
+}
+
+// Replicates the high bits of a 'bits'-wide value into the low bits of a byte
+static Uint8 extendBits(int value, int bits)
+{
+    return (Uint8)((value << (8 - bits)) | (value >> (2*bits - 8)));
+}
+
+static int signExtend3(int value)
+{
+    return (value & 0x4? value - 8 : value);
+}
+
+// ETC blocks are big-endian and their texels are column-major.
+// The individual and differential modes (ETC1) split the block into two subblocks of 2x4 (or 4x2 when flipped) with their own base color and modifier table.
+static void decodeETC1Subblocks(const unsigned char* src, Uint8 base[2][3], Uint32 indices, unsigned char* block)
+{
+    int x, y, j;
+    for(x = 0; x < 4; x++)
+    {
+        for(y = 0; y < 4; y++)
+        {
+            int subblock = ((src[3] & 0x1)? y >= 2 : x >= 2);
+            int table = (subblock? (src[3] >> 2) & 0x7 : src[3] >> 5);
+            int i = x*4 + y;
+            int modifier = etc1_modifiers[table][(indices >> i) & 0x1];
+            unsigned char* texel = block + 4*(y*4 + x);
+
+            if((indices >> (16 + i)) & 0x1)
+                modifier = -modifier;
+
+            for(j = 0; j < 3; j++)
+                texel[j] = clamp255(base[subblock][j] + modifier);
+            texel[3] = 255;
+        }
+    }
+}
+
+static void decodeETC2Colors(const unsigned char* src, unsigned char* block)
+{
+    Uint32 indices = ((Uint32)src[4] << 24) | (src[5] << 16) | (src[6] << 8) | src[7];
+    Uint8 base[2][3];
+    Uint8 paint[4][3];
+    int r, g, b, dr, dg, db;
+    int x, y, i, j;
+
+    if(src[3] & 0x2)
+    {
+        r = src[0] >> 3;
+        g = src[1] >> 3;
+        b = src[2] >> 3;
+        dr = r + signExtend3(src[0] & 0x7);
+        dg = g + signExtend3(src[1] & 0x7);
+        db = b + signExtend3(src[2] & 0x7);
+
+        if(dr < 0 || dr > 31)
+        {
+            // T mode
+            int d = etc2_distances[((src[3] >> 1) & 0x6) | (src[3] & 0x1)];
+            base[0][0] = extendBits(((src[0] >> 1) & 0xC) | (src[0] & 0x3), 4);
+            base[0][1] = extendBits(src[1] >> 4, 4);
+            base[0][2] = extendBits(src[1] & 0xF, 4);
+            base[1][0] = extendBits(src[2] >> 4, 4);
+            base[1][1] = extendBits(src[2] & 0xF, 4);
+            base[1][2] = extendBits(src[3] >> 4, 4);
+            for(j = 0; j < 3; j++)
+            {
+                paint[0][j] = base[0][j];
+                paint[1][j] = clamp255(base[1][j] + d);
+                paint[2][j] = base[1][j];
+                paint[3][j] = clamp255(base[1][j] - d);
+            }
+        }
+        else if(dg < 0 || dg > 31)
+        {
+            // H mode
+            int d;
+            Uint32 value0, value1;
+            base[0][0] = extendBits((src[0] >> 3) & 0xF, 4);
+            base[0][1] = extendBits(((src[0] << 1) & 0xE) | ((src[1] >> 4) & 0x1), 4);
+            base[0][2] = extendBits((src[1] & 0x8) | ((src[1] << 1) & 0x6) | (src[2] >> 7), 4);
+            base[1][0] = extendBits((src[2] >> 3) & 0xF, 4);
+            base[1][1] = extendBits(((src[2] << 1) & 0xE) | (src[3] >> 7), 4);
+            base[1][2] = extendBits((src[3] >> 3) & 0xF, 4);
+            value0 = (base[0][0] << 16) | (base[0][1] << 8) | base[0][2];
+            value1 = (base[1][0] << 16) | (base[1][1] << 8) | base[1][2];
+            d = etc2_distances[(src[3] & 0x4) | ((src[3] & 0x1) << 1) | (value0 >= value1)];
+            for(j = 0; j < 3; j++)
+            {
+                paint[0][j] = clamp255(base[0][j] + d);
+                paint[1][j] = clamp255(base[0][j] - d);
+                paint[2][j] = clamp255(base[1][j] + d);
+                paint[3][j] = clamp255(base[1][j] - d);
+            }
+        }
+        else if(db < 0 || db > 31)
+        {
+            // Planar mode: a gradient from three colors instead of indexed texels
+            int o[3], h[3], v[3];
+            o[0] = extendBits((src[0] >> 1) & 0x3F, 6);
+            o[1] = extendBits(((src[0] & 0x1) << 6) | ((src[1] >> 1) & 0x3F), 7);
+            o[2] = extendBits(((src[1] & 0x1) << 5) | (src[2] & 0x18) | ((src[2] << 1) & 0x6) | ((src[3] >> 7) & 0x1), 6);
+            h[0] = extendBits(((src[3] >> 1) & 0x3E) | (src[3] & 0x1), 6);
+            h[1] = extendBits((src[4] >> 1) & 0x7F, 7);
+            h[2] = extendBits(((src[4] << 5) & 0x20) | ((src[5] >> 3) & 0x1F), 6);
+            v[0] = extendBits(((src[5] << 3) & 0x38) | ((src[6] >> 5) & 0x7), 6);
+            v[1] = extendBits(((src[6] << 2) & 0x7C) | ((src[7] >> 6) & 0x3), 7);
+            v[2] = extendBits(src[7] & 0x3F, 6);
+            for(y = 0; y < 4; y++)
+            {
+                for(x = 0; x < 4; x++)
+                {
+                    unsigned char* texel = block + 4*(y*4 + x);
+                    for(j = 0; j < 3; j++)
+                        texel[j] = clamp255((x*(h[j] - o[j]) + y*(v[j] - o[j]) + 4*o[j] + 2) >> 2);
+                    texel[3] = 255;
+                }
+            }
+            return;
+        }
+        else
+        {
+            // Differential mode
+            base[0][0] = extendBits(r, 5);
+            base[0][1] = extendBits(g, 5);
+            base[0][2] = extendBits(b, 5);
+            base[1][0] = extendBits(dr, 5);
+            base[1][1] = extendBits(dg, 5);
+            base[1][2] = extendBits(db, 5);
+            decodeETC1Subblocks(src, base, indices, block);
+            return;
+        }
+
+        // T and H modes index four paint colors
+        for(x = 0; x < 4; x++)
+        {
+            for(y = 0; y < 4; y++)
+            {
+                i = x*4 + y;
+                j = (((indices >> (16 + i)) & 0x1) << 1) | ((indices >> i) & 0x1);
+                memcpy(block + 4*(y*4 + x), paint[j], 3);
+                block[4*(y*4 + x) + 3] = 255;
+            }
+        }
+        return;
+    }
+
+    // Individual mode
+    base[0][0] = extendBits(src[0] >> 4, 4);
+    base[1][0] = extendBits(src[0] & 0xF, 4);
+    base[0][1] = extendBits(src[1] >> 4, 4);
+    base[1][1] = extendBits(src[1] & 0xF, 4);
+    base[0][2] = extendBits(src[2] >> 4, 4);
+    base[1][2] = extendBits(src[2] & 0xF, 4);
+    decodeETC1Subblocks(src, base, indices, block);
+}
+
+static void decodeEACAlpha(const unsigned char* src, unsigned char* block)
+{
+    int base = src[0];
+    int multiplier = src[1] >> 4;
+    const int* modifiers = eac_modifiers[src[1] & 0xF];
+    Uint64 indices = 0;
+    int x, y, i;
+
+    for(i = 2; i < 8; i++)
+        indices = (indices << 8) | src[i];
+
+    for(x = 0; x < 4; x++)
+    {
+        for(y = 0; y < 4; y++)
+        {
+            int index = (indices >> (45 - 3*(x*4 + y))) & 0x7;
+            block[4*(y*4 + x) + 3] = clamp255(base + modifiers[index]*multiplier);
+        }
+    }
+}
+
+// Decodes one level into tightly packed RGBA.  Returns 0 if the format is not compressed.
+Uint8 gpu_decompress_image(GPU_FormatEnum format, Uint16 w, Uint16 h, const unsigned char* data, unsigned char* rgba)
+{
+    int block_size = getBlockSize(format);
+    unsigned char block[64];
+    int bx, by, y;
+
+    if(block_size == 0)
+        return 0;
+
+    for(by = 0; by < h; by += 4)
+    {
+        for(bx = 0; bx < w; bx += 4)
+        {
+            int copy_w = (w - bx < 4? w - bx : 4);
+
+            switch(format)
+            {
+            case GPU_FORMAT_BC1:
+                decodeBC1Colors(data, 1, block);
+                break;
+            case GPU_FORMAT_BC2:
+                decodeBC1Colors(data + 8, 0, block);
+                decodeBC2Alpha(data, block);
+                break;
+            case GPU_FORMAT_BC3:
+                decodeBC1Colors(data + 8, 0, block);
+                decodeBC3Alpha(data, block);
+                break;
+            case GPU_FORMAT_ETC2_RGB:
+                decodeETC2Colors(data, block);
+                break;
+            case GPU_FORMAT_ETC2_RGBA:
+                decodeETC2Colors(data + 8, block);
+                decodeEACAlpha(data, block);
+                break;
+            default:
+                return 0;
+            }
+            data += block_size;
+
+            // Blocks on the right and bottom edges can hang off the image
+            for(y = 0; y < 4 && by + y < h; y++)
+                memcpy(rgba + 4*((by + y)*w + bx), block + 16*y, 4*copy_w);
+        }
+    }
+    return 1;
+}
+
+
+
+static Uint32 readLE32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+static Uint32 readKTX32(const unsigned char* p, Uint8 swap)
+{
+    Uint32 value = readLE32(p);
+    if(swap)
+        value = ((value >> 24) & 0xFF) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+    return value;
+}
+
+static Uint8 parseDDS(const unsigned char* file, Uint32 file_size, GPU_FormatEnum* format, Uint16* w, Uint16* h, int* num_levels, const unsigned char** levels, int max_levels)
+{
+    Uint32 offset = DDS_HEADER_SIZE;
+    Uint32 flags, fourcc;
+    int i;
+
+    if(file_size < DDS_HEADER_SIZE || memcmp(file, "DDS ", 4) != 0)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Not a DDS file");
+        return 0;
+    }
+
+    flags = readLE32(file + 8);
+    fourcc = readLE32(file + 84);
+    if(!(readLE32(file + 80) & DDPF_FOURCC))
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Uncompressed DDS files are not supported");
+        return 0;
+    }
+
+    if(fourcc == readLE32((const unsigned char*)"DXT1"))
+        *format = GPU_FORMAT_BC1;
+    else if(fourcc == readLE32((const unsigned char*)"DXT3"))
+        *format = GPU_FORMAT_BC2;
+    else if(fourcc == readLE32((const unsigned char*)"DXT5"))
+        *format = GPU_FORMAT_BC3;
+    else if(fourcc == readLE32((const unsigned char*)"DX10") && file_size >= DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE)
+    {
+        // DXGI_FORMAT_BC*_UNORM and their _SRGB variants
+        switch(readLE32(file + DDS_HEADER_SIZE))
+        {
+        case 71:
+        case 72:
+            *format = GPU_FORMAT_BC1;
+            break;
+        case 74:
+        case 75:
+            *format = GPU_FORMAT_BC2;
+            break;
+        case 77:
+        case 78:
+            *format = GPU_FORMAT_BC3;
+            break;
+        default:
+            GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Unsupported DXGI format (%u)", readLE32(file + DDS_HEADER_SIZE));
+            return 0;
+        }
+        offset += DDS_DX10_HEADER_SIZE;
+    }
+    else
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Unsupported DDS format");
+        return 0;
+    }
+
+    *h = (Uint16)readLE32(file + 12);
+    *w = (Uint16)readLE32(file + 16);
+    *num_levels = ((flags & DDSD_MIPMAPCOUNT) && readLE32(file + 28) > 0? (int)readLE32(file + 28) : 1);
+    if(*num_levels > max_levels)
+        *num_levels = max_levels;
+
+    // The levels are stored back to back
+    for(i = 0; i < *num_levels; i++)
+    {
+        Uint16 level_w = (*w >> i > 0? *w >> i : 1);
+        Uint16 level_h = (*h >> i > 0? *h >> i : 1);
+        Uint64 size = gpu_get_compressed_size(*format, level_w, level_h);
+        if(size > file_size - offset)
+        {
+            if(i == 0)
+            {
+                GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "DDS file is truncated");
+                return 0;
+            }
+            *num_levels = i;
+            break;
+        }
+        levels[i] = file + offset;
+        offset += (Uint32)size;
+    }
+    return 1;
+}
+
+static Uint8 parseKTX(const unsigned char* file, Uint32 file_size, GPU_FormatEnum* format, Uint16* w, Uint16* h, int* num_levels, const unsigned char** levels, int max_levels)
+{
+    Uint32 offset;
+    Uint8 swap;
+    int i;
+
+    if(file_size < KTX_HEADER_SIZE || memcmp(file, ktx_identifier, sizeof(ktx_identifier)) != 0)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Not a KTX file");
+        return 0;
+    }
+
+    swap = (readLE32(file + 12) != 0x04030201);
+
+    // Only single 2D textures
+    if(readKTX32(file + 44, swap) > 1 || readKTX32(file + 48, swap) > 0 || readKTX32(file + 52, swap) > 1)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "KTX arrays, cube maps, and 3D textures are not supported");
+        return 0;
+    }
+
+    // glInternalFormat
+    switch(readKTX32(file + 28, swap))
+    {
+    case 0x83F0:  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    case 0x83F1:  // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+        *format = GPU_FORMAT_BC1;
+        break;
+    case 0x83F2:  // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+        *format = GPU_FORMAT_BC2;
+        break;
+    case 0x83F3:  // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+        *format = GPU_FORMAT_BC3;
+        break;
+    case 0x8D64:  // GL_ETC1_RGB8_OES, which ETC2 decoders read the same way
+    case 0x9274:  // GL_COMPRESSED_RGB8_ETC2
+    case 0x9275:  // GL_COMPRESSED_SRGB8_ETC2
+        *format = GPU_FORMAT_ETC2_RGB;
+        break;
+    case 0x9278:  // GL_COMPRESSED_RGBA8_ETC2_EAC
+    case 0x9279:  // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+        *format = GPU_FORMAT_ETC2_RGBA;
+        break;
+    default:
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Unsupported KTX format (0x%x)", readKTX32(file + 28, swap));
+        return 0;
+    }
+
+    *w = (Uint16)readKTX32(file + 36, swap);
+    *h = (Uint16)readKTX32(file + 40, swap);
+    *num_levels = (int)readKTX32(file + 56, swap);
+    if(*num_levels < 1)
+        *num_levels = 1;
+    if(*num_levels > max_levels)
+        *num_levels = max_levels;
+
+    // Skip the key/value data.  Each level is prefixed by its size and padded to 4 bytes.
+    // Sizes come from the file, so the bounds checks subtract from file_size instead of adding to offset, which could wrap.
+    offset = readKTX32(file + 60, swap);
+    if(offset > file_size - KTX_HEADER_SIZE)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "KTX file is truncated");
+        return 0;
+    }
+    offset += KTX_HEADER_SIZE;
+    for(i = 0; i < *num_levels; i++)
+    {
+        Uint16 level_w = (*w >> i > 0? *w >> i : 1);
+        Uint16 level_h = (*h >> i > 0? *h >> i : 1);
+        Uint32 size;
+
+        if(offset > file_size || file_size - offset < 4)
+            size = 0;
+        else
+            size = readKTX32(file + offset, swap);
+
+        if(size < gpu_get_compressed_size(*format, level_w, level_h) || size > file_size - offset - 4)
+        {
+            if(i == 0)
+            {
+                GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "KTX file is truncated");
+                return 0;
+            }
+            *num_levels = i;
+            break;
+        }
+        levels[i] = file + offset + 4;
+        offset += 4 + (size + 3)/4*4;
+    }
+    return 1;
+}
+
+// Reads a DDS or KTX file.  Returns the file contents, which 'levels' point into, or NULL on failure.
+unsigned char* gpu_load_compressed_file(const char* filename, GPU_FormatEnum* format, Uint16* w, Uint16* h, int* num_levels, const unsigned char** levels, int max_levels)
+{
+    SDL_RWops* rwops;
+    unsigned char* file;
+    int file_size;
+    Uint8 result;
+
+    // SDL_RWops also reaches the Android assets directory
+    rwops = SDL_RWFromFile(filename, "rb");
+    if(rwops == NULL)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Failed to open \"%s\"", filename);
+        return NULL;
+    }
+    file_size = (int)SDL_RWseek(rwops, 0, SEEK_END);
+    SDL_RWseek(rwops, 0, SEEK_SET);
+    file = (file_size > 0? (unsigned char*)SDL_malloc(file_size) : NULL);
+    if(file == NULL || SDL_RWread(rwops, file, 1, file_size) != (size_t)file_size)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Failed to read \"%s\"", filename);
+        SDL_free(file);
+        SDL_RWclose(rwops);
+        return NULL;
+    }
+    SDL_RWclose(rwops);
+
+    if(max_levels > GPU_MAX_COMPRESSED_LEVELS)
+        max_levels = GPU_MAX_COMPRESSED_LEVELS;
+
+    if(file_size >= (int)sizeof(ktx_identifier) && memcmp(file, ktx_identifier, sizeof(ktx_identifier)) == 0)
+        result = parseKTX(file, file_size, format, w, h, num_levels, levels, max_levels);
+    else
+        result = parseDDS(file, file_size, format, w, h, num_levels, levels, max_levels);
+
+    if(!result || *w == 0 || *h == 0)
+    {
+        if(result)
+            GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "\"%s\" has no pixels", filename);
+        SDL_free(file);
+        return NULL;
+    }
+    return file;
+}
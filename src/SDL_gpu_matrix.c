@@ -153,6 +153,8 @@ float* GPU_GetModelView(void)
     stack = &target->context->modelview_matrix;
     if(stack->size == 0)
         return NULL;
+    // The caller might change it
+    stack->version++;
     return stack->matrix[stack->size-1];
 }
 
@@ -166,6 +168,8 @@ float* GPU_GetProjection(void)
     stack = &target->context->projection_matrix;
     if(stack->size == 0)
         return NULL;
+    // The caller might change it
+    stack->version++;
     return stack->matrix[stack->size-1];
 }
 
@@ -183,6 +187,8 @@ float* GPU_GetCurrentMatrix(void)
     
     if(stack->size == 0)
         return NULL;
+    // All of the matrix operations come through here
+    stack->version++;
     return stack->matrix[stack->size-1];
 }
 
@@ -202,6 +208,7 @@ void GPU_PushMatrix(void)
     }
     GPU_MatrixCopy(stack->matrix[stack->size], stack->matrix[stack->size-1]);
     stack->size++;
+    stack->version++;
 }
 
 void GPU_PopMatrix(void)
@@ -219,6 +226,7 @@ void GPU_PopMatrix(void)
         return;
     }
     stack->size--;
+    stack->version++;
 }
 
 void GPU_LoadIdentity(void)
@@ -392,6 +400,19 @@ void GPU_MultMatrix(float* A)
 
 void GPU_GetModelViewProjection(float* result)
 {
+    GPU_Target* target = GPU_GetContextTarget();
+    GPU_MatrixStack* projection;
+    GPU_MatrixStack* modelview;
+
+    if(target == NULL || target->context == NULL)
+        return;
+    
+    // Read the stacks directly, since this doesn't change them
+    projection = &target->context->projection_matrix;
+    modelview = &target->context->modelview_matrix;
+    if(projection->size == 0 || modelview->size == 0)
+        return;
+    
     // MVP = P * MV
-    GPU_Multiply4x4(result, GPU_GetProjection(), GPU_GetModelView());
+    GPU_Multiply4x4(result, projection->matrix[projection->size-1], modelview->matrix[modelview->size-1]);
 }
@@ -0,0 +1,240 @@
+#include "SDL_gpu.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SDL_GPU_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define SDL_GPU_HAVE_NEON
+    #include <arm_neon.h>
+#endif
+
+
+// Cody-Waite split of pi/2, so the reduced angle keeps its precision
+#define SINCOS_PI_2_HI 1.5703125f
+#define SINCOS_PI_2_MID 4.837512969970703125e-4f
+#define SINCOS_PI_2_LO 7.54978995489188216e-8f
+#define SINCOS_2_PI 0.636619772367581343f
+
+// Past this, the quadrant count loses precision and the reduction falls apart
+#define SINCOS_MAX_FAST_ANGLE 8192.0f
+
+void GPU_SinCos(float radians, float* sin_result, float* cos_result)
+{
+    float j, x, z, s, c;
+    int quadrant;
+
+    if(radians > SINCOS_MAX_FAST_ANGLE || radians < -SINCOS_MAX_FAST_ANGLE)
+    {
+        *sin_result = sinf(radians);
+        *cos_result = cosf(radians);
+        return;
+    }
+
+    // Reduce to [-pi/4, pi/4] and remember the quadrant
+    j = floorf(radians*SINCOS_2_PI + 0.5f);
+    quadrant = (int)j;
+    x = ((radians - j*SINCOS_PI_2_HI) - j*SINCOS_PI_2_MID) - j*SINCOS_PI_2_LO;
+    z = x*x;
+
+    // Minimax polynomials from Cephes' sinf() and cosf()
+    s = x + x*z*((-1.9515295891e-4f*z + 8.3321608736e-3f)*z - 1.6666654611e-1f);
+    c = 1.0f - 0.5f*z + z*z*((2.443315711809948e-5f*z - 1.388731625493765e-3f)*z + 4.166664568298827e-2f);
+
+    switch(quadrant & 3)
+    {
+    case 0:
+        *sin_result = s;
+        *cos_result = c;
+        break;
+    case 1:
+        *sin_result = c;
+        *cos_result = -s;
+        break;
+    case 2:
+        *sin_result = -s;
+        *cos_result = -c;
+        break;
+    default:
+        *sin_result = -c;
+        *cos_result = s;
+        break;
+    }
+}
+
+
+
+// Vertex order matches the blit buffer: (dx1, dy1), (dx2, dy1), (dx2, dy2), (dx1, dy2)
+static void makeSpriteVertices_scalar(float* result, int floats_per_vertex, float dx1, float dy1, float dx2, float dy2, float x, float y, float sin_angle, float cos_angle, float s1, float t1, float s2, float t2, float r, float g, float b, float a)
+{
+    float dx[4];
+    float dy[4];
+    float s[4];
+    float t[4];
+    int i;
+
+    dx[0] = dx1; dy[0] = dy1; s[0] = s1; t[0] = t1;
+    dx[1] = dx2; dy[1] = dy1; s[1] = s2; t[1] = t1;
+    dx[2] = dx2; dy[2] = dy2; s[2] = s2; t[2] = t2;
+    dx[3] = dx1; dy[3] = dy2; s[3] = s1; t[3] = t2;
+
+    for(i = 0; i < 4; i++)
+    {
+        result[0] = dx[i]*cos_angle - dy[i]*sin_angle + x;
+        result[1] = dx[i]*sin_angle + dy[i]*cos_angle + y;
+        result[2] = s[i];
+        result[3] = t[i];
+        result[4] = r;
+        result[5] = g;
+        result[6] = b;
+        result[7] = a;
+        result += floats_per_vertex;
+    }
+}
+
+#ifdef SDL_GPU_HAVE_SSE2
+static void makeSpriteVertices_SSE2(float* result, int floats_per_vertex, float dx1, float dy1, float dx2, float dy2, float x, float y, float sin_angle, float cos_angle, float s1, float t1, float s2, float t2, float r, float g, float b, float a)
+{
+    __m128 dx = _mm_setr_ps(dx1, dx2, dx2, dx1);
+    __m128 dy = _mm_setr_ps(dy1, dy1, dy2, dy2);
+    __m128 sin_v = _mm_set1_ps(sin_angle);
+    __m128 cos_v = _mm_set1_ps(cos_angle);
+
+    // All 4 corners at once
+    __m128 vx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(dx, cos_v), _mm_mul_ps(dy, sin_v)), _mm_set1_ps(x));
+    __m128 vy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, sin_v), _mm_mul_ps(dy, cos_v)), _mm_set1_ps(y));
+
+    // x0 y0 x1 y1 and x2 y2 x3 y3
+    __m128 xy01 = _mm_unpacklo_ps(vx, vy);
+    __m128 xy23 = _mm_unpackhi_ps(vx, vy);
+    __m128 st01 = _mm_setr_ps(s1, t1, s2, t1);
+    __m128 st23 = _mm_setr_ps(s2, t2, s1, t2);
+    __m128 color = _mm_setr_ps(r, g, b, a);
+
+    // Vertices are not 16-byte aligned when the layout has extra floats
+    _mm_storeu_ps(result, _mm_movelh_ps(xy01, st01));
+    _mm_storeu_ps(result + 4, color);
+    result += floats_per_vertex;
+    _mm_storeu_ps(result, _mm_movehl_ps(st01, xy01));
+    _mm_storeu_ps(result + 4, color);
+    result += floats_per_vertex;
+    _mm_storeu_ps(result, _mm_movelh_ps(xy23, st23));
+    _mm_storeu_ps(result + 4, color);
+    result += floats_per_vertex;
+    _mm_storeu_ps(result, _mm_movehl_ps(st23, xy23));
+    _mm_storeu_ps(result + 4, color);
+}
+#endif
+
+#ifdef SDL_GPU_HAVE_NEON
+static void makeSpriteVertices_NEON(float* result, int floats_per_vertex, float dx1, float dy1, float dx2, float dy2, float x, float y, float sin_angle, float cos_angle, float s1, float t1, float s2, float t2, float r, float g, float b, float a)
+{
+    float dx_values[4] = {dx1, dx2, dx2, dx1};
+    float dy_values[4] = {dy1, dy1, dy2, dy2};
+    float st_values[8] = {s1, t1, s2, t1, s2, t2, s1, t2};
+    float color_values[4] = {r, g, b, a};
+    float32x4_t dx = vld1q_f32(dx_values);
+    float32x4_t dy = vld1q_f32(dy_values);
+    float32x4_t st01 = vld1q_f32(st_values);
+    float32x4_t st23 = vld1q_f32(st_values + 4);
+    float32x4_t color = vld1q_f32(color_values);
+
+    // All 4 corners at once
+    float32x4_t vx = vaddq_f32(vsubq_f32(vmulq_n_f32(dx, cos_angle), vmulq_n_f32(dy, sin_angle)), vdupq_n_f32(x));
+    float32x4_t vy = vaddq_f32(vaddq_f32(vmulq_n_f32(dx, sin_angle), vmulq_n_f32(dy, cos_angle)), vdupq_n_f32(y));
+
+    // x0 y0 x1 y1 and x2 y2 x3 y3
+    float32x4x2_t xy = vzipq_f32(vx, vy);
+
+    vst1q_f32(result, vcombine_f32(vget_low_f32(xy.val[0]), vget_low_f32(st01)));
+    vst1q_f32(result + 4, color);
+    result += floats_per_vertex;
+    vst1q_f32(result, vcombine_f32(vget_high_f32(xy.val[0]), vget_high_f32(st01)));
+    vst1q_f32(result + 4, color);
+    result += floats_per_vertex;
+    vst1q_f32(result, vcombine_f32(vget_low_f32(xy.val[1]), vget_low_f32(st23)));
+    vst1q_f32(result + 4, color);
+    result += floats_per_vertex;
+    vst1q_f32(result, vcombine_f32(vget_high_f32(xy.val[1]), vget_high_f32(st23)));
+    vst1q_f32(result + 4, color);
+}
+#endif
+
+
+typedef void (*MakeSpriteVerticesFn)(float* result, int floats_per_vertex, float dx1, float dy1, float dx2, float dy2, float x, float y, float sin_angle, float cos_angle, float s1, float t1, float s2, float t2, float r, float g, float b, float a);
+
+static Uint8 _gpu_simd_initialized = 0;
+static GPU_SIMDEnum _gpu_simd = GPU_SIMD_NONE;
+static MakeSpriteVerticesFn _gpu_make_sprite_vertices = &makeSpriteVertices_scalar;
+
+static Uint8 isSIMDSupported(GPU_SIMDEnum simd)
+{
+    switch(simd)
+    {
+    case GPU_SIMD_NONE:
+        return 1;
+    #ifdef SDL_GPU_HAVE_SSE2
+    case GPU_SIMD_SSE2:
+        return (SDL_HasSSE2() == SDL_TRUE);
+    #endif
+    #ifdef SDL_GPU_HAVE_NEON
+    case GPU_SIMD_NEON:
+        // Code built with NEON enabled can't run without it anyway
+        return 1;
+    #endif
+    default:
+        return 0;
+    }
+}
+
+GPU_SIMDEnum GPU_SetSIMD(GPU_SIMDEnum simd)
+{
+    if(!isSIMDSupported(simd))
+        simd = GPU_SIMD_NONE;
+
+    switch(simd)
+    {
+    #ifdef SDL_GPU_HAVE_SSE2
+    case GPU_SIMD_SSE2:
+        _gpu_make_sprite_vertices = &makeSpriteVertices_SSE2;
+        break;
+    #endif
+    #ifdef SDL_GPU_HAVE_NEON
+    case GPU_SIMD_NEON:
+        _gpu_make_sprite_vertices = &makeSpriteVertices_NEON;
+        break;
+    #endif
+    default:
+        _gpu_make_sprite_vertices = &makeSpriteVertices_scalar;
+        break;
+    }
+
+    _gpu_simd = simd;
+    _gpu_simd_initialized = 1;
+    return simd;
+}
+
+GPU_SIMDEnum GPU_GetSIMD(void)
+{
+    if(!_gpu_simd_initialized)
+    {
+        // Pick the best one that the CPU has
+        if(isSIMDSupported(GPU_SIMD_SSE2))
+            GPU_SetSIMD(GPU_SIMD_SSE2);
+        else if(isSIMDSupported(GPU_SIMD_NEON))
+            GPU_SetSIMD(GPU_SIMD_NEON);
+        else
+            GPU_SetSIMD(GPU_SIMD_NONE);
+    }
+    return _gpu_simd;
+}
+
+void GPU_MakeSpriteVertices(float* result, int floats_per_vertex, float dx1, float dy1, float dx2, float dy2, float x, float y, float sin_angle, float cos_angle, float s1, float t1, float s2, float t2, float r, float g, float b, float a)
+{
+    if(!_gpu_simd_initialized)
+        GPU_GetSIMD();
+
+    _gpu_make_sprite_vertices(result, floats_per_vertex, dx1, dy1, dx2, dy2, x, y, sin_angle, cos_angle, s1, t1, s2, t2, r, g, b, a);
+}
@@ -54,26 +54,39 @@ See a particular renderer's *.c file for specifics. */
 
 int gpu_strcasecmp(const char* s1, const char* s2);
 
+Uint64 gpu_get_compressed_size(GPU_FormatEnum format, Uint16 w, Uint16 h);
+Uint8 gpu_decompress_image(GPU_FormatEnum format, Uint16 w, Uint16 h, const unsigned char* data, unsigned char* rgba);
+unsigned char* gpu_load_compressed_file(const char* filename, GPU_FormatEnum* format, Uint16* w, Uint16* h, int* num_levels, const unsigned char** levels, int max_levels);
+
 
 // Forces a flush when vertex limit is reached (roughly 1000 sprites)
 #define GPU_BLIT_BUFFER_VERTICES_PER_SPRITE 4
 #define GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES (GPU_BLIT_BUFFER_VERTICES_PER_SPRITE*1000)
+#define GPU_SORTED_BLIT_BUFFER_INIT_MAX_NUM_BLITS 1000
 
 
 // Near the unsigned short limit (65535)
 #define GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES 60000
+// Default batch capacity with 32-bit indices (roughly 250000 sprites)
+#define GPU_BLIT_BUFFER_DEFAULT_MAX_VERTICES_32BIT (GPU_BLIT_BUFFER_VERTICES_PER_SPRITE*250000)
 // Near the unsigned int limit (4294967295)
 #define GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES 4000000000u
 
 
 // x, y, s, t, r, g, b, a
+// Packed tex coords (2 unsigned shorts) and packed colors (4 unsigned bytes) each fit in a single float slot instead.
 #define GPU_BLIT_BUFFER_FLOATS_PER_VERTEX 8
 
-// bytes per vertex
-#define GPU_BLIT_BUFFER_STRIDE (sizeof(float)*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX)
+// bytes per vertex in the context's vertex format
+#define GPU_BLIT_BUFFER_STRIDE(cdata) (sizeof(float)*(cdata)->blit_buffer_floats_per_vertex)
 #define GPU_BLIT_BUFFER_VERTEX_OFFSET 0
 #define GPU_BLIT_BUFFER_TEX_COORD_OFFSET 2
-#define GPU_BLIT_BUFFER_COLOR_OFFSET 4
+
+#ifdef SDL_GPU_USE_INSTANCING
+// x1, y1, x2, y2 (corners relative to the pivot), x, y, angle, s1, t1, s2, t2, packed r, g, b, a, texture slot
+#define GPU_INSTANCE_BUFFER_FLOATS_PER_INSTANCE 13
+#define GPU_INSTANCE_BUFFER_STRIDE (sizeof(float)*GPU_INSTANCE_BUFFER_FLOATS_PER_INSTANCE)
+#endif
 
 
 
@@ -92,6 +105,26 @@ int gpu_strcasecmp(const char* s1, const char* s2);
     #endif
 #endif
 
+// Compressed formats are only defined by some of the GL headers
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+    #define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+    #define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+    #define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+
+// Most mipmap levels that compressed data is read with
+#define GPU_MAX_COMPRESSED_LEVELS 16
+
 
 // Workaround for Intel HD glVertexAttrib() bug.
 #ifdef SDL_GPU_USE_OPENGL
@@ -260,14 +293,40 @@ static void init_features(GPU_Renderer* renderer)
     #ifdef SDL_GPU_ASSUME_SHADERS
     renderer->enabled_features |= GPU_FEATURE_BASIC_SHADERS;
     #endif
+
+    // Compressed texture formats
+    if(isExtensionSupported("GL_EXT_texture_compression_s3tc"))
+        renderer->enabled_features |= GPU_FEATURE_COMPRESSED_BC;
+    #ifdef SDL_GPU_USE_OPENGL
+    // Core in GL 4.3 and GLES 3
+    if(isExtensionSupported("GL_ARB_ES3_compatibility"))
+        renderer->enabled_features |= GPU_FEATURE_COMPRESSED_ETC2;
+    #else
+    if(isExtensionSupported("GL_OES_compressed_ETC2_RGB8_texture") && isExtensionSupported("GL_OES_compressed_ETC2_RGBA8_texture"))
+        renderer->enabled_features |= GPU_FEATURE_COMPRESSED_ETC2;
+    #endif
 }
 
-static void extBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
+static Uint8 isCompressedFormatSupported(GPU_Renderer* renderer, GPU_FormatEnum format)
 {
-    if(renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS)
-        glBindFramebuffer(GL_FRAMEBUFFER, handle);
+    switch(format)
+    {
+    case GPU_FORMAT_BC1:
+    case GPU_FORMAT_BC2:
+    case GPU_FORMAT_BC3:
+        return ((renderer->enabled_features & GPU_FEATURE_COMPRESSED_BC) != 0);
+    case GPU_FORMAT_ETC2_RGB:
+    case GPU_FORMAT_ETC2_RGBA:
+        return ((renderer->enabled_features & GPU_FEATURE_COMPRESSED_ETC2) != 0);
+    default:
+        return 0;
+    }
 }
 
+static_inline Uint8 isCompressedFormat(GPU_FormatEnum format)
+{
+    return (gpu_get_compressed_size(format, 1, 1) != 0);
+}
 
 static_inline Uint8 isPowerOfTwo(unsigned int x)
 {
@@ -284,244 +343,2062 @@ static_inline unsigned int getNearestPowerOf2(unsigned int n)
     return x;
 }
 
-static void bindTexture(GPU_Renderer* renderer, GPU_Image* image)
-{
-    // Bind the texture to which subsequent calls refer
-    if(image != ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
-    {
-        GLuint handle = ((GPU_IMAGE_DATA*)image->data)->handle;
-        renderer->impl->FlushBlitBuffer(renderer);
+#ifndef SDL_GPU_DISABLE_FRAME_STATS
+#define GPU_ADD_FRAME_STAT(cdata, stat, amount) ((cdata)->frame_stats.stat += (amount))
+#else
+#define GPU_ADD_FRAME_STAT(cdata, stat, amount) ((void)(cdata))
+#endif
 
-        glBindTexture( GL_TEXTURE_2D, handle );
-        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = image;
-    }
-}
 
-static_inline void flushAndBindTexture(GPU_Renderer* renderer, GLuint handle)
+// GL state shadow.  GL state changes go through these, so the ones that would not change anything are skipped (and counted).
+#define GPU_GL_STATE_UNKNOWN 0xFFFFFFFF
+
+static_inline Uint8 countStateCall(GPU_CONTEXT_DATA* cdata, GPU_StateEnum state, Uint8 is_redundant)
 {
-    // Bind the texture to which subsequent calls refer
-    renderer->impl->FlushBlitBuffer(renderer);
+    #ifndef SDL_GPU_DISABLE_FRAME_STATS
+    if(is_redundant)
+        cdata->frame_stats.redundant_state_calls[state]++;
+    else
+        cdata->frame_stats.state_calls[state]++;
+    #else
+    (void)cdata;
+    (void)state;
+    #endif
+    return is_redundant;
+}
 
-    glBindTexture( GL_TEXTURE_2D, handle );
-    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = NULL;
+// Forgets all of the shadowed state, e.g. for a new context or after someone else used GL
+static void invalidateGLState(GPU_CONTEXT_DATA* cdata)
+{
+    int i;
+    
+    cdata->gl_active_texture_unit = GPU_GL_STATE_UNKNOWN;
+    for(i = 0; i < GPU_SHADOWED_TEXTURE_UNITS; i++)
+        cdata->gl_textures[i] = GPU_GL_STATE_UNKNOWN;
+    cdata->gl_framebuffer = GPU_GL_STATE_UNKNOWN;
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    cdata->bound_shader_program = GPU_GL_STATE_UNKNOWN;
+    #endif
+    cdata->gl_vertex_array = GPU_GL_STATE_UNKNOWN;
+    cdata->gl_array_buffer = GPU_GL_STATE_UNKNOWN;
+    cdata->gl_element_array_buffer = GPU_GL_STATE_UNKNOWN;
+    cdata->gl_scissor_test = GPU_GL_STATE_UNKNOWN;
+    cdata->gl_scissor[2] = -1;
+    cdata->gl_viewport[2] = -1;
+    cdata->gl_blend_func[0] = GPU_GL_STATE_UNKNOWN;
+    cdata->gl_blend_equation[0] = GPU_GL_STATE_UNKNOWN;
+    cdata->gl_known_attributes = 0;
+    cdata->gl_maybe_enabled_attributes = cdata->gl_all_attributes;
+    cdata->gl_used_attributes = 0;
+    #if defined(SDL_GPU_USE_BUFFER_PIPELINE) && !defined(SDL_GPU_NO_VAO)
+    memset(cdata->gl_vertex_arrays, 0, sizeof(cdata->gl_vertex_arrays));
+    #endif
 }
 
-// Returns false if it can't be bound
-static Uint8 bindFramebuffer(GPU_Renderer* renderer, GPU_Target* target)
+static_inline void bindTextureHandle(GPU_CONTEXT_DATA* cdata, GLuint handle)
 {
-    if(renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS)
+    Uint32 unit = cdata->gl_active_texture_unit;
+    
+    if(unit < GPU_SHADOWED_TEXTURE_UNITS)
     {
-        // Bind the FBO
-        if(target != ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target)
-        {
-            GLuint handle = 0;
-            if(target != NULL)
-                handle = ((GPU_TARGET_DATA*)target->data)->handle;
-            renderer->impl->FlushBlitBuffer(renderer);
-
-            extBindFramebuffer(renderer, handle);
-            ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = target;
-        }
-        return 1;
+        if(countStateCall(cdata, GPU_STATE_TEXTURE, cdata->gl_textures[unit] == handle))
+            return;
+        cdata->gl_textures[unit] = handle;
     }
     else
+        countStateCall(cdata, GPU_STATE_TEXTURE, 0);
+    
+    glBindTexture(GL_TEXTURE_2D, handle);
+}
+
+// Deleting a texture unbinds it
+static void forgetTextureHandle(GPU_CONTEXT_DATA* cdata, GLuint handle)
+{
+    int i;
+    for(i = 0; i < GPU_SHADOWED_TEXTURE_UNITS; i++)
     {
-        // There's only one possible render target, the default framebuffer.
-        // Note: Could check against the default framebuffer value (((GPU_TARGET_DATA*)target->data)->handle versus result of GL_FRAMEBUFFER_BINDING)...
-        if(target != NULL)
-        {
-            ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = target;
-            return 1;
-        }
-        return 0;
+        if(cdata->gl_textures[i] == handle)
+            cdata->gl_textures[i] = 0;
     }
 }
 
-static_inline void flushAndBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
+#ifndef SDL_GPU_DISABLE_SHADERS
+static_inline void setActiveTextureUnit(GPU_CONTEXT_DATA* cdata, Uint32 unit)
 {
-    // Bind the FBO
-    renderer->impl->FlushBlitBuffer(renderer);
+    if(countStateCall(cdata, GPU_STATE_TEXTURE, cdata->gl_active_texture_unit == unit))
+        return;
+    cdata->gl_active_texture_unit = unit;
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
 
-    extBindFramebuffer(renderer, handle);
-    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = NULL;
+static_inline void useProgram(GPU_CONTEXT_DATA* cdata, Uint32 program_object)
+{
+    if(countStateCall(cdata, GPU_STATE_PROGRAM, cdata->bound_shader_program == program_object))
+        return;
+    glUseProgram(program_object);
+    cdata->bound_shader_program = program_object;
 }
 
-static_inline void flushBlitBufferIfCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
+// Binds a texture to the given unit, leaving unit 0 active
+static void bindTextureHandleToUnit(GPU_CONTEXT_DATA* cdata, Uint32 unit, GLuint handle)
 {
-    if(image == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
+    if(unit < GPU_SHADOWED_TEXTURE_UNITS && cdata->gl_textures[unit] == handle)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        countStateCall(cdata, GPU_STATE_TEXTURE, 1);
+        return;
     }
+    
+    setActiveTextureUnit(cdata, unit);
+    bindTextureHandle(cdata, handle);
+    setActiveTextureUnit(cdata, 0);
 }
+#endif
 
-static_inline void flushAndClearBlitBufferIfCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
+static void extBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
 {
-    if(image == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
+    if(renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
-        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = NULL;
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        if(countStateCall(cdata, GPU_STATE_FRAMEBUFFER, cdata->gl_framebuffer == handle))
+            return;
+        cdata->gl_framebuffer = handle;
+        glBindFramebuffer(GL_FRAMEBUFFER, handle);
     }
 }
 
-static_inline Uint8 isCurrentTarget(GPU_Renderer* renderer, GPU_Target* target)
+static_inline void setScissorTest(GPU_CONTEXT_DATA* cdata, Uint8 enable)
 {
-    return (target == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target
-            || ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target == NULL);
+    if(countStateCall(cdata, GPU_STATE_SCISSOR, cdata->gl_scissor_test == enable))
+        return;
+    cdata->gl_scissor_test = enable;
+    if(enable)
+        glEnable(GL_SCISSOR_TEST);
+    else
+        glDisable(GL_SCISSOR_TEST);
 }
 
-static_inline void flushAndClearBlitBufferIfCurrentFramebuffer(GPU_Renderer* renderer, GPU_Target* target)
+static_inline void setScissor(GPU_CONTEXT_DATA* cdata, int x, int y, int w, int h)
 {
-    if(target == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target
-            || ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target == NULL)
-    {
-        renderer->impl->FlushBlitBuffer(renderer);
-        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = NULL;
-    }
+    if(countStateCall(cdata, GPU_STATE_SCISSOR, cdata->gl_scissor[0] == x && cdata->gl_scissor[1] == y && cdata->gl_scissor[2] == w && cdata->gl_scissor[3] == h))
+        return;
+    cdata->gl_scissor[0] = x;
+    cdata->gl_scissor[1] = y;
+    cdata->gl_scissor[2] = w;
+    cdata->gl_scissor[3] = h;
+    glScissor(x, y, w, h);
 }
 
-static Uint8 growBlitBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+static_inline void setViewport(GPU_CONTEXT_DATA* cdata, int x, int y, int w, int h)
 {
-	unsigned int new_max_num_vertices;
-	float* new_buffer;
-
-    if(minimum_vertices_needed <= cdata->blit_buffer_max_num_vertices)
-        return 1;
-    if(cdata->blit_buffer_max_num_vertices == GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
-        return 0;
+    if(countStateCall(cdata, GPU_STATE_VIEWPORT, cdata->gl_viewport[0] == x && cdata->gl_viewport[1] == y && cdata->gl_viewport[2] == w && cdata->gl_viewport[3] == h))
+        return;
+    cdata->gl_viewport[0] = x;
+    cdata->gl_viewport[1] = y;
+    cdata->gl_viewport[2] = w;
+    cdata->gl_viewport[3] = h;
+    glViewport(x, y, w, h);
+}
 
-    // Calculate new size (in vertices)
-    new_max_num_vertices = ((unsigned int)cdata->blit_buffer_max_num_vertices) * 2;
-    while(new_max_num_vertices <= minimum_vertices_needed)
-        new_max_num_vertices *= 2;
-    
-    if(new_max_num_vertices > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
-        new_max_num_vertices = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES;
-    
-    //GPU_LogError("Growing to %d vertices\n", new_max_num_vertices);
-    // Resize the blit buffer
-    new_buffer = (float*)SDL_malloc(new_max_num_vertices * GPU_BLIT_BUFFER_STRIDE);
-    memcpy(new_buffer, cdata->blit_buffer, cdata->blit_buffer_num_vertices * GPU_BLIT_BUFFER_STRIDE);
-    SDL_free(cdata->blit_buffer);
-    cdata->blit_buffer = new_buffer;
-    cdata->blit_buffer_max_num_vertices = new_max_num_vertices;
-    
-    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-        // Resize the VBOs
-        #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(cdata->blit_VAO);
-        #endif
-        
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[0]);
-        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[1]);
-        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
-        
-        #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(0);
-        #endif
-    #endif
-    
-    return 1;
+// Uses glBlendFunc() when the color and alpha factors match, so GPU_FEATURE_BLEND_FUNC_SEPARATE is only needed when they don't
+static void setBlendFunc(GPU_CONTEXT_DATA* cdata, GLenum source_color, GLenum dest_color, GLenum source_alpha, GLenum dest_alpha)
+{
+    if(countStateCall(cdata, GPU_STATE_BLEND, cdata->gl_blend_func[0] == source_color && cdata->gl_blend_func[1] == dest_color
+                      && cdata->gl_blend_func[2] == source_alpha && cdata->gl_blend_func[3] == dest_alpha))
+        return;
+    cdata->gl_blend_func[0] = source_color;
+    cdata->gl_blend_func[1] = dest_color;
+    cdata->gl_blend_func[2] = source_alpha;
+    cdata->gl_blend_func[3] = dest_alpha;
+    if(source_color == source_alpha && dest_color == dest_alpha)
+        glBlendFunc(source_color, dest_color);
+    else
+        glBlendFuncSeparate(source_color, dest_color, source_alpha, dest_alpha);
 }
 
-static Uint8 growIndexBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+static void setBlendEquation(GPU_CONTEXT_DATA* cdata, GLenum color_equation, GLenum alpha_equation)
 {
-	unsigned int new_max_num_vertices;
-	unsigned short* new_indices;
+    if(countStateCall(cdata, GPU_STATE_BLEND, cdata->gl_blend_equation[0] == color_equation && cdata->gl_blend_equation[1] == alpha_equation))
+        return;
+    cdata->gl_blend_equation[0] = color_equation;
+    cdata->gl_blend_equation[1] = alpha_equation;
+    if(color_equation == alpha_equation)
+        glBlendEquation(color_equation);
+    else
+        glBlendEquationSeparate(color_equation, alpha_equation);
+}
 
-    if(minimum_vertices_needed <= cdata->index_buffer_max_num_vertices)
-        return 1;
-    if(cdata->index_buffer_max_num_vertices == GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES)
-        return 0;
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+static_inline void bindBuffer(GPU_CONTEXT_DATA* cdata, GLenum target, GLuint buffer)
+{
+    Uint32* bound = (target == GL_ARRAY_BUFFER? &cdata->gl_array_buffer : &cdata->gl_element_array_buffer);
+    if(countStateCall(cdata, GPU_STATE_BUFFER, *bound == buffer))
+        return;
+    *bound = buffer;
+    glBindBuffer(target, buffer);
+}
 
-    // Calculate new size (in vertices)
-    new_max_num_vertices = cdata->index_buffer_max_num_vertices * 2;
-    while(new_max_num_vertices <= minimum_vertices_needed)
-        new_max_num_vertices *= 2;
-    
-    if(new_max_num_vertices > GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES)
-        new_max_num_vertices = GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES;
-    
-    //GPU_LogError("Growing to %d indices\n", new_max_num_vertices);
-    // Resize the index buffer
-    new_indices = (unsigned short*)SDL_malloc(new_max_num_vertices * sizeof(unsigned short));
-    memcpy(new_indices, cdata->index_buffer, cdata->index_buffer_num_vertices * sizeof(unsigned short));
-    SDL_free(cdata->index_buffer);
-    cdata->index_buffer = new_indices;
-    cdata->index_buffer_max_num_vertices = new_max_num_vertices;
-    
-    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-        // Resize the IBO
-        #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(cdata->blit_VAO);
-        #endif
-        
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * cdata->blit_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
-        
+// Deleting a buffer unbinds it
+static void forgetBuffers(GPU_CONTEXT_DATA* cdata, int num_buffers, const GLuint* buffers)
+{
+    int i;
+    for(i = 0; i < num_buffers; i++)
+    {
+        if(cdata->gl_array_buffer == buffers[i])
+            cdata->gl_array_buffer = 0;
+        if(cdata->gl_element_array_buffer == buffers[i])
+            cdata->gl_element_array_buffer = 0;
         #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(0);
+        {
+            int j;
+            for(j = 0; j < GPU_SHADOWED_VERTEX_ARRAYS; j++)
+            {
+                if(cdata->gl_vertex_arrays[j].element_array_buffer == buffers[i])
+                    cdata->gl_vertex_arrays[j].element_array_buffer = GPU_GL_STATE_UNKNOWN;
+            }
+        }
         #endif
-    #endif
-    
-    return 1;
+    }
 }
 
+#if !defined(SDL_GPU_NO_VAO)
+static int findShadowedVertexArray(GPU_CONTEXT_DATA* cdata, Uint32 vertex_array)
+{
+    int i;
+    for(i = 0; i < GPU_SHADOWED_VERTEX_ARRAYS; i++)
+    {
+        if(cdata->gl_vertex_arrays[i].handle == vertex_array)
+            return i;
+    }
+    return -1;
+}
 
-// Only for window targets, which have their own contexts.
-static void makeContextCurrent(GPU_Renderer* renderer, GPU_Target* target)
+static_inline void bindVertexArray(GPU_CONTEXT_DATA* cdata, GLuint vertex_array)
 {
-    if(target == NULL || target->context == NULL || renderer->current_context_target == target)
+    int i;
+    
+    if(countStateCall(cdata, GPU_STATE_VERTEX_ARRAY, cdata->gl_vertex_array == vertex_array))
         return;
     
-    renderer->impl->FlushBlitBuffer(renderer);
+    // The element array buffer and the enabled attributes belong to the vertex array, so keep them for when it is bound again
+    if(cdata->gl_vertex_array != 0 && cdata->gl_vertex_array != GPU_GL_STATE_UNKNOWN)
+    {
+        i = findShadowedVertexArray(cdata, cdata->gl_vertex_array);
+        if(i < 0)
+            i = findShadowedVertexArray(cdata, 0);
+        if(i >= 0)
+        {
+            cdata->gl_vertex_arrays[i].handle = cdata->gl_vertex_array;
+            cdata->gl_vertex_arrays[i].element_array_buffer = cdata->gl_element_array_buffer;
+            cdata->gl_vertex_arrays[i].enabled_attributes = cdata->gl_enabled_attributes;
+            cdata->gl_vertex_arrays[i].known_attributes = cdata->gl_known_attributes;
+            cdata->gl_vertex_arrays[i].maybe_enabled_attributes = cdata->gl_maybe_enabled_attributes;
+        }
+    }
+    
+    cdata->gl_vertex_array = vertex_array;
+    glBindVertexArray(vertex_array);
     
-    #ifdef SDL_GPU_USE_SDL2
-    SDL_GL_MakeCurrent(SDL_GetWindowFromID(target->context->windowID), target->context->context);
-    #endif
-    renderer->current_context_target = target;
+    i = (vertex_array != 0? findShadowedVertexArray(cdata, vertex_array) : -1);
+    if(i >= 0)
+    {
+        cdata->gl_element_array_buffer = cdata->gl_vertex_arrays[i].element_array_buffer;
+        cdata->gl_enabled_attributes = cdata->gl_vertex_arrays[i].enabled_attributes;
+        cdata->gl_known_attributes = cdata->gl_vertex_arrays[i].known_attributes;
+        cdata->gl_maybe_enabled_attributes = cdata->gl_vertex_arrays[i].maybe_enabled_attributes;
+    }
+    else
+    {
+        cdata->gl_element_array_buffer = GPU_GL_STATE_UNKNOWN;
+        cdata->gl_known_attributes = 0;
+        cdata->gl_maybe_enabled_attributes = cdata->gl_all_attributes;
+    }
 }
+#endif
 
-static void setClipRect(GPU_Renderer* renderer, GPU_Target* target)
+// Enables a vertex attribute array for the draw call being set up.  Arrays that the draw call doesn't enable are disabled by disableUnusedVertexAttribArrays().
+static_inline void enableVertexAttribArray(GPU_CONTEXT_DATA* cdata, int location)
 {
-    if(target->use_clip_rect)
+    Uint32 bit;
+    
+    if(location < 0)
+        return;
+    if(location >= 32)
     {
-        GPU_Target* context_target = renderer->current_context_target;
-        glEnable(GL_SCISSOR_TEST);
-        if(target->context != NULL)
-        {
-            int y;
-            if(renderer->coordinate_mode == 0)
-                y = context_target->h - (target->clip_rect.y + target->clip_rect.h);
-            else
-                y = target->clip_rect.y;
-            float xFactor = ((float)context_target->context->window_w)/context_target->w;
-            float yFactor = ((float)context_target->context->window_h)/context_target->h;
-            glScissor(target->clip_rect.x * xFactor, y * yFactor, target->clip_rect.w * xFactor, target->clip_rect.h * yFactor);
-        }
-        else
-            glScissor(target->clip_rect.x, target->clip_rect.y, target->clip_rect.w, target->clip_rect.h);
+        // Not shadowed
+        countStateCall(cdata, GPU_STATE_VERTEX_ATTRIBUTE, 0);
+        glEnableVertexAttribArray(location);
+        return;
     }
+    
+    bit = (1u << location);
+    cdata->gl_used_attributes |= bit;
+    if(countStateCall(cdata, GPU_STATE_VERTEX_ATTRIBUTE, (cdata->gl_known_attributes & cdata->gl_enabled_attributes & bit) != 0))
+        return;
+    
+    cdata->gl_known_attributes |= bit;
+    cdata->gl_enabled_attributes |= bit;
+    cdata->gl_maybe_enabled_attributes |= bit;
+    glEnableVertexAttribArray(location);
 }
 
-static void unsetClipRect(GPU_Renderer* renderer, GPU_Target* target)
+static_inline void disableVertexAttribArray(GPU_CONTEXT_DATA* cdata, int location)
 {
-	(void)renderer;
-    if(target->use_clip_rect)
-        glDisable(GL_SCISSOR_TEST);
+    Uint32 bit;
+    
+    if(location < 0)
+        return;
+    if(location >= 32)
+    {
+        countStateCall(cdata, GPU_STATE_VERTEX_ATTRIBUTE, 0);
+        glDisableVertexAttribArray(location);
+        return;
+    }
+    
+    bit = (1u << location);
+    cdata->gl_used_attributes &= ~bit;
+    if(countStateCall(cdata, GPU_STATE_VERTEX_ATTRIBUTE, (cdata->gl_known_attributes & bit) != 0 && (cdata->gl_enabled_attributes & bit) == 0))
+        return;
+    
+    cdata->gl_known_attributes |= bit;
+    cdata->gl_enabled_attributes &= ~bit;
+    glDisableVertexAttribArray(location);
 }
 
-static void prepareToRenderToTarget(GPU_Renderer* renderer, GPU_Target* target)
+// Call right before drawing.  Arrays left enabled by an earlier draw call stay enabled only if this one uses them too, which saves disabling and enabling them again for every flush.
+static void disableUnusedVertexAttribArrays(GPU_CONTEXT_DATA* cdata)
 {
-    // Set up the camera
-    renderer->impl->SetCamera(renderer, target, &target->camera);
+    Uint32 unused = cdata->gl_maybe_enabled_attributes & ~cdata->gl_used_attributes;
+    int location;
     
-    setClipRect(renderer, target);
+    for(location = 0; unused != 0; location++, unused >>= 1)
+    {
+        if(unused & 1)
+            disableVertexAttribArray(cdata, location);
+    }
+    
+    // Whatever is left is enabled on purpose
+    cdata->gl_maybe_enabled_attributes = cdata->gl_used_attributes;
+    cdata->gl_used_attributes = 0;
 }
+#endif
 
+static void flushBlitBuffer(GPU_Renderer* renderer);
 
-
-static void changeColor(GPU_Renderer* renderer, SDL_Color color)
+// Flushes the blit buffer, counting the flush under the given cause if it draws anything
+static_inline void flushBlitBufferFor(GPU_Renderer* renderer, GPU_FlushCauseEnum cause)
+{
+    #ifndef SDL_GPU_DISABLE_FRAME_STATS
+    if(renderer->current_context_target != NULL)
+        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->flush_cause = cause;
+    #else
+    (void)cause;
+    #endif
+    flushBlitBuffer(renderer);
+}
+
+static_inline void countDrawCall(GPU_CONTEXT_DATA* cdata, unsigned int num_vertices, unsigned int num_indices)
+{
+    #ifndef SDL_GPU_DISABLE_FRAME_STATS
+    cdata->frame_stats.draw_calls++;
+    cdata->frame_stats.vertices += num_vertices;
+    cdata->frame_stats.indices += num_indices;
+    #else
+    (void)cdata;
+    (void)num_vertices;
+    (void)num_indices;
+    #endif
+}
+
+// Texture memory is counted for the whole renderer, since its contexts share textures
+static GPU_MemoryStats memory_stats;
+static GPU_IMAGE_DATA* memory_lru_first;  // Least recently bound counted texture
+static GPU_IMAGE_DATA* memory_lru_last;
+
+static void countImageMemory(GPU_IMAGE_DATA* data)
+{
+    if(data->memory_bytes == 0)
+        return;
+    
+    memory_stats.num_images++;
+    if(data->evicted_pixels != NULL)
+    {
+        memory_stats.evicted_bytes += data->memory_bytes;
+        memory_stats.num_evicted_images++;
+        return;
+    }
+    
+    if(data->memory_is_target)
+        memory_stats.target_bytes += data->memory_bytes;
+    else
+        memory_stats.image_bytes += data->memory_bytes;
+    memory_stats.padding_bytes += data->padding_bytes;
+}
+
+static void uncountImageMemory(GPU_IMAGE_DATA* data)
+{
+    if(data->memory_bytes == 0)
+        return;
+    
+    memory_stats.num_images--;
+    if(data->evicted_pixels != NULL)
+    {
+        memory_stats.evicted_bytes -= data->memory_bytes;
+        memory_stats.num_evicted_images--;
+        return;
+    }
+    
+    if(data->memory_is_target)
+        memory_stats.target_bytes -= data->memory_bytes;
+    else
+        memory_stats.image_bytes -= data->memory_bytes;
+    memory_stats.padding_bytes -= data->padding_bytes;
+}
+
+static void unlinkImageMemory(GPU_IMAGE_DATA* data)
+{
+    if(data->lru_prev != NULL)
+        data->lru_prev->lru_next = data->lru_next;
+    else
+        memory_lru_first = data->lru_next;
+    if(data->lru_next != NULL)
+        data->lru_next->lru_prev = data->lru_prev;
+    else
+        memory_lru_last = data->lru_prev;
+    data->lru_prev = NULL;
+    data->lru_next = NULL;
+}
+
+static void linkImageMemory(GPU_IMAGE_DATA* data)
+{
+    data->lru_prev = memory_lru_last;
+    data->lru_next = NULL;
+    if(memory_lru_last != NULL)
+        memory_lru_last->lru_next = data;
+    else
+        memory_lru_first = data;
+    memory_lru_last = data;
+}
+
+// Moves a counted texture to the most recently bound end of the list
+static_inline void touchImageMemory(GPU_IMAGE_DATA* data)
+{
+    if(data->memory_bytes == 0 || data == memory_lru_last)
+        return;
+    
+    unlinkImageMemory(data);
+    linkImageMemory(data);
+}
+
+// Counts 'bytes' of texture memory for the image's texture, replacing whatever was counted for it before
+static void setImageMemory(GPU_Image* image, Uint64 bytes)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    Uint64 texture_area = (Uint64)image->texture_w*image->texture_h;
+    
+    uncountImageMemory(data);
+    if(data->memory_bytes == 0 && bytes != 0)
+        linkImageMemory(data);
+    if(bytes != 0 && image->renderer->current_context_target != NULL)
+        data->memory_context = image->renderer->current_context_target->context;
+    else if(data->memory_bytes != 0 && bytes == 0)
+        unlinkImageMemory(data);
+    
+    data->memory_bytes = bytes;
+    data->padding_bytes = 0;
+    if(texture_area > 0)
+        data->padding_bytes = bytes - bytes*((Uint64)image->base_w*image->base_h)/texture_area;
+    countImageMemory(data);
+}
+
+// Stops counting the texture of an image that is being freed, along with its evicted copy
+static void forgetImageMemory(GPU_IMAGE_DATA* data)
+{
+    uncountImageMemory(data);
+    if(data->memory_bytes != 0)
+        unlinkImageMemory(data);
+    data->memory_bytes = 0;
+    data->padding_bytes = 0;
+    
+    SDL_free(data->evicted_pixels);
+    data->evicted_pixels = NULL;
+}
+
+static void setImageMemoryIsTarget(GPU_IMAGE_DATA* data, Uint8 is_target)
+{
+    uncountImageMemory(data);
+    data->memory_is_target = is_target;
+    countImageMemory(data);
+}
+
+static_inline Uint8 isImageEvicted(GPU_Image* image)
+{
+    return (((GPU_IMAGE_DATA*)image->data)->evicted_pixels != NULL);
+}
+
+// Defined with the other image functions below
+static Uint8 restoreEvictedImage(GPU_Renderer* renderer, GPU_Image* image);
+static void enforceMemoryBudget(GPU_Renderer* renderer, GPU_Image* keep);
+
+// Aliases and atlas entries are separate images on one texture, so they can share a batch
+static_inline Uint8 isSameTexture(GPU_Image* a, GPU_Image* b)
+{
+    return (a == b || (a != NULL && b != NULL && a->data == b->data));
+}
+
+static void bindTexture(GPU_Renderer* renderer, GPU_Image* image)
+{
+    if(isImageEvicted(image))
+        restoreEvictedImage(renderer, image);
+    touchImageMemory((GPU_IMAGE_DATA*)image->data);
+    
+    // Bind the texture to which subsequent calls refer
+    if(!isSameTexture(image, ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image))
+    {
+        GLuint handle = ((GPU_IMAGE_DATA*)image->data)->handle;
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_TEXTURE);
+
+        bindTextureHandle((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, handle);
+        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = image;
+        GPU_ADD_FRAME_STAT((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, texture_binds, 1);
+        
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        {
+            // The batch was just flushed, so the other slots can be reused
+            GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+            cdata->texture_slots[0] = image;
+            cdata->num_texture_slots_used = 1;
+        }
+        #endif
+    }
+    
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->current_texture_slot = 0;
+    #endif
+}
+
+static_inline void flushAndBindTexture(GPU_Renderer* renderer, GLuint handle)
+{
+    // Bind the texture to which subsequent calls refer
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_TEXTURE);
+
+    bindTextureHandle((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, handle);
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = NULL;
+    GPU_ADD_FRAME_STAT((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, texture_binds, 1);
+    
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->num_texture_slots_used = 0;
+    #endif
+}
+
+#ifdef SDL_GPU_USE_TEXTURE_SLOTS
+// Texture slots only apply to sprites drawn with the default textured shader
+static_inline Uint8 canUseTextureSlots(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    return (cdata->use_texture_slots && context->current_shader_program == context->default_textured_shader_program);
+}
+
+static_inline int getTextureSlot(GPU_CONTEXT_DATA* cdata, GPU_Image* image)
+{
+    unsigned int i;
+    for(i = 0; i < cdata->num_texture_slots_used; i++)
+    {
+        if(isSameTexture(cdata->texture_slots[i], image))
+            return i;
+    }
+    return -1;
+}
+#endif
+
+// Like bindTexture(), but keeps the current batch going if the image is already in a texture slot or a slot is free
+static void bindTextureSlot(GPU_Renderer* renderer, GPU_Image* image)
+{
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    int slot;
+    
+    if(isImageEvicted(image))
+        restoreEvictedImage(renderer, image);
+    touchImageMemory((GPU_IMAGE_DATA*)image->data);
+    
+    if(canUseTextureSlots(renderer, cdata) && cdata->num_texture_slots_used > 0)
+    {
+        slot = getTextureSlot(cdata, image);
+        // Units claimed with SetShaderImage() end the run of usable slots
+        if(slot < 0 && cdata->num_texture_slots_used < GPU_MAX_TEXTURE_SLOTS
+           && !(cdata->shader_image_units & (1u << cdata->num_texture_slots_used)))
+        {
+            slot = cdata->num_texture_slots_used++;
+            cdata->texture_slots[slot] = image;
+            
+            bindTextureHandleToUnit(cdata, slot, ((GPU_IMAGE_DATA*)image->data)->handle);
+            GPU_ADD_FRAME_STAT(cdata, texture_binds, 1);
+        }
+        
+        if(slot >= 0)
+        {
+            cdata->current_texture_slot = slot;
+            return;
+        }
+    }
+    #endif
+    
+    // No free slot, so this starts a new batch
+    bindTexture(renderer, image);
+}
+
+// Returns false if it can't be bound
+static Uint8 bindFramebuffer(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS)
+    {
+        // Bind the FBO
+        if(target != ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target)
+        {
+            GLuint handle = 0;
+            if(target != NULL)
+                handle = ((GPU_TARGET_DATA*)target->data)->handle;
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_TARGET);
+
+            extBindFramebuffer(renderer, handle);
+            ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = target;
+            GPU_ADD_FRAME_STAT((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, target_switches, 1);
+        }
+        return 1;
+    }
+    else
+    {
+        // There's only one possible render target, the default framebuffer.
+        // Note: Could check against the default framebuffer value (((GPU_TARGET_DATA*)target->data)->handle versus result of GL_FRAMEBUFFER_BINDING)...
+        if(target != NULL)
+        {
+            ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = target;
+            return 1;
+        }
+        return 0;
+    }
+}
+
+static_inline void flushAndBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
+{
+    // Bind the FBO
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_TARGET);
+
+    extBindFramebuffer(renderer, handle);
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = NULL;
+    GPU_ADD_FRAME_STAT((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, target_switches, 1);
+}
+
+// Sorted blits point at their images and targets, so changing or freeing either one has to submit them first
+static_inline void flushSortedBlits(GPU_Renderer* renderer, GPU_FlushCauseEnum cause)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_blit_buffer_num_blits > 0 && !cdata->submitting_sorted_blits)
+        flushBlitBufferFor(renderer, cause);
+}
+
+// Adds to a list of what the recorded blits use.  When the list is full, the count goes past the end.
+static_inline void trackSortedBlitItem(void** items, unsigned int* num_items, unsigned int max_num_items, void* item)
+{
+    unsigned int i;
+    if(*num_items > max_num_items)
+        return;
+    for(i = 0; i < *num_items; i++)
+    {
+        if(items[i] == item)
+            return;
+    }
+    if(*num_items < max_num_items)
+        items[*num_items] = item;
+    (*num_items)++;
+}
+
+static_inline Uint8 isSortedBlitItem(void** items, unsigned int num_items, unsigned int max_num_items, void* item)
+{
+    unsigned int i;
+    if(num_items > max_num_items)
+        return 1;
+    for(i = 0; i < num_items; i++)
+    {
+        if(items[i] == item)
+            return 1;
+    }
+    return 0;
+}
+
+// Submits the sorted blits only if one of them draws this image
+static_inline void flushSortedBlitsUsingImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_blit_buffer_num_blits > 0
+       && isSortedBlitItem(cdata->sorted_blit_images, cdata->sorted_blit_num_images, GPU_SORTED_BLIT_TRACKED_IMAGES, image->data))
+        flushSortedBlits(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+}
+
+// Submits the sorted blits only if one of them draws to this target or samples its image
+static_inline void flushSortedBlitsUsingTarget(GPU_Renderer* renderer, GPU_Target* target, GPU_FlushCauseEnum cause)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->sorted_blit_buffer_num_blits > 0
+       && (isSortedBlitItem(cdata->sorted_blit_targets, cdata->sorted_blit_num_targets, GPU_SORTED_BLIT_TRACKED_TARGETS, target->data)
+           || (target->image != NULL && isSortedBlitItem(cdata->sorted_blit_images, cdata->sorted_blit_num_images, GPU_SORTED_BLIT_TRACKED_IMAGES, target->image->data))))
+        flushSortedBlits(renderer, cause);
+}
+
+static_inline Uint8 isCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
+{
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    if(getTextureSlot((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, image) >= 0)
+        return 1;
+    #endif
+    return isSameTexture(image, ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image);
+}
+
+static_inline void flushBlitBufferIfCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
+{
+    flushSortedBlitsUsingImage(renderer, image);
+    if(isCurrentTexture(renderer, image))
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+    }
+}
+
+static_inline void flushAndClearBlitBufferIfCurrentTexture(GPU_Renderer* renderer, GPU_Image* image)
+{
+    flushSortedBlitsUsingImage(renderer, image);
+    if(isCurrentTexture(renderer, image))
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = NULL;
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->num_texture_slots_used = 0;
+        #endif
+    }
+}
+
+// Callers that change or read the target call flushSortedBlitsUsingTarget() first, since sorted blits might still draw to it
+static_inline Uint8 isCurrentTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    return (target == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target
+            || ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target == NULL);
+}
+
+static_inline void flushAndClearBlitBufferIfCurrentFramebuffer(GPU_Renderer* renderer, GPU_Target* target)
+{
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+    if(target == ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target
+            || ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target == NULL)
+    {
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+        ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_target = NULL;
+    }
+}
+
+static_inline unsigned int getIndexSize(GPU_CONTEXT_DATA* cdata)
+{
+    return (cdata->index_type == GL_UNSIGNED_INT? sizeof(unsigned int) : sizeof(unsigned short));
+}
+
+static_inline void setIndex(GPU_CONTEXT_DATA* cdata, void* index_buffer, unsigned int i, unsigned int index)
+{
+    if(cdata->index_type == GL_UNSIGNED_INT)
+        ((unsigned int*)index_buffer)[i] = index;
+    else
+        ((unsigned short*)index_buffer)[i] = (unsigned short)index;
+}
+
+// Appends an index to the index buffer in the context's index format
+static_inline void pushIndex(GPU_CONTEXT_DATA* cdata, unsigned int index)
+{
+    setIndex(cdata, cdata->index_buffer, cdata->index_buffer_num_vertices++, index);
+}
+
+static_inline unsigned int getIndex(GPU_CONTEXT_DATA* cdata, void* index_buffer, unsigned int i)
+{
+    if(cdata->index_type == GL_UNSIGNED_INT)
+        return ((unsigned int*)index_buffer)[i];
+    return ((unsigned short*)index_buffer)[i];
+}
+
+// Picks the blit buffer vertex layout for a new context.  Must be called before the blit buffer is allocated.
+static void initVertexFormat(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    cdata->packed_colors = ((renderer->GPU_init_flags & GPU_INIT_USE_PACKED_COLORS) != 0);
+    cdata->packed_tex_coords = ((renderer->GPU_init_flags & GPU_INIT_USE_PACKED_TEX_COORDS) != 0);
+    
+    #ifdef SDL_GPU_USE_ARRAY_PIPELINE
+    // Fixed-function vertex arrays do not normalize integer tex coords
+    if(cdata->packed_tex_coords)
+    {
+        GPU_LogWarning("Packed texture coordinates are not supported by this renderer.  Falling back to float texture coordinates.\n");
+        cdata->packed_tex_coords = 0;
+    }
+    #endif
+    
+    cdata->blit_buffer_color_offset = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + (cdata->packed_tex_coords? 1 : 2);
+    cdata->blit_buffer_floats_per_vertex = cdata->blit_buffer_color_offset + (cdata->packed_colors? 1 : 4);
+    
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    // The texture slot goes after the color
+    cdata->use_texture_slots = !(renderer->GPU_init_flags & GPU_INIT_DISABLE_TEXTURE_SLOTS);
+    if(cdata->use_texture_slots)
+        cdata->blit_buffer_texture_slot_offset = cdata->blit_buffer_floats_per_vertex++;
+    #endif
+}
+
+static_inline Uint16 packTexCoord(float value)
+{
+    if(value <= 0.0f)
+        return 0;
+    if(value >= 1.0f)
+        return 65535;
+    return (Uint16)(value*65535.0f + 0.5f);
+}
+
+static_inline void setBlitBufferTexCoords(GPU_CONTEXT_DATA* cdata, float* blit_buffer, int tex_index, float s, float t)
+{
+    if(cdata->packed_tex_coords)
+    {
+        Uint16* st = (Uint16*)(blit_buffer + tex_index);
+        st[0] = packTexCoord(s);
+        st[1] = packTexCoord(t);
+    }
+    else
+    {
+        blit_buffer[tex_index] = s;
+        blit_buffer[tex_index+1] = t;
+    }
+}
+
+static_inline void setBlitBufferColor(GPU_CONTEXT_DATA* cdata, float* blit_buffer, int color_index, float r, float g, float b, float a)
+{
+    if(cdata->packed_colors)
+    {
+        Uint8* rgba = (Uint8*)(blit_buffer + color_index);
+        rgba[0] = (Uint8)(r*255.0f + 0.5f);
+        rgba[1] = (Uint8)(g*255.0f + 0.5f);
+        rgba[2] = (Uint8)(b*255.0f + 0.5f);
+        rgba[3] = (Uint8)(a*255.0f + 0.5f);
+    }
+    else
+    {
+        blit_buffer[color_index] = r;
+        blit_buffer[color_index+1] = g;
+        blit_buffer[color_index+2] = b;
+        blit_buffer[color_index+3] = a;
+    }
+}
+
+static_inline void setBlitBufferTextureSlot(GPU_CONTEXT_DATA* cdata, float* blit_buffer, int vert_index)
+{
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    if(cdata->use_texture_slots)
+    {
+        blit_buffer[vert_index + cdata->blit_buffer_texture_slot_offset] = (float)cdata->current_texture_slot;
+        if(cdata->current_texture_slot != 0)
+            cdata->blit_buffer_uses_texture_slots = 1;
+    }
+    #else
+    (void)cdata;
+    (void)blit_buffer;
+    (void)vert_index;
+    #endif
+}
+
+// Shape vertices in a textured batch all sample the middle of the white texel
+static_inline void setBlitBufferWhiteTexel(GPU_CONTEXT_DATA* cdata, float* blit_buffer, int vert_index)
+{
+    setBlitBufferTexCoords(cdata, blit_buffer, vert_index - GPU_BLIT_BUFFER_VERTEX_OFFSET + GPU_BLIT_BUFFER_TEX_COORD_OFFSET, 0.5f, 0.5f);
+    setBlitBufferTextureSlot(cdata, blit_buffer, vert_index);
+}
+
+#ifdef SDL_GPU_USE_FIXED_FUNCTION_PIPELINE
+static_inline void sendBlitBufferTexCoords(GPU_CONTEXT_DATA* cdata, float* tex_coords)
+{
+    if(cdata->packed_tex_coords)
+        glTexCoord2f(((Uint16*)tex_coords)[0]/65535.0f, ((Uint16*)tex_coords)[1]/65535.0f);
+    else
+        glTexCoord2f(tex_coords[0], tex_coords[1]);
+}
+
+static_inline void sendBlitBufferColor(GPU_CONTEXT_DATA* cdata, float* color)
+{
+    if(cdata->packed_colors)
+        glColor4ub(((Uint8*)color)[0], ((Uint8*)color)[1], ((Uint8*)color)[2], ((Uint8*)color)[3]);
+    else
+        glColor4f(color[0], color[1], color[2], color[3]);
+}
+#endif
+
+// Rebuilds the sprite index pattern to cover a full blit buffer.  Sprite-only flushes draw with these instead of the dynamic index buffer.
+static void buildQuadIndexBuffer(GPU_CONTEXT_DATA* cdata)
+{
+    unsigned int num_sprites = cdata->blit_buffer_max_num_vertices / GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    unsigned int i, n, v;
+    
+    SDL_free(cdata->quad_index_buffer);
+    cdata->quad_index_buffer_num_indices = num_sprites*6;
+    cdata->quad_index_buffer = SDL_malloc(cdata->quad_index_buffer_num_indices * getIndexSize(cdata));
+    
+    n = 0;
+    for(i = 0; i < num_sprites; i++)
+    {
+        v = i*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+        setIndex(cdata, cdata->quad_index_buffer, n++, v);
+        setIndex(cdata, cdata->quad_index_buffer, n++, v+1);
+        setIndex(cdata, cdata->quad_index_buffer, n++, v+2);
+        setIndex(cdata, cdata->quad_index_buffer, n++, v);
+        setIndex(cdata, cdata->quad_index_buffer, n++, v+2);
+        setIndex(cdata, cdata->quad_index_buffer, n++, v+3);
+    }
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(cdata->blit_quad_IBO != 0)
+    {
+        bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_quad_IBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, cdata->quad_index_buffer_num_indices * getIndexSize(cdata), cdata->quad_index_buffer, GL_STATIC_DRAW);
+    }
+    #endif
+}
+
+// Adds the quad index pattern for sprites that join a batch which also holds triangles.  The index buffer must already have room for them.
+static void pushQuadIndices(GPU_CONTEXT_DATA* cdata, unsigned int first_vertex, unsigned int num_sprites)
+{
+    unsigned int i, v;
+    for(i = 0; i < num_sprites; i++)
+    {
+        v = first_vertex + i*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+        pushIndex(cdata, v);
+        pushIndex(cdata, v+1);
+        pushIndex(cdata, v+2);
+        pushIndex(cdata, v);
+        pushIndex(cdata, v+2);
+        pushIndex(cdata, v+3);
+    }
+}
+
+#if defined(SDL_GPU_USE_BUFFER_PIPELINE) && !defined(SDL_GPU_NO_VAO)
+// The buffer that submit_blit_buffer() will put the next vertices in
+static_inline GLuint getBlitBufferVBO(GPU_CONTEXT_DATA* cdata)
+{
+    #ifdef SDL_GPU_USE_BUFFER_RING
+    if(cdata->blit_ring.VBO != 0)
+        return cdata->blit_ring.VBO;
+    #endif
+    return cdata->blit_VBO[cdata->blit_VBO_flop];
+}
+
+// Points the blit buffer attributes of the bound vertex array at the vertices that start at the given byte offset
+static void pointVertexFormat(GPU_CONTEXT_DATA* cdata, GPU_VERTEX_FORMAT_DATA* format, unsigned int vertex_offset)
+{
+    GLsizei stride = format->floats_per_vertex*sizeof(float);
+    int i;
+    
+    bindBuffer(cdata, GL_ARRAY_BUFFER, format->VBO);
+    if(format->position_loc >= 0)
+        glVertexAttribPointer(format->position_loc, 2, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)vertex_offset);
+    if(format->texcoord_loc >= 0)
+        glVertexAttribPointer(format->texcoord_loc, 2, (format->packed_tex_coords? GL_UNSIGNED_SHORT : GL_FLOAT), format->packed_tex_coords, stride, (void*)(size_t)(vertex_offset + GPU_BLIT_BUFFER_TEX_COORD_OFFSET * sizeof(float)));
+    if(format->color_loc >= 0)
+        glVertexAttribPointer(format->color_loc, 4, (format->packed_colors? GL_UNSIGNED_BYTE : GL_FLOAT), format->packed_colors, stride, (void*)(size_t)(vertex_offset + format->color_offset * sizeof(float)));
+    if(format->texture_slot_loc >= 0)
+        glVertexAttribPointer(format->texture_slot_loc, 1, GL_FLOAT, GL_FALSE, stride, (void*)(size_t)(vertex_offset + format->texture_slot_offset * sizeof(float)));
+    format->vertex_offset = vertex_offset;
+    
+    // These may have replaced custom attribute pointers
+    for(i = 0; i < 16; i++)
+        format->attributes[i].location = -1;
+}
+
+// Binds a vertex array that is set up for the current shader block and blit buffer layout, pointing into the given buffer.
+// Flushes with the same setup reuse it, so the attribute format is only specified once.
+static GPU_VERTEX_FORMAT_DATA* bindVertexFormat(GPU_CONTEXT_DATA* cdata, GLuint VBO, Uint8 textured)
+{
+    GPU_ShaderBlock* block = &cdata->current_shader_block;
+    int texcoord_loc = (textured? block->texcoord_loc : -1);
+    int texture_slot_loc = -1;
+    unsigned int texture_slot_offset = 0;
+    GPU_VERTEX_FORMAT_DATA* format = NULL;
+    int i;
+    
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    if(textured && cdata->blit_buffer_uses_texture_slots)
+    {
+        texture_slot_loc = cdata->texture_slot_loc;
+        texture_slot_offset = cdata->blit_buffer_texture_slot_offset;
+    }
+    #endif
+    
+    for(i = 0; i < GPU_VERTEX_FORMAT_CACHE_SIZE; i++)
+    {
+        GPU_VERTEX_FORMAT_DATA* f = &cdata->vertex_formats[i];
+        if(f->VBO == VBO && f->position_loc == block->position_loc && f->texcoord_loc == texcoord_loc && f->color_loc == block->color_loc && f->texture_slot_loc == texture_slot_loc
+           && f->floats_per_vertex == cdata->blit_buffer_floats_per_vertex && f->color_offset == cdata->blit_buffer_color_offset && f->texture_slot_offset == texture_slot_offset
+           && f->packed_tex_coords == cdata->packed_tex_coords && f->packed_colors == cdata->packed_colors)
+        {
+            format = f;
+            bindVertexArray(cdata, format->VAO);
+            break;
+        }
+    }
+    
+    if(format == NULL)
+    {
+        // Set up the oldest entry's vertex array for this format
+        format = &cdata->vertex_formats[cdata->vertex_formats_next];
+        cdata->vertex_formats_next = (cdata->vertex_formats_next + 1) % GPU_VERTEX_FORMAT_CACHE_SIZE;
+        
+        if(format->VAO == 0)
+            glGenVertexArrays(1, &format->VAO);
+        format->VBO = VBO;
+        format->position_loc = block->position_loc;
+        format->texcoord_loc = texcoord_loc;
+        format->color_loc = block->color_loc;
+        format->texture_slot_loc = texture_slot_loc;
+        format->floats_per_vertex = cdata->blit_buffer_floats_per_vertex;
+        format->color_offset = cdata->blit_buffer_color_offset;
+        format->texture_slot_offset = texture_slot_offset;
+        format->packed_tex_coords = cdata->packed_tex_coords;
+        format->packed_colors = cdata->packed_colors;
+        
+        bindVertexArray(cdata, format->VAO);
+        pointVertexFormat(cdata, format, 0);
+    }
+    
+    // Already enabled in a reused vertex array, so these just mark the arrays as used
+    enableVertexAttribArray(cdata, format->position_loc);
+    enableVertexAttribArray(cdata, format->texcoord_loc);
+    enableVertexAttribArray(cdata, format->color_loc);
+    enableVertexAttribArray(cdata, format->texture_slot_loc);
+    return format;
+}
+
+// The cached vertex array (if any) that is bound right now
+static GPU_VERTEX_FORMAT_DATA* getBoundVertexFormat(GPU_CONTEXT_DATA* cdata)
+{
+    int i;
+    for(i = 0; i < GPU_VERTEX_FORMAT_CACHE_SIZE; i++)
+    {
+        if(cdata->vertex_formats[i].VBO != 0 && cdata->vertex_formats[i].VAO == cdata->gl_vertex_array)
+            return &cdata->vertex_formats[i];
+    }
+    return NULL;
+}
+
+// A base vertex would offset the custom attributes as well as the blit buffer.  This asks before upload_attribute_data() has enabled them.
+static Uint8 usesCustomAttributes(GPU_CONTEXT_DATA* cdata)
+{
+    int i;
+    for(i = 0; i < 16; i++)
+    {
+        GPU_AttributeSource* a = &cdata->shader_attributes[i];
+        if(a->attribute.values != NULL && a->attribute.location >= 0 && a->num_values > 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Makes the vertex array from bindVertexFormat() reach the blit buffer vertices that were submitted at the given byte offset, and returns the base vertex to draw them with.
+// This has to come before upload_attribute_data(), whose custom attribute sources may replace blit buffer attributes.
+static unsigned int settleVertexFormat(GPU_CONTEXT_DATA* cdata, GPU_VERTEX_FORMAT_DATA* format, unsigned int vertex_offset)
+{
+    unsigned int stride = format->floats_per_vertex*sizeof(float);
+    
+    if(vertex_offset == format->vertex_offset)
+        return 0;
+    
+    // Offset the indices instead of pointing the attributes somewhere else
+    if(cdata->use_base_vertex && format->vertex_offset == 0 && vertex_offset % stride == 0 && !usesCustomAttributes(cdata))
+        return vertex_offset/stride;
+    
+    pointVertexFormat(cdata, format, vertex_offset);
+    return 0;
+}
+
+static void drawVertexFormat(GPU_CONTEXT_DATA* cdata, unsigned int base_vertex, unsigned int num_indices)
+{
+    if(base_vertex != 0)
+        glDrawElementsBaseVertex(cdata->last_shape, num_indices, cdata->index_type, (void*)0, base_vertex);
+    else
+        glDrawElements(cdata->last_shape, num_indices, cdata->index_type, (void*)0);
+}
+
+// Returns true if the bound cached vertex array doesn't point the custom attribute at this data yet, and remembers that it will
+static Uint8 updateAttributePointer(GPU_VERTEX_FORMAT_DATA* format, int index, GPU_AttributeSource* a, GLuint buffer, unsigned int offset_bytes)
+{
+    GPU_VERTEX_ATTRIBUTE_DATA* f = &format->attributes[index];
+    if(f->location == a->attribute.location && f->num_elems_per_value == a->attribute.format.num_elems_per_value && f->type == (Uint32)a->attribute.format.type
+       && f->normalize == a->attribute.format.normalize && f->stride_bytes == a->per_vertex_storage_stride_bytes && f->buffer == buffer && f->offset_bytes == offset_bytes)
+        return 0;
+    
+    f->location = a->attribute.location;
+    f->num_elems_per_value = a->attribute.format.num_elems_per_value;
+    f->type = a->attribute.format.type;
+    f->normalize = a->attribute.format.normalize;
+    f->stride_bytes = a->per_vertex_storage_stride_bytes;
+    f->buffer = buffer;
+    f->offset_bytes = offset_bytes;
+    
+    // Replacing one of the blit buffer attributes means that it needs pointing again next time
+    if(f->location == format->position_loc || f->location == format->texcoord_loc || f->location == format->color_loc || f->location == format->texture_slot_loc)
+        format->vertex_offset = GPU_GL_STATE_UNKNOWN;
+    return 1;
+}
+
+// Deleting a buffer leaves the vertex arrays that point into it with a dead buffer, even if the name comes back
+static void forgetVertexFormats(GPU_CONTEXT_DATA* cdata, GLuint VBO)
+{
+    int i, j;
+    for(i = 0; i < GPU_VERTEX_FORMAT_CACHE_SIZE; i++)
+    {
+        if(cdata->vertex_formats[i].VBO == VBO)
+            cdata->vertex_formats[i].VBO = 0;
+        for(j = 0; j < 16; j++)
+        {
+            if(cdata->vertex_formats[i].attributes[j].buffer == VBO)
+                cdata->vertex_formats[i].attributes[j].location = -1;
+        }
+    }
+}
+#endif
+
+#ifdef SDL_GPU_USE_BUFFER_RING
+static_inline void bindRing(GPU_CONTEXT_DATA* cdata, GPU_RING_BUFFER_DATA* ring)
+{
+    if(ring->target == GL_ARRAY_BUFFER)
+        bindBuffer(cdata, GL_ARRAY_BUFFER, ring->VBO);
+    else
+        glBindBuffer(ring->target, ring->VBO);
+}
+
+// Pixel unpack buffers have to be unbound again, or else client memory uploads would be read from the buffer.
+static_inline void unbindRing(GPU_RING_BUFFER_DATA* ring)
+{
+    if(ring->target != GL_ARRAY_BUFFER)
+        glBindBuffer(ring->target, 0);
+}
+
+// Blocks until the GPU is done reading from the given ring region.
+static void waitForRingRegion(GPU_RING_BUFFER_DATA* ring, unsigned int region)
+{
+    GLsync fence = (GLsync)ring->fences[region];
+    GLenum result;
+    
+    if(fence == NULL)
+        return;
+    
+    do
+    {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+    }
+    while(result == GL_TIMEOUT_EXPIRED);
+    
+    glDeleteSync(fence);
+    ring->fences[region] = NULL;
+}
+
+static void freeRing(GPU_CONTEXT_DATA* cdata, GPU_RING_BUFFER_DATA* ring)
+{
+    unsigned int i;
+    
+    for(i = 0; i < GPU_BLIT_RING_NUM_REGIONS; i++)
+    {
+        if(ring->fences[i] != NULL)
+        {
+            glDeleteSync((GLsync)ring->fences[i]);
+            ring->fences[i] = NULL;
+        }
+    }
+    
+    if(ring->VBO != 0)
+    {
+        if(ring->mapping != NULL)
+        {
+            bindRing(cdata, ring);
+            glUnmapBuffer(ring->target);
+            unbindRing(ring);
+            ring->mapping = NULL;
+        }
+        forgetBuffers(cdata, 1, &ring->VBO);
+        forgetVertexFormats(cdata, ring->VBO);
+        glDeleteBuffers(1, &ring->VBO);
+        ring->VBO = 0;
+    }
+}
+
+// (Re)creates the ring for the given buffer target with the given room in each region.
+// Without GL_ARB_sync, the ring is left disabled (VBO is 0) and the caller has to fall back to reallocating its buffers.
+static void createRing(GPU_CONTEXT_DATA* cdata, GPU_RING_BUFFER_DATA* ring, GLenum target, unsigned int region_size)
+{
+    GLsizeiptr ring_size = (GLsizeiptr)region_size * GPU_BLIT_RING_NUM_REGIONS;
+    
+    freeRing(cdata, ring);
+    
+    ring->target = target;
+    ring->region_size = region_size;
+    ring->region = 0;
+    ring->offset = 0;
+    
+    if(!isExtensionSupported("GL_ARB_sync"))
+        return;
+    
+    glGenBuffers(1, &ring->VBO);
+    bindRing(cdata, ring);
+    
+    if(isExtensionSupported("GL_ARB_buffer_storage"))
+    {
+        // Map once and keep writing straight into GPU-visible memory
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target, ring_size, NULL, flags);
+        ring->mapping = (Uint8*)glMapBufferRange(target, 0, ring_size, flags);
+    }
+    else
+        glBufferData(target, ring_size, NULL, GL_STREAM_DRAW);
+    
+    unbindRing(ring);
+}
+
+// Makes sure that the next writes, adding up to the given number of bytes, all fit in the current region.
+// Data that is drawn together has to share a region, since a region's fence only covers the draws that came before it.
+static void reserveRing(GPU_RING_BUFFER_DATA* ring, unsigned int bytes, unsigned int alignment)
+{
+    ring->offset = (ring->offset + alignment - 1)/alignment*alignment;
+    
+    if(ring->offset + bytes > ring->region_size)
+    {
+        // This region is full.  Fence it off and move on to the next one once the GPU is done with it.
+        ring->fences[ring->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring->region = (ring->region + 1) % GPU_BLIT_RING_NUM_REGIONS;
+        ring->offset = 0;
+        waitForRingRegion(ring, ring->region);
+    }
+}
+
+// Copies data into the ring, starting at a multiple of the given alignment and leaving the ring bound to GL_ARRAY_BUFFER.  Returns the byte offset of the data within the ring.
+static unsigned int writeRing(GPU_CONTEXT_DATA* cdata, GPU_RING_BUFFER_DATA* ring, unsigned int bytes, unsigned int alignment, const void* values)
+{
+    unsigned int offset;
+    
+    bindBuffer(cdata, GL_ARRAY_BUFFER, ring->VBO);
+    
+    reserveRing(ring, bytes, alignment);
+    
+    offset = ring->region * ring->region_size + ring->offset;
+    
+    if(ring->mapping != NULL)
+        memcpy(ring->mapping + offset, values, bytes);
+    else
+    {
+        // The fences already guarantee that this range is not in use
+        void* data = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if(data != NULL)
+        {
+            memcpy(data, values, bytes);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        else
+            glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, values);
+    }
+    
+    ring->offset += bytes;
+    return offset;
+}
+#endif
+
+static Uint8 growBlitBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+{
+	unsigned int new_max_num_vertices;
+	float* new_buffer;
+
+    if(minimum_vertices_needed <= cdata->blit_buffer_max_num_vertices)
+        return 1;
+    if(cdata->blit_buffer_max_num_vertices >= cdata->blit_buffer_vertex_limit)
+        return 0;
+
+    // Calculate new size (in vertices)
+    new_max_num_vertices = cdata->blit_buffer_max_num_vertices * 2;
+    while(new_max_num_vertices <= minimum_vertices_needed)
+        new_max_num_vertices *= 2;
+    
+    if(new_max_num_vertices > cdata->blit_buffer_vertex_limit)
+        new_max_num_vertices = cdata->blit_buffer_vertex_limit;
+    
+    //GPU_LogError("Growing to %d vertices\n", new_max_num_vertices);
+    // Resize the blit buffer
+    new_buffer = (float*)SDL_malloc(new_max_num_vertices * GPU_BLIT_BUFFER_STRIDE(cdata));
+    memcpy(new_buffer, cdata->blit_buffer, cdata->blit_buffer_num_vertices * GPU_BLIT_BUFFER_STRIDE(cdata));
+    SDL_free(cdata->blit_buffer);
+    cdata->blit_buffer = new_buffer;
+    cdata->blit_buffer_max_num_vertices = new_max_num_vertices;
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+        // Resize the VBOs
+        #if !defined(SDL_GPU_NO_VAO)
+        bindVertexArray(cdata, cdata->blit_VAO);
+        #endif
+        
+        bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->blit_VBO[0]);
+        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE(cdata) * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
+        bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->blit_VBO[1]);
+        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE(cdata) * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
+        
+        #ifdef SDL_GPU_USE_BUFFER_RING
+        createRing(cdata, &cdata->blit_ring, GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE(cdata) * cdata->blit_buffer_max_num_vertices);
+        #endif
+        
+        buildQuadIndexBuffer(cdata);
+    #else
+        buildQuadIndexBuffer(cdata);
+    #endif
+    
+    return 1;
+}
+
+static Uint8 growIndexBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_vertices_needed)
+{
+	unsigned int new_max_num_vertices;
+	void* new_indices;
+
+    if(minimum_vertices_needed <= cdata->index_buffer_max_num_vertices)
+        return 1;
+    if(cdata->index_buffer_max_num_vertices == GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES)
+        return 0;
+
+    // Calculate new size (in vertices)
+    new_max_num_vertices = cdata->index_buffer_max_num_vertices * 2;
+    while(new_max_num_vertices <= minimum_vertices_needed)
+        new_max_num_vertices *= 2;
+    
+    if(new_max_num_vertices > GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES)
+        new_max_num_vertices = GPU_INDEX_BUFFER_ABSOLUTE_MAX_VERTICES;
+    
+    //GPU_LogError("Growing to %d indices\n", new_max_num_vertices);
+    // Resize the index buffer
+    new_indices = SDL_malloc(new_max_num_vertices * getIndexSize(cdata));
+    memcpy(new_indices, cdata->index_buffer, cdata->index_buffer_num_vertices * getIndexSize(cdata));
+    SDL_free(cdata->index_buffer);
+    cdata->index_buffer = new_indices;
+    cdata->index_buffer_max_num_vertices = new_max_num_vertices;
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+        // Resize the IBO
+        #if !defined(SDL_GPU_NO_VAO)
+        bindVertexArray(cdata, cdata->blit_VAO);
+        #endif
+        
+        bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize(cdata) * cdata->index_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
+        
+    #endif
+    
+    return 1;
+}
+
+// Makes room for more indices in a textured batch.  Sprites already in it rely on the quad indices, so those are written out first.
+static void useIndexBufferForSprites(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsigned int num_additional_indices)
+{
+    unsigned int num_sprite_indices = 0;
+    if(!cdata->blit_buffer_uses_index_buffer)
+        num_sprite_indices = cdata->blit_buffer_num_vertices * 3 / 2;
+    
+    if(cdata->index_buffer_num_vertices + num_sprite_indices + num_additional_indices >= cdata->index_buffer_max_num_vertices)
+    {
+        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_sprite_indices + num_additional_indices))
+        {
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+            num_sprite_indices = 0;
+        }
+    }
+    
+    if(!cdata->blit_buffer_uses_index_buffer)
+    {
+        memcpy(cdata->index_buffer, cdata->quad_index_buffer, num_sprite_indices * getIndexSize(cdata));
+        cdata->index_buffer_num_vertices = num_sprite_indices;
+        cdata->blit_buffer_uses_index_buffer = 1;
+    }
+}
+
+// Picks the index type and batch capacity for a new context.  Must be called before the GPU buffers are created.
+static void initBatchLimits(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    unsigned int max_vertices = GPU_GetMaxBatchVertices();
+    Uint8 use_32bit_indices = 0;
+    
+    if(renderer->GPU_init_flags & GPU_INIT_USE_32BIT_INDICES)
+    {
+        #ifdef SDL_GPU_USE_GLES
+        use_32bit_indices = isExtensionSupported("GL_OES_element_index_uint");
+        #else
+        use_32bit_indices = 1;
+        #endif
+        
+        if(!use_32bit_indices)
+            GPU_LogWarning("32-bit indices are not supported by this renderer.  Falling back to 16-bit indices.\n");
+    }
+    
+    if(use_32bit_indices)
+    {
+        if(max_vertices == 0)
+            max_vertices = GPU_BLIT_BUFFER_DEFAULT_MAX_VERTICES_32BIT;
+    }
+    else if(max_vertices == 0 || max_vertices > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
+        max_vertices = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES;
+    
+    if(max_vertices < GPU_BLIT_BUFFER_VERTICES_PER_SPRITE)
+        max_vertices = GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    
+    cdata->blit_buffer_vertex_limit = max_vertices;
+    if(cdata->blit_buffer_max_num_vertices > max_vertices)
+        cdata->blit_buffer_max_num_vertices = max_vertices;
+    
+    if(use_32bit_indices != (cdata->index_type == GL_UNSIGNED_INT))
+    {
+        // Nothing has been batched in this context yet, so the index storage can simply be replaced
+        cdata->index_type = (use_32bit_indices? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT);
+        SDL_free(cdata->index_buffer);
+        cdata->index_buffer = SDL_malloc(cdata->index_buffer_max_num_vertices * getIndexSize(cdata));
+        cdata->index_buffer_num_vertices = 0;
+        cdata->blit_buffer_num_vertices = 0;
+    }
+    
+    buildQuadIndexBuffer(cdata);
+}
+
+#ifdef SDL_GPU_USE_INSTANCING
+static Uint8 growInstanceBuffer(GPU_CONTEXT_DATA* cdata, unsigned int minimum_instances_needed)
+{
+    unsigned int new_max_num_instances;
+    unsigned int instance_limit = cdata->blit_buffer_vertex_limit / GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    float* new_buffer;
+    
+    if(minimum_instances_needed <= cdata->instance_buffer_max_num_instances)
+        return 1;
+    if(cdata->instance_buffer_max_num_instances >= instance_limit)
+        return 0;
+    
+    // Calculate new size (in instances)
+    new_max_num_instances = cdata->instance_buffer_max_num_instances * 2;
+    while(new_max_num_instances <= minimum_instances_needed)
+        new_max_num_instances *= 2;
+    
+    if(new_max_num_instances > instance_limit)
+        new_max_num_instances = instance_limit;
+    
+    new_buffer = (float*)SDL_malloc(new_max_num_instances * GPU_INSTANCE_BUFFER_STRIDE);
+    memcpy(new_buffer, cdata->instance_buffer, cdata->instance_buffer_num_instances * GPU_INSTANCE_BUFFER_STRIDE);
+    SDL_free(cdata->instance_buffer);
+    cdata->instance_buffer = new_buffer;
+    cdata->instance_buffer_max_num_instances = new_max_num_instances;
+    
+    return 1;
+}
+
+static void setInstanceAttribute(int location, int num_elements, GLenum type, GLboolean normalized, unsigned int offset_floats)
+{
+    if(location < 0)
+        return;
+    
+    glEnableVertexAttribArray(location);
+    glVertexAttribPointer(location, num_elements, type, normalized, GPU_INSTANCE_BUFFER_STRIDE, (void*)(offset_floats * sizeof(float)));
+    glVertexAttribDivisor(location, 1);
+}
+
+#ifdef SDL_GPU_USE_TEXTURE_SLOTS
+// Points the sampler array of a texture slot program at texture units 0 and up
+static void setTextureSlotSamplers(GPU_CONTEXT_DATA* cdata, Uint32 program_object)
+{
+    int units[GPU_MAX_TEXTURE_SLOTS];
+    int location = glGetUniformLocation(program_object, "gpu_TextureSlots");
+    int i;
+    
+    if(location < 0)
+        return;
+    
+    for(i = 0; i < GPU_MAX_TEXTURE_SLOTS; i++)
+        units[i] = i;
+    
+    useProgram(cdata, program_object);
+    glUniform1iv(location, GPU_MAX_TEXTURE_SLOTS, units);
+}
+
+// Builds the texture slot program for a new context.  Returns its fragment shader, or 0 if texture slots stay disabled.
+static Uint32 initTextureSlots(GPU_Renderer* renderer, GPU_Target* target)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)target->context->data;
+    const char* vertex_shader_source = GPU_DEFAULT_TEXTURE_SLOTS_VERTEX_SHADER_SOURCE;
+    const char* fragment_shader_source = GPU_DEFAULT_TEXTURE_SLOTS_FRAGMENT_SHADER_SOURCE;
+    GLint max_texture_units = 0;
+    Uint32 v, f, p;
+    
+    // initVertexFormat() already reserved room for the slot, so a failure here just leaves it unused
+    if(!cdata->use_texture_slots)
+        return 0;
+    cdata->use_texture_slots = 0;
+    
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_texture_units);
+    if(max_texture_units < GPU_MAX_TEXTURE_SLOTS)
+        return 0;
+    
+    #ifdef SDL_GPU_ENABLE_CORE_SHADERS
+    if(renderer->id.major_version == 3 && renderer->id.minor_version >= 2)
+    {
+        vertex_shader_source = GPU_DEFAULT_TEXTURE_SLOTS_VERTEX_SHADER_SOURCE_CORE;
+        fragment_shader_source = GPU_DEFAULT_TEXTURE_SLOTS_FRAGMENT_SHADER_SOURCE_CORE;
+    }
+    #endif
+    
+    v = renderer->impl->CompileShader(renderer, GPU_VERTEX_SHADER, vertex_shader_source);
+    f = renderer->impl->CompileShader(renderer, GPU_FRAGMENT_SHADER, fragment_shader_source);
+    if(!v || !f)
+    {
+        GPU_LogWarning("Failed to load the texture slot shaders: %s.  Texture slots are disabled.\n", GPU_GetShaderMessage());
+        return 0;
+    }
+    
+    p = renderer->impl->CreateShaderProgram(renderer);
+    renderer->impl->AttachShader(renderer, p, v);
+    renderer->impl->AttachShader(renderer, p, f);
+    if(!renderer->impl->LinkShaderProgram(renderer, p))
+    {
+        GPU_LogWarning("Failed to link the texture slot shader program: %s.  Texture slots are disabled.\n", GPU_GetShaderMessage());
+        return 0;
+    }
+    
+    cdata->texture_slots_shader_program = p;
+    cdata->texture_slots_shader_block = GPU_LoadShaderBlock(p, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+    cdata->texture_slot_loc = glGetAttribLocation(p, "gpu_TextureSlot");
+    setTextureSlotSamplers(cdata, p);
+    
+    cdata->num_texture_slots_used = 0;
+    cdata->current_texture_slot = 0;
+    cdata->use_texture_slots = 1;
+    return f;
+}
+#endif
+
+// Builds the instanced sprite program and its buffers for a new context.  Instancing just stays disabled if anything is unavailable.
+static void initInstancedSprites(GPU_Renderer* renderer, GPU_Target* target, Uint32 textured_fragment_shader)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)target->context->data;
+    const char* instanced_vertex_shader_source = GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE;
+    Uint32 v, p;
+    
+    cdata->use_instancing = 0;
+    
+    if(renderer->GPU_init_flags & GPU_INIT_DISABLE_INSTANCING)
+        return;
+    
+    // Instanced attributes (glVertexAttribDivisor) are core since OpenGL 3.3
+    if(renderer->id.major_version < 3 || (renderer->id.major_version == 3 && renderer->id.minor_version < 3))
+        return;
+    
+    #ifdef SDL_GPU_ENABLE_CORE_SHADERS
+    // Match the version of the default textured fragment shader
+    if(renderer->id.major_version == 3 && renderer->id.minor_version >= 2)
+        instanced_vertex_shader_source = GPU_DEFAULT_INSTANCED_VERTEX_SHADER_SOURCE_CORE;
+    #endif
+    
+    v = renderer->impl->CompileShader(renderer, GPU_VERTEX_SHADER, instanced_vertex_shader_source);
+    if(!v)
+    {
+        GPU_LogWarning("Failed to load the instanced sprite vertex shader: %s.  Instancing is disabled.\n", GPU_GetShaderMessage());
+        return;
+    }
+    
+    p = renderer->impl->CreateShaderProgram(renderer);
+    renderer->impl->AttachShader(renderer, p, v);
+    renderer->impl->AttachShader(renderer, p, textured_fragment_shader);
+    if(!renderer->impl->LinkShaderProgram(renderer, p))
+    {
+        GPU_LogWarning("Failed to link the instanced sprite shader program: %s.  Instancing is disabled.\n", GPU_GetShaderMessage());
+        return;
+    }
+    
+    cdata->instanced_shader_program = p;
+    cdata->instanced_modelViewProjection_loc = glGetUniformLocation(p, "gpu_ModelViewProjectionMatrix");
+    
+    cdata->instance_buffer_max_num_instances = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES / GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    cdata->instance_buffer_num_instances = 0;
+    cdata->instance_buffer = (float*)SDL_malloc(cdata->instance_buffer_max_num_instances * GPU_INSTANCE_BUFFER_STRIDE);
+    
+    // The VAO keeps the per-instance attribute layout, so flushes only have to upload the records
+    glGenVertexArrays(1, &cdata->instance_VAO);
+    bindVertexArray(cdata, cdata->instance_VAO);
+    glGenBuffers(1, &cdata->instance_VBO);
+    bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->instance_VBO);
+    
+    setInstanceAttribute(glGetAttribLocation(p, "gpu_InstanceCorners"), 4, GL_FLOAT, GL_FALSE, 0);
+    setInstanceAttribute(glGetAttribLocation(p, "gpu_InstanceTransform"), 3, GL_FLOAT, GL_FALSE, 4);
+    setInstanceAttribute(glGetAttribLocation(p, "gpu_InstanceTexCoords"), 4, GL_FLOAT, GL_FALSE, 7);
+    setInstanceAttribute(glGetAttribLocation(p, "gpu_InstanceColor"), 4, GL_UNSIGNED_BYTE, GL_TRUE, 11);
+    setInstanceAttribute(glGetAttribLocation(p, "gpu_InstanceTextureSlot"), 1, GL_FLOAT, GL_FALSE, 12);
+    
+    // Back to the blit VAO, which the rest of the context setup expects
+    bindVertexArray(cdata, cdata->blit_VAO);
+    
+    cdata->use_instancing = 1;
+}
+#endif
+
+
+// Only for window targets, which have their own contexts.
+static void makeContextCurrent(GPU_Renderer* renderer, GPU_Target* target)
+{
+    if(target == NULL || target->context == NULL || renderer->current_context_target == target)
+        return;
+    
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_TARGET);
+    
+    #ifdef SDL_GPU_USE_SDL2
+    SDL_GL_MakeCurrent(SDL_GetWindowFromID(target->context->windowID), target->context->context);
+    #endif
+    renderer->current_context_target = target;
+    GPU_ADD_FRAME_STAT((GPU_CONTEXT_DATA*)target->context->data, target_switches, 1);
+}
+
+// The scissor test stays as it is after drawing, so only a change of clip rect costs GL calls.  Anything that must not be clipped (e.g. clearing the whole window) has to turn it off.
+static void setClipRect(GPU_Renderer* renderer, GPU_Target* target)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(target->use_clip_rect)
+    {
+        GPU_Target* context_target = renderer->current_context_target;
+        setScissorTest(cdata, 1);
+        if(target->context != NULL)
+        {
+            int y;
+            if(renderer->coordinate_mode == 0)
+                y = context_target->h - (target->clip_rect.y + target->clip_rect.h);
+            else
+                y = target->clip_rect.y;
+            float xFactor = ((float)context_target->context->window_w)/context_target->w;
+            float yFactor = ((float)context_target->context->window_h)/context_target->h;
+            setScissor(cdata, target->clip_rect.x * xFactor, y * yFactor, target->clip_rect.w * xFactor, target->clip_rect.h * yFactor);
+        }
+        else
+            setScissor(cdata, target->clip_rect.x, target->clip_rect.y, target->clip_rect.w, target->clip_rect.h);
+    }
+    else
+        setScissorTest(cdata, 0);
+}
+
+// Returns true if culling is on and the box (in target coordinates) can't touch the visible part of the target.  Counts what it culls.
+static Uint8 isCulled(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1, float x2, float y2)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    GPU_Camera* camera = &target->camera;
+    float center_x, center_y;
+    float min_x, min_y, max_x, max_y;
+    float view_x1, view_y1, view_x2, view_y2;
+    
+    if(!cdata->use_culling)
+        return 0;
+    
+    // Move the box through the camera the same way as applyTargetCamera(), so the visible area is (0, 0, w, h)
+    center_x = target->w/2.0f;
+    center_y = target->h/2.0f;
+    if(camera->angle == 0.0f)
+    {
+        min_x = camera->zoom*(x1 - camera->x - center_x) + center_x;
+        max_x = camera->zoom*(x2 - camera->x - center_x) + center_x;
+        min_y = camera->zoom*(y1 - camera->y - center_y) + center_y;
+        max_y = camera->zoom*(y2 - camera->y - center_y) + center_y;
+        if(min_x > max_x)
+        {
+            float temp = min_x;
+            min_x = max_x;
+            max_x = temp;
+        }
+        if(min_y > max_y)
+        {
+            float temp = min_y;
+            min_y = max_y;
+            max_y = temp;
+        }
+    }
+    else
+    {
+        float corners[8];
+        float sin_angle, cos_angle;
+        int i;
+        
+        corners[0] = x1; corners[1] = y1;
+        corners[2] = x2; corners[3] = y1;
+        corners[4] = x2; corners[5] = y2;
+        corners[6] = x1; corners[7] = y2;
+        
+        GPU_SinCos(camera->angle*M_PI/180, &sin_angle, &cos_angle);
+        
+        for(i = 0; i < 8; i += 2)
+        {
+            // Zoom about the camera center, then rotate about the target center
+            float zoomed_x = camera->x + camera->zoom*(corners[i] - camera->x - center_x);
+            float zoomed_y = camera->y + camera->zoom*(corners[i+1] - camera->y - center_y);
+            float view_x = center_x + cos_angle*zoomed_x - sin_angle*zoomed_y - camera->x;
+            float view_y = center_y + sin_angle*zoomed_x + cos_angle*zoomed_y - camera->y;
+            
+            if(i == 0 || view_x < min_x)
+                min_x = view_x;
+            if(i == 0 || view_x > max_x)
+                max_x = view_x;
+            if(i == 0 || view_y < min_y)
+                min_y = view_y;
+            if(i == 0 || view_y > max_y)
+                max_y = view_y;
+        }
+    }
+    
+    view_x1 = 0.0f;
+    view_y1 = 0.0f;
+    view_x2 = target->w;
+    view_y2 = target->h;
+    if(target->use_clip_rect)
+    {
+        if(target->clip_rect.x > view_x1)
+            view_x1 = target->clip_rect.x;
+        if(target->clip_rect.y > view_y1)
+            view_y1 = target->clip_rect.y;
+        if(target->clip_rect.x + target->clip_rect.w < view_x2)
+            view_x2 = target->clip_rect.x + target->clip_rect.w;
+        if(target->clip_rect.y + target->clip_rect.h < view_y2)
+            view_y2 = target->clip_rect.y + target->clip_rect.h;
+    }
+    
+    if(max_x < view_x1 || min_x > view_x2 || max_y < view_y1 || min_y > view_y2)
+    {
+        GPU_ADD_FRAME_STAT(cdata, culled_primitives, 1);
+        return 1;
+    }
+    return 0;
+}
+
+#ifndef SDL_GPU_DISABLE_SHADERS
+
+// Which glUniform*() call a shadowed uniform is committed with
+#define GPU_UNIFORM_TYPE_INT 0
+#define GPU_UNIFORM_TYPE_UINT 1
+#define GPU_UNIFORM_TYPE_FLOAT 2
+#define GPU_UNIFORM_TYPE_MATRIX 3
+
+#if defined(SDL_GPU_USE_GLES)
+// Hide these symbols so it compiles, but make sure they never get called because GLES only supports square matrices.
+#define glUniformMatrix2x3fv glUniformMatrix2fv
+#define glUniformMatrix2x4fv glUniformMatrix2fv
+#define glUniformMatrix3x2fv glUniformMatrix2fv
+#define glUniformMatrix3x4fv glUniformMatrix2fv
+#define glUniformMatrix4x2fv glUniformMatrix2fv
+#define glUniformMatrix4x3fv glUniformMatrix2fv
+#endif
+
+static void sendUniform(GPU_UNIFORM_DATA* u)
+{
+    int location = u->location;
+    int num_values = u->num_values;
+    
+    switch(u->type)
+    {
+    case GPU_UNIFORM_TYPE_INT:
+        {
+            int* values = (int*)u->values;
+            switch(u->num_elements)
+            {
+                case 1:
+                glUniform1iv(location, num_values, values);
+                break;
+                case 2:
+                glUniform2iv(location, num_values, values);
+                break;
+                case 3:
+                glUniform3iv(location, num_values, values);
+                break;
+                case 4:
+                glUniform4iv(location, num_values, values);
+                break;
+            }
+        }
+        break;
+    case GPU_UNIFORM_TYPE_UINT:
+        {
+            #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
+            int* values = (int*)u->values;
+            switch(u->num_elements)
+            {
+                case 1:
+                glUniform1iv(location, num_values, values);
+                break;
+                case 2:
+                glUniform2iv(location, num_values, values);
+                break;
+                case 3:
+                glUniform3iv(location, num_values, values);
+                break;
+                case 4:
+                glUniform4iv(location, num_values, values);
+                break;
+            }
+            #else
+            unsigned int* values = (unsigned int*)u->values;
+            switch(u->num_elements)
+            {
+                case 1:
+                glUniform1uiv(location, num_values, values);
+                break;
+                case 2:
+                glUniform2uiv(location, num_values, values);
+                break;
+                case 3:
+                glUniform3uiv(location, num_values, values);
+                break;
+                case 4:
+                glUniform4uiv(location, num_values, values);
+                break;
+            }
+            #endif
+        }
+        break;
+    case GPU_UNIFORM_TYPE_FLOAT:
+        {
+            float* values = (float*)u->values;
+            switch(u->num_elements)
+            {
+                case 1:
+                glUniform1fv(location, num_values, values);
+                break;
+                case 2:
+                glUniform2fv(location, num_values, values);
+                break;
+                case 3:
+                glUniform3fv(location, num_values, values);
+                break;
+                case 4:
+                glUniform4fv(location, num_values, values);
+                break;
+            }
+        }
+        break;
+    case GPU_UNIFORM_TYPE_MATRIX:
+        {
+            float* values = (float*)u->values;
+            Uint8 transpose = u->transpose;
+            switch(u->num_elements)
+            {
+            case 2:
+                if(u->num_columns == 2)
+                    glUniformMatrix2fv(location, num_values, transpose, values);
+                else if(u->num_columns == 3)
+                    glUniformMatrix2x3fv(location, num_values, transpose, values);
+                else if(u->num_columns == 4)
+                    glUniformMatrix2x4fv(location, num_values, transpose, values);
+                break;
+            case 3:
+                if(u->num_columns == 2)
+                    glUniformMatrix3x2fv(location, num_values, transpose, values);
+                else if(u->num_columns == 3)
+                    glUniformMatrix3fv(location, num_values, transpose, values);
+                else if(u->num_columns == 4)
+                    glUniformMatrix3x4fv(location, num_values, transpose, values);
+                break;
+            case 4:
+                if(u->num_columns == 2)
+                    glUniformMatrix4x2fv(location, num_values, transpose, values);
+                else if(u->num_columns == 3)
+                    glUniformMatrix4x3fv(location, num_values, transpose, values);
+                else if(u->num_columns == 4)
+                    glUniformMatrix4fv(location, num_values, transpose, values);
+                break;
+            }
+        }
+        break;
+    }
+}
+
+static GPU_UNIFORM_DATA* findUniform(GPU_CONTEXT_DATA* cdata, Uint32 program_object, int location)
+{
+    int i;
+    for(i = 0; i < cdata->num_uniforms; i++)
+    {
+        if(cdata->uniforms[i].program == program_object && cdata->uniforms[i].location == location)
+            return &cdata->uniforms[i];
+    }
+    return NULL;
+}
+
+static void removeUniform(GPU_CONTEXT_DATA* cdata, GPU_UNIFORM_DATA* u)
+{
+    SDL_free(u->values);
+    cdata->num_uniforms--;
+    *u = cdata->uniforms[cdata->num_uniforms];
+}
+
+// Forgets a uniform that was set behind the shadow's back, so the next value given to it is always sent
+static void forgetUniform(GPU_CONTEXT_DATA* cdata, Uint32 program_object, int location)
+{
+    GPU_UNIFORM_DATA* u = findUniform(cdata, program_object, location);
+    if(u == NULL)
+        return;
+    
+    // A value that was never sent would be lost
+    if(u->is_dirty)
+        sendUniform(u);
+    removeUniform(cdata, u);
+}
+
+// Forgets all uniforms of a program, e.g. when it is relinked or deleted
+static void forgetProgramUniforms(GPU_CONTEXT_DATA* cdata, Uint32 program_object)
+{
+    int i = 0;
+    while(i < cdata->num_uniforms)
+    {
+        if(cdata->uniforms[i].program == program_object)
+            removeUniform(cdata, &cdata->uniforms[i]);
+        else
+            i++;
+    }
+}
+
+static void freeUniforms(GPU_CONTEXT_DATA* cdata)
+{
+    int i;
+    for(i = 0; i < cdata->num_uniforms; i++)
+        SDL_free(cdata->uniforms[i].values);
+    SDL_free(cdata->uniforms);
+    cdata->uniforms = NULL;
+    cdata->num_uniforms = 0;
+    cdata->uniforms_storage_size = 0;
+    cdata->has_dirty_uniforms = 0;
+}
+
+// Copies the first value of a shadowed uniform, like glGetUniform*() does.  The shadow is the only place that knows values which are still waiting for their program to be used.
+static Uint8 getShadowedUniform(GPU_Renderer* renderer, Uint32 program_object, int location, int type, void* values)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    GPU_UNIFORM_DATA* u = findUniform(cdata, program_object, location);
+    
+    if(u == NULL || u->num_values <= 0)
+        return 0;
+    if(u->type != type && !(type == GPU_UNIFORM_TYPE_FLOAT && u->type == GPU_UNIFORM_TYPE_MATRIX))
+        return 0;
+    
+    memcpy(values, u->values, u->size/u->num_values);
+    return 1;
+}
+
+// Records a uniform value for the current shader program.  It is sent to GL by commitUniforms() before the next draw.
+static void setShadowedUniform(GPU_Renderer* renderer, int location, int type, int num_elements, int num_columns, int num_values, Uint8 transpose, const void* values, int size)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    GPU_UNIFORM_DATA* u;
+    
+    if(location < 0 || size <= 0)
+        return;
+    
+    u = findUniform(cdata, context->current_shader_program, location);
+    if(u != NULL && u->type == type && u->num_elements == num_elements && u->num_columns == num_columns
+       && u->num_values == num_values && u->transpose == transpose && u->size == size && memcmp(u->values, values, size) == 0)
+        return;
+    
+    // Whatever is batched was meant to be drawn with the old value
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
+    
+    if(u == NULL)
+    {
+        if(cdata->num_uniforms >= cdata->uniforms_storage_size)
+        {
+            int new_storage_size = (cdata->uniforms_storage_size > 0? cdata->uniforms_storage_size*2 : 16);
+            GPU_UNIFORM_DATA* new_uniforms = (GPU_UNIFORM_DATA*)SDL_realloc(cdata->uniforms, new_storage_size*sizeof(GPU_UNIFORM_DATA));
+            if(new_uniforms == NULL)
+            {
+                // Just send it directly
+                GPU_UNIFORM_DATA temp;
+                temp.location = location;
+                temp.type = type;
+                temp.num_elements = num_elements;
+                temp.num_columns = num_columns;
+                temp.num_values = num_values;
+                temp.transpose = transpose;
+                temp.values = (void*)values;
+                sendUniform(&temp);
+                return;
+            }
+            cdata->uniforms = new_uniforms;
+            cdata->uniforms_storage_size = new_storage_size;
+        }
+        
+        u = &cdata->uniforms[cdata->num_uniforms];
+        cdata->num_uniforms++;
+        u->program = context->current_shader_program;
+        u->location = location;
+        u->size = 0;
+        u->values = NULL;
+    }
+    
+    if(u->size != size)
+    {
+        SDL_free(u->values);
+        u->values = SDL_malloc(size);
+        u->size = size;
+    }
+    
+    u->type = type;
+    u->num_elements = num_elements;
+    u->num_columns = num_columns;
+    u->num_values = num_values;
+    u->transpose = transpose;
+    memcpy(u->values, values, size);
+    u->is_dirty = 1;
+    cdata->has_dirty_uniforms = 1;
+}
+
+// Sends the pending uniform values of the current shader program, which has to be bound
+static void commitUniforms(GPU_Renderer* renderer)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    Uint8 has_dirty_uniforms = 0;
+    int i;
+    
+    if(!cdata->has_dirty_uniforms)
+        return;
+    
+    for(i = 0; i < cdata->num_uniforms; i++)
+    {
+        GPU_UNIFORM_DATA* u = &cdata->uniforms[i];
+        if(!u->is_dirty)
+            continue;
+        
+        if(u->program == context->current_shader_program)
+        {
+            sendUniform(u);
+            u->is_dirty = 0;
+        }
+        else
+            has_dirty_uniforms = 1;
+    }
+    
+    cdata->has_dirty_uniforms = has_dirty_uniforms;
+}
+
+#endif
+
+static void prepareToRenderToTarget(GPU_Renderer* renderer, GPU_Target* target)
+{
+    // Whatever is drawn now has to land on top of the blits that were recorded before it
+    flushSortedBlits(renderer, GPU_FLUSH_CAUSE_STATE);
+    
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    commitUniforms(renderer);
+    #endif
+    
+    // Set up the camera
+    renderer->impl->SetCamera(renderer, target, &target->camera);
+    
+    setClipRect(renderer, target);
+}
+
+
+
+static void changeColor(GPU_Renderer* renderer, SDL_Color color)
 {
     #ifdef SDL_GPU_USE_BUFFER_PIPELINE
 	(void)renderer;
@@ -534,7 +2411,7 @@ static void changeColor(GPU_Renderer* renderer, SDL_Color color)
         || cdata->last_color.b != color.b
         || GET_ALPHA(cdata->last_color) != GET_ALPHA(color))
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
         cdata->last_color = color;
         glColor4f(color.r/255.01f, color.g/255.01f, color.b/255.01f, GET_ALPHA(color)/255.01f);
     }
@@ -547,7 +2424,7 @@ static void changeBlending(GPU_Renderer* renderer, Uint8 enable)
     if(cdata->last_use_blending == enable)
         return;
     
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
 
     if(enable)
         glEnable(GL_BLEND);
@@ -561,17 +2438,13 @@ static void forceChangeBlendMode(GPU_Renderer* renderer, GPU_BlendMode mode)
 {
     GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
     
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
 
     cdata->last_blend_mode = mode;
     
-    if(mode.source_color == mode.source_alpha && mode.dest_color == mode.dest_alpha)
-    {
-        glBlendFunc(mode.source_color, mode.dest_color);
-    }
-    else if(renderer->enabled_features & GPU_FEATURE_BLEND_FUNC_SEPARATE)
+    if((mode.source_color == mode.source_alpha && mode.dest_color == mode.dest_alpha) || (renderer->enabled_features & GPU_FEATURE_BLEND_FUNC_SEPARATE))
     {
-        glBlendFuncSeparate(mode.source_color, mode.dest_color, mode.source_alpha, mode.dest_alpha);
+        setBlendFunc(cdata, mode.source_color, mode.dest_color, mode.source_alpha, mode.dest_alpha);
     }
     else
     {
@@ -580,10 +2453,8 @@ static void forceChangeBlendMode(GPU_Renderer* renderer, GPU_BlendMode mode)
     
     if(renderer->enabled_features & GPU_FEATURE_BLEND_EQUATIONS)
     {
-        if(mode.color_equation == mode.alpha_equation)
-            glBlendEquation(mode.color_equation);
-        else if(renderer->enabled_features & GPU_FEATURE_BLEND_EQUATIONS_SEPARATE)
-            glBlendEquationSeparate(mode.color_equation, mode.alpha_equation);
+        if(mode.color_equation == mode.alpha_equation || (renderer->enabled_features & GPU_FEATURE_BLEND_EQUATIONS_SEPARATE))
+            setBlendEquation(cdata, mode.color_equation, mode.alpha_equation);
         else
         {
             GPU_PushErrorCode("(SDL_gpu internal)", GPU_ERROR_BACKEND_ERROR, "Could not set blend equation because GPU_FEATURE_BLEND_EQUATIONS_SEPARATE is not supported.");
@@ -645,7 +2516,7 @@ static void changeTexturing(GPU_Renderer* renderer, Uint8 enable)
     GPU_Context* context = renderer->current_context_target->context;
     if(enable != ((GPU_CONTEXT_DATA*)context->data)->last_use_texturing)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
         
         ((GPU_CONTEXT_DATA*)context->data)->last_use_texturing = enable;
         #ifndef SDL_GPU_SKIP_ENABLE_TEXTURE_2D
@@ -661,7 +2532,7 @@ static void enableTexturing(GPU_Renderer* renderer)
 {
     if(!renderer->current_context_target->context->use_texturing)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
         renderer->current_context_target->context->use_texturing = 1;
     }
 }
@@ -670,7 +2541,7 @@ static void disableTexturing(GPU_Renderer* renderer)
 {
     if(renderer->current_context_target->context->use_texturing)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
         renderer->current_context_target->context->use_texturing = 0;
     }
 }
@@ -678,17 +2549,27 @@ static void disableTexturing(GPU_Renderer* renderer)
 #define MIX_COLOR_COMPONENT_NORMALIZED_RESULT(a, b) ((a)/255.0f * (b)/255.0f)
 #define MIX_COLOR_COMPONENT(a, b) (((a)/255.0f * (b)/255.0f)*255)
 
-static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image)
+static void prepareToRenderSprites(GPU_Renderer* renderer, Uint8 use_blending, GPU_BlendMode blend_mode)
 {
     GPU_Context* context = renderer->current_context_target->context;
     
     enableTexturing(renderer);
     if(GL_TRIANGLES != ((GPU_CONTEXT_DATA*)context->data)->last_shape)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
         ((GPU_CONTEXT_DATA*)context->data)->last_shape = GL_TRIANGLES;
     }
     
+    changeBlending(renderer, use_blending);
+    changeBlendMode(renderer, blend_mode);
+    
+    // If we're using the untextured shader, switch it.
+    if(context->current_shader_program == context->default_untextured_shader_program)
+        renderer->impl->ActivateShaderProgram(renderer, context->default_textured_shader_program, NULL);
+}
+
+static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image)
+{
     // Blitting
     if(target->use_color)
     {
@@ -702,22 +2583,45 @@ static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Target* target, GPU
     }
     else
         changeColor(renderer, image->color);
-    changeBlending(renderer, image->use_blending);
-    changeBlendMode(renderer, image->blend_mode);
     
-    // If we're using the untextured shader, switch it.
-    if(context->current_shader_program == context->default_untextured_shader_program)
-        renderer->impl->ActivateShaderProgram(renderer, context->default_textured_shader_program, NULL);
+    prepareToRenderSprites(renderer, image->use_blending, image->blend_mode);
+}
+
+// Filled shapes sample this so they can be drawn with the sprites
+static GPU_Image* getWhiteTexel(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    static const unsigned char white_pixel[4] = {255, 255, 255, 255};
+    
+    if(cdata->white_texel == NULL)
+    {
+        cdata->white_texel = renderer->impl->CreateImage(renderer, 1, 1, GPU_FORMAT_RGBA);
+        if(cdata->white_texel != NULL)
+            renderer->impl->UpdateImageBytes(renderer, cdata->white_texel, NULL, white_pixel, 4);
+    }
+    return cdata->white_texel;
 }
 
 static void prepareToRenderShapes(GPU_Renderer* renderer, unsigned int shape)
 {
     GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    
+    // Filled shapes can go into the sprite batch if the default shaders are in use
+    cdata->shapes_use_white_texel = 0;
+    if(shape == GL_TRIANGLES && (renderer->GPU_init_flags & GPU_INIT_BATCH_SHAPES_WITH_SPRITES)
+       && (context->current_shader_program == context->default_textured_shader_program || context->current_shader_program == context->default_untextured_shader_program)
+       && getWhiteTexel(renderer, cdata) != NULL)
+    {
+        prepareToRenderSprites(renderer, context->shapes_use_blending, context->shapes_blend_mode);
+        bindTextureSlot(renderer, cdata->white_texel);
+        cdata->shapes_use_white_texel = 1;
+        return;
+    }
     
     disableTexturing(renderer);
     if(shape != ((GPU_CONTEXT_DATA*)context->data)->last_shape)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
         ((GPU_CONTEXT_DATA*)context->data)->last_shape = shape;
     }
     
@@ -750,7 +2654,7 @@ static void forceChangeViewport(GPU_Target* target, GPU_Rect viewport)
             y = target->context->window_h - viewport.h - viewport.y;
     }
     
-    glViewport(viewport.x, y, viewport.w, viewport.h);
+    setViewport(cdata, viewport.x, y, viewport.w, viewport.h);
 }
 
 static void changeViewport(GPU_Target* target)
@@ -765,7 +2669,8 @@ static void changeViewport(GPU_Target* target)
 
 static void applyTargetCamera(GPU_Target* target)
 {
-    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)GPU_GetContextTarget()->context->data;
+    GPU_Context* context = GPU_GetContextTarget()->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
     Uint8 invert = (target->image != NULL);
 	float offsetX, offsetY;
 
@@ -794,6 +2699,14 @@ static void applyTargetCamera(GPU_Target* target)
     GPU_Translate(target->camera.x + offsetX, target->camera.y + offsetY, 0);
     GPU_Scale(target->camera.zoom, target->camera.zoom, 1.0f);
     GPU_Translate(-target->camera.x - offsetX, -target->camera.y - offsetY, 0);
+    
+    // Until any of these change, the matrices don't need to be built again
+    cdata->last_camera_target = target;
+    cdata->last_camera_w = target->w;
+    cdata->last_camera_h = target->h;
+    cdata->last_camera_coordinate_mode = GPU_GetCoordinateMode();
+    cdata->last_camera_projection_version = context->projection_matrix.version;
+    cdata->last_camera_modelview_version = context->modelview_matrix.version;
 }
 
 static Uint8 equal_cameras(GPU_Camera a, GPU_Camera b)
@@ -803,9 +2716,15 @@ static Uint8 equal_cameras(GPU_Camera a, GPU_Camera b)
 
 static void changeCamera(GPU_Target* target)
 {
-    //GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)GPU_GetContextTarget()->context->data;
+    GPU_Context* context = GPU_GetContextTarget()->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
     
-    //if(cdata->last_camera_target != target || !equal_cameras(cdata->last_camera, target->camera))
+    // Anything else that touched the matrices since then (e.g. GPU_Translate()) has bumped their versions
+    if(cdata->last_camera_target != target || !equal_cameras(cdata->last_camera, target->camera)
+       || cdata->last_camera_w != target->w || cdata->last_camera_h != target->h
+       || cdata->last_camera_inverted != (target->image != NULL) || cdata->last_camera_coordinate_mode != GPU_GetCoordinateMode()
+       || cdata->last_camera_projection_version != context->projection_matrix.version
+       || cdata->last_camera_modelview_version != context->modelview_matrix.version)
     {
         applyTargetCamera(target);
     }
@@ -814,8 +2733,10 @@ static void changeCamera(GPU_Target* target)
 #ifdef SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
 static void applyTransforms(void)
 {
-    float* p = GPU_GetProjection();
-    float* m = GPU_GetModelView();
+    // Read the stacks directly so their versions stay the same
+    GPU_Context* context = GPU_GetContextTarget()->context;
+    float* p = context->projection_matrix.matrix[context->projection_matrix.size-1];
+    float* m = context->modelview_matrix.matrix[context->modelview_matrix.size-1];
     glMatrixMode(GL_PROJECTION);
     glLoadMatrixf(p);
     glMatrixMode(GL_MODELVIEW);
@@ -823,6 +2744,69 @@ static void applyTransforms(void)
 }
 #endif
 
+#ifndef SDL_GPU_DISABLE_SHADERS
+// Forgets what the given program was last sent, e.g. when it is relinked or deleted
+static void forgetModelViewProjection(GPU_CONTEXT_DATA* cdata, Uint32 program_object)
+{
+    int i;
+    for(i = 0; i < GPU_MVP_CACHE_SIZE; i++)
+    {
+        if(cdata->mvp_cache_programs[i] == program_object)
+            cdata->mvp_cache_programs[i] = 0;
+    }
+}
+#endif
+
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+// Uploads the model-view-projection matrix to the bound program, unless that program already has it
+static void setModelViewProjection(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, int location)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    int i;
+    
+    if(location < 0)
+        return;
+    
+    if(!cdata->mvp_is_valid || cdata->mvp_projection_version != context->projection_matrix.version
+       || cdata->mvp_modelview_version != context->modelview_matrix.version)
+    {
+        GPU_GetModelViewProjection(cdata->mvp);
+        cdata->mvp_projection_version = context->projection_matrix.version;
+        cdata->mvp_modelview_version = context->modelview_matrix.version;
+        cdata->mvp_is_valid = 1;
+    }
+    
+    // Nothing to compare against if we don't know which program is bound
+    if(cdata->bound_shader_program == 0 || cdata->bound_shader_program == GPU_GL_STATE_UNKNOWN)
+    {
+        glUniformMatrix4fv(location, 1, 0, cdata->mvp);
+        return;
+    }
+    
+    for(i = 0; i < GPU_MVP_CACHE_SIZE; i++)
+    {
+        if(cdata->mvp_cache_programs[i] == cdata->bound_shader_program)
+            break;
+    }
+    
+    if(i < GPU_MVP_CACHE_SIZE)
+    {
+        if(memcmp(cdata->mvp_cache_matrices[i], cdata->mvp, sizeof(cdata->mvp)) == 0)
+            return;
+    }
+    else
+    {
+        i = cdata->mvp_cache_next;
+        cdata->mvp_cache_next = (cdata->mvp_cache_next + 1) % GPU_MVP_CACHE_SIZE;
+        cdata->mvp_cache_programs[i] = cdata->bound_shader_program;
+    }
+    
+    memcpy(cdata->mvp_cache_matrices[i], cdata->mvp, sizeof(cdata->mvp));
+    glUniformMatrix4fv(location, 1, 0, cdata->mvp);
+    forgetUniform(cdata, cdata->bound_shader_program, location);
+}
+#endif
+
 
 static GPU_Target* Init(GPU_Renderer* renderer, GPU_RendererID renderer_request, Uint16 w, Uint16 h, GPU_WindowFlagEnum SDL_flags)
 {
@@ -1020,12 +3004,24 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         // Initialize the blit buffer
         cdata->blit_buffer_max_num_vertices = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES;
         cdata->blit_buffer_num_vertices = 0;
-        blit_buffer_storage_size = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES*GPU_BLIT_BUFFER_STRIDE;
+        initVertexFormat(renderer, cdata);
+        blit_buffer_storage_size = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES*GPU_BLIT_BUFFER_STRIDE(cdata);
         cdata->blit_buffer = (float*)SDL_malloc(blit_buffer_storage_size);
+        cdata->blit_buffer_vertex_limit = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES;
         cdata->index_buffer_max_num_vertices = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES;
         cdata->index_buffer_num_vertices = 0;
+        cdata->index_type = GL_UNSIGNED_SHORT;
         index_buffer_storage_size = GPU_BLIT_BUFFER_INIT_MAX_NUM_VERTICES*sizeof(unsigned short);
-        cdata->index_buffer = (unsigned short*)SDL_malloc(index_buffer_storage_size);
+        cdata->index_buffer = SDL_malloc(index_buffer_storage_size);
+        // The sorted blit buffer is allocated on first use
+        cdata->batch_mode = GPU_BATCH_MODE_IMMEDIATE;
+        cdata->use_culling = 0;
+        cdata->sorted_blit_buffer = NULL;
+        cdata->sorted_blit_buffer_num_blits = 0;
+        cdata->sorted_blit_buffer_max_num_blits = 0;
+        // The white texel for shapes is also created on first use
+        cdata->white_texel = NULL;
+        cdata->shapes_use_white_texel = 0;
     }
     else
     {
@@ -1196,6 +3192,8 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         return NULL;
     }
     
+    initBatchLimits(renderer, cdata);
+    
     #ifdef SDL_GPU_USE_SDL2
     // No preference for vsync?
     if(!(renderer->GPU_init_flags & (GPU_INIT_DISABLE_VSYNC | GPU_INIT_ENABLE_VSYNC)))
@@ -1220,18 +3218,49 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
     
     target->context->matrix_mode = GPU_MODELVIEW;
     
+    // Nothing derived from the matrices is valid for a fresh GL context
+    target->context->projection_matrix.version++;
+    target->context->modelview_matrix.version++;
+    cdata->last_camera_target = NULL;
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    cdata->mvp_is_valid = 0;
+    memset(cdata->mvp_cache_programs, 0, sizeof(cdata->mvp_cache_programs));
+    cdata->mvp_cache_next = 0;
+    freeUniforms(cdata);
+    #endif
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    {
+        GLint max_attributes = 0;
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_attributes);
+        cdata->gl_all_attributes = (max_attributes >= 32? 0xFFFFFFFF : (1u << max_attributes) - 1);
+    }
+    #else
+    cdata->gl_all_attributes = 0;
+    #endif
+    invalidateGLState(cdata);
+    
+    #ifdef SDL_GPU_USE_OPENGL
+    cdata->use_texture_storage = isExtensionSupported("GL_ARB_texture_storage");
+    cdata->use_clear_texture = isExtensionSupported("GL_ARB_clear_texture");
+    #else
+    cdata->use_texture_storage = 0;
+    cdata->use_clear_texture = 0;
+    #endif
+    
     // Modes
     #ifndef SDL_GPU_SKIP_ENABLE_TEXTURE_2D
     glEnable(GL_TEXTURE_2D);
     #endif
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    setBlendFunc(cdata, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     glDisable(GL_BLEND);
     glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
 
     // Viewport and Framebuffer
-    glViewport(0.0f, 0.0f, target->viewport.w, target->viewport.h);
+    setViewport(cdata, 0, 0, target->viewport.w, target->viewport.h);
 
+    setScissorTest(cdata, 0);
     glClear( GL_COLOR_BUFFER_BIT );
     #if SDL_GPU_GL_TIER < 3
     glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
@@ -1247,7 +3276,7 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         // Create vertex array container and buffer
         #if !defined(SDL_GPU_NO_VAO)
         glGenVertexArrays(1, &cdata->blit_VAO);
-        glBindVertexArray(cdata->blit_VAO);
+        bindVertexArray(cdata, cdata->blit_VAO);
         #endif
     #endif
     
@@ -1312,6 +3341,23 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         // Get locations of the attributes in the shader
         cdata->shader_block[0] = GPU_LoadShaderBlock(p, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
         
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        {
+            // Instanced sprites carry a slot too, so they share the slot fragment shader
+            Uint32 texture_slots_fragment_shader = initTextureSlots(renderer, target);
+            if(texture_slots_fragment_shader != 0)
+                f = texture_slots_fragment_shader;
+        }
+        #endif
+        
+        #ifdef SDL_GPU_USE_INSTANCING
+        initInstancedSprites(renderer, target, f);
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        if(cdata->use_instancing && cdata->use_texture_slots)
+            setTextureSlotSamplers(cdata, cdata->instanced_shader_program);
+        #endif
+        #endif
+        
         
         // Untextured shader
         v = renderer->impl->CompileShader(renderer, GPU_VERTEX_SHADER, untextured_vertex_shader_source);
@@ -1344,7 +3390,7 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
             return NULL;
         }
         
-        glUseProgram(p);
+        useProgram(cdata, p);
         
         target->context->default_untextured_shader_program = target->context->current_shader_program = p;
         
@@ -1364,18 +3410,32 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         
         glGenBuffers(2, cdata->blit_VBO);
         // Create space on the GPU
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[0]);
-        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[1]);
-        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
+        bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->blit_VBO[0]);
+        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE(cdata) * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
+        bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->blit_VBO[1]);
+        glBufferData(GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE(cdata) * cdata->blit_buffer_max_num_vertices, NULL, GL_STREAM_DRAW);
         cdata->blit_VBO_flop = 0;
         
+        #ifdef SDL_GPU_USE_BUFFER_RING
+        createRing(cdata, &cdata->blit_ring, GL_ARRAY_BUFFER, GPU_BLIT_BUFFER_STRIDE(cdata) * cdata->blit_buffer_max_num_vertices);
+        #endif
+        
         glGenBuffers(1, &cdata->blit_IBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * cdata->blit_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
+        bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, getIndexSize(cdata) * cdata->index_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
+        
+        glGenBuffers(1, &cdata->blit_quad_IBO);
+        bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_quad_IBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, cdata->quad_index_buffer_num_indices * getIndexSize(cdata), cdata->quad_index_buffer, GL_STATIC_DRAW);
         
         glGenBuffers(16, cdata->attribute_VBO);
         
+        #if !defined(SDL_GPU_NO_VAO)
+        memset(cdata->vertex_formats, 0, sizeof(cdata->vertex_formats));
+        cdata->vertex_formats_next = 0;
+        cdata->use_base_vertex = isExtensionSupported("GL_ARB_draw_elements_base_vertex");
+        #endif
+        
         // Init 16 attributes to 0 / NULL.
         memset(cdata->shader_attributes, 0, 16*sizeof(GPU_AttributeSource));
     #endif
@@ -1432,7 +3492,7 @@ static void MakeCurrent(GPU_Renderer* renderer, GPU_Target* target, Uint32 windo
         {
 			SDL_Window* window;
 
-            renderer->impl->FlushBlitBuffer(renderer);
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_TARGET);
             
             // Update the window mappings
             GPU_RemoveWindowMapping(windowID);
@@ -1492,10 +3552,12 @@ static void ResetRendererState(GPU_Renderer* renderer)
     target = renderer->current_context_target;
     cdata = (GPU_CONTEXT_DATA*)target->context->data;
     
+    // Someone else may have changed the GL state, so set everything again
+    invalidateGLState(cdata);
     
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
-        glUseProgram(target->context->current_shader_program);
+        useProgram(cdata, target->context->current_shader_program);
     #endif
     
     #ifdef SDL_GPU_USE_SDL2
@@ -1522,8 +3584,37 @@ static void ResetRendererState(GPU_Renderer* renderer)
     
     forceChangeViewport(target, target->viewport);
     
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    if(IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+        setActiveTextureUnit(cdata, 0);
+    #endif
+    
+    // Another context may have evicted the last image, in which case it is bound again when it's next used
+    if(cdata->last_image != NULL && isImageEvicted(cdata->last_image))
+    {
+        cdata->last_image = NULL;
+        #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+        cdata->num_texture_slots_used = 0;
+        #endif
+    }
+    
     if(cdata->last_image != NULL)
-        glBindTexture(GL_TEXTURE_2D, ((GPU_IMAGE_DATA*)(cdata->last_image)->data)->handle);
+        bindTextureHandle(cdata, ((GPU_IMAGE_DATA*)(cdata->last_image)->data)->handle);
+    
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    {
+        unsigned int i;
+        for(i = 1; i < cdata->num_texture_slots_used; i++)
+        {
+            if(isImageEvicted(cdata->texture_slots[i]))
+            {
+                cdata->num_texture_slots_used = i;
+                break;
+            }
+            bindTextureHandleToUnit(cdata, i, ((GPU_IMAGE_DATA*)(cdata->texture_slots[i])->data)->handle);
+        }
+    }
+    #endif
     
     if(cdata->last_target != NULL)
         extBindFramebuffer(renderer, ((GPU_TARGET_DATA*)cdata->last_target->data)->handle);
@@ -1535,9 +3626,10 @@ static Uint8 SetWindowResolution(GPU_Renderer* renderer, Uint16 w, Uint16 h)
 {
     GPU_Target* target = renderer->current_context_target;
     
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_STATE);
     Uint8 isCurrent = isCurrentTarget(renderer, target);
     if(isCurrent)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
     
 #ifdef SDL_GPU_USE_SDL2
     
@@ -1575,7 +3667,11 @@ static Uint8 SetWindowResolution(GPU_Renderer* renderer, Uint16 w, Uint16 h)
     context->use_texturing = 1;
     ((GPU_CONTEXT_DATA*)context->data)->last_use_texturing = 0;
     
+    // The GL context might have been recreated, so the shadowed state can't be trusted
+    invalidateGLState((GPU_CONTEXT_DATA*)context->data);
+    
     // Clear target (no state change)
+    setScissorTest((GPU_CONTEXT_DATA*)context->data, 0);
     glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
     glClear( GL_COLOR_BUFFER_BIT );
 #endif
@@ -1612,9 +3708,10 @@ static void SetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target, Uin
     if(target == NULL)
         return;
     
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_STATE);
     isCurrent = isCurrentTarget(renderer, target);
     if(isCurrent)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
 
     target->w = w;
     target->h = h;
@@ -1631,9 +3728,10 @@ static void UnsetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target)
     if(target == NULL)
         return;
     
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_STATE);
     isCurrent = isCurrentTarget(renderer, target);
     if(isCurrent)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
     
     target->w = target->base_w;
     target->h = target->base_h;
@@ -1728,6 +3826,7 @@ static Uint8 SetFullscreen(GPU_Renderer* renderer, Uint8 enable_fullscreen, Uint
         GPU_UnsetClip(target);
         
         // Update camera
+        flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_STATE);
         if(isCurrentTarget(renderer, target))
             applyTargetCamera(target);
     }
@@ -1759,8 +3858,9 @@ static GPU_Camera SetCamera(GPU_Renderer* renderer, GPU_Target* target, GPU_Came
     
     if(!equal_cameras(new_camera, old_camera))
     {
+        flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_STATE);
         if(isCurrentTarget(renderer, target))
-            renderer->impl->FlushBlitBuffer(renderer);
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
     
         target->camera = new_camera;
     }
@@ -1769,9 +3869,125 @@ static GPU_Camera SetCamera(GPU_Renderer* renderer, GPU_Target* target, GPU_Came
 }
 
 
+#ifdef SDL_GPU_USE_OPENGL
+// Sized internal formats are needed for immutable storage
+static GLenum getSizedTextureFormat(GLenum format)
+{
+    switch(format)
+    {
+    case GL_RGB:
+        return GL_RGB8;
+    case GL_RGBA:
+        return GL_RGBA8;
+    case GL_RG:
+        return GL_RG8;
+    }
+    return 0;
+}
+#endif
+
+// Returns a pooled texture of the given size and format (or 0) and removes it from the pool.
+static GLuint takePooledTexture(GPU_CONTEXT_DATA* cdata, Uint16 w, Uint16 h, Uint32 format, Uint8* immutable)
+{
+    int i;
+    // Newest first, since it is the most likely to still be resident
+    for(i = cdata->texture_pool_size-1; i >= 0; i--)
+    {
+        GPU_POOLED_TEXTURE_DATA* entry = &cdata->texture_pool[i];
+        if(entry->w == w && entry->h == h && entry->format == format)
+        {
+            GLuint handle = entry->handle;
+            *immutable = entry->immutable;
+            memory_stats.pool_bytes -= entry->bytes;
+            cdata->texture_pool_size--;
+            memmove(entry, entry+1, (cdata->texture_pool_size - i)*sizeof(GPU_POOLED_TEXTURE_DATA));
+            return handle;
+        }
+    }
+    return 0;
+}
+
+static void deleteTextureHandle(GPU_CONTEXT_DATA* cdata, GLuint handle)
+{
+    forgetTextureHandle(cdata, handle);
+    glDeleteTextures(1, &handle);
+}
+
+// Keeps the texture of an image that is being freed so a new image of the same size and format can take it.
+static void poolTexture(GPU_CONTEXT_DATA* cdata, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    GPU_POOLED_TEXTURE_DATA* entry;
+
+    if(cdata->texture_pool_size >= GPU_TEXTURE_POOL_SIZE)
+    {
+        // Evict the oldest
+        deleteTextureHandle(cdata, cdata->texture_pool[0].handle);
+        memory_stats.pool_bytes -= cdata->texture_pool[0].bytes;
+        cdata->texture_pool_size--;
+        memmove(cdata->texture_pool, cdata->texture_pool+1, cdata->texture_pool_size*sizeof(GPU_POOLED_TEXTURE_DATA));
+    }
+
+    entry = &cdata->texture_pool[cdata->texture_pool_size++];
+    entry->handle = data->handle;
+    entry->w = image->texture_w;
+    entry->h = image->texture_h;
+    entry->format = data->format;
+    entry->immutable = data->immutable;
+    entry->bytes = (Uint64)image->texture_w*image->texture_h*image->bytes_per_pixel;
+    memory_stats.pool_bytes += entry->bytes;
+}
+
+static void freeTexturePool(GPU_CONTEXT_DATA* cdata)
+{
+    int i;
+    for(i = 0; i < cdata->texture_pool_size; i++)
+    {
+        deleteTextureHandle(cdata, cdata->texture_pool[i].handle);
+        memory_stats.pool_bytes -= cdata->texture_pool[i].bytes;
+    }
+    cdata->texture_pool_size = 0;
+}
+
+static unsigned char* getZeroBuffer(GPU_CONTEXT_DATA* cdata, unsigned int size)
+{
+    if(cdata->zero_buffer_size < size)
+    {
+        SDL_free(cdata->zero_buffer);
+        cdata->zero_buffer = (unsigned char*)SDL_malloc(size);
+        if(cdata->zero_buffer == NULL)
+        {
+            cdata->zero_buffer_size = 0;
+            return NULL;
+        }
+        cdata->zero_buffer_size = size;
+        memset(cdata->zero_buffer, 0, size);
+    }
+    return cdata->zero_buffer;
+}
+
+// Clears the bound texture of the image to zero.  Unpack state must already be set for a tightly packed upload.
+static void clearTexture(GPU_CONTEXT_DATA* cdata, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    unsigned char* zeroes;
+
+    #ifdef SDL_GPU_USE_OPENGL
+    if(cdata->use_clear_texture)
+    {
+        glClearTexImage(data->handle, 0, data->format, GL_UNSIGNED_BYTE, NULL);
+        return;
+    }
+    #endif
+
+    zeroes = getZeroBuffer(cdata, image->texture_w*image->texture_h*image->bytes_per_pixel);
+    if(zeroes != NULL)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image->texture_w, image->texture_h, data->format, GL_UNSIGNED_BYTE, zeroes);
+}
+
 static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format)
 {
-    GLuint handle, num_layers, bytes_per_pixel;
+    GLuint num_layers, bytes_per_pixel;
     GLenum gl_format;
 	GPU_Image* result;
 	GPU_IMAGE_DATA* data;
@@ -1821,6 +4037,32 @@ static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uin
             num_layers = 3;
             bytes_per_pixel = 1;
             break;
+        // The texture is filled by CreateImageFromCompressedData(), and reads back as RGBA
+        case GPU_FORMAT_BC1:
+            gl_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
+        case GPU_FORMAT_BC2:
+            gl_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
+        case GPU_FORMAT_BC3:
+            gl_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
+        case GPU_FORMAT_ETC2_RGB:
+            gl_format = GL_COMPRESSED_RGB8_ETC2;
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
+        case GPU_FORMAT_ETC2_RGBA:
+            gl_format = GL_COMPRESSED_RGBA8_ETC2_EAC;
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
         default:
             GPU_PushErrorCode("GPU_CreateUninitializedImage", GPU_ERROR_DATA_ERROR, "Unsupported image format (0x%x)", format);
             return NULL;
@@ -1832,26 +4074,6 @@ static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uin
         return NULL;
     }
 
-    glGenTextures( 1, &handle );
-    if(handle == 0)
-    {
-        GPU_PushErrorCode("GPU_CreateUninitializedImage", GPU_ERROR_BACKEND_ERROR, "Failed to generate a texture handle.");
-        return NULL;
-    }
-
-    flushAndBindTexture( renderer, handle );
-
-    // Set the texture's stretching properties
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-    #if defined(SDL_GPU_USE_GLES) && (SDL_GPU_GLES_TIER == 1)
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-    #endif
-
     result = (GPU_Image*)SDL_malloc(sizeof(GPU_Image));
     result->refcount = 1;
     data = (GPU_IMAGE_DATA*)SDL_malloc(sizeof(GPU_IMAGE_DATA));
@@ -1873,35 +4095,148 @@ static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uin
     
     result->data = data;
     result->is_alias = 0;
-    data->handle = handle;
+    // The texture comes from createTextureStorage()
+    data->handle = 0;
     data->owns_handle = 1;
     data->format = gl_format;
+    data->poolable = 0;
+    data->immutable = 0;
+    data->owner = result;
+    data->memory_bytes = 0;
+    data->padding_bytes = 0;
+    data->memory_is_target = 0;
+    data->evicted_pixels = NULL;
+    data->lru_prev = NULL;
+    data->lru_next = NULL;
+    data->memory_context = NULL;
 
     result->using_virtual_resolution = 0;
     result->w = w;
     result->h = h;
     result->base_w = w;
     result->base_h = h;
-    // POT textures will change this later
     result->texture_w = w;
     result->texture_h = h;
+    result->texture_x = 0;
+    result->texture_y = 0;
+    if(!(renderer->enabled_features & GPU_FEATURE_NON_POWER_OF_TWO))
+    {
+        if(!isPowerOfTwo(w))
+            result->texture_w = getNearestPowerOf2(w);
+        if(!isPowerOfTwo(h))
+            result->texture_h = getNearestPowerOf2(h);
+    }
 
     return result;
 }
 
+static void freeUninitializedImage(GPU_Image* image)
+{
+    forgetImageMemory((GPU_IMAGE_DATA*)image->data);
+    SDL_free(image->data);
+    SDL_free(image);
+}
+
+// Gives an image from CreateUninitializedImage() a texture of texture_w x texture_h, reusing a pooled one if there is a match.
+// The texture is filled from 'pixels' (tightly packed rows) if given, or else cleared to zero if 'clear' is set.
+static Uint8 createTextureStorage(GPU_Renderer* renderer, GPU_Image* image, const unsigned char* pixels, Uint8 clear)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    GLsizei w = image->texture_w;
+    GLsizei h = image->texture_h;
+    GLuint handle;
+    Uint8 has_storage;
+    Uint8 filled = 0;
+
+    handle = takePooledTexture(cdata, w, h, data->format, &data->immutable);
+    has_storage = (handle != 0);
+    if(!has_storage)
+    {
+        glGenTextures( 1, &handle );
+        if(handle == 0)
+        {
+            GPU_PushErrorCode("GPU_CreateUninitializedImage", GPU_ERROR_BACKEND_ERROR, "Failed to generate a texture handle.");
+            return 0;
+        }
+    }
+    data->handle = handle;
+    data->poolable = 1;
+
+    flushAndBindTexture( renderer, handle );
+
+    // Set the texture's stretching properties (a pooled texture still has the ones from its last image)
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    #if defined(SDL_GPU_USE_GLES) && (SDL_GPU_GLES_TIER == 1)
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+    #endif
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    #ifdef SDL_GPU_USE_OPENGL
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
+    #endif
+
+    if(!has_storage)
+    {
+        #ifdef SDL_GPU_USE_OPENGL
+        GLenum sized_format = getSizedTextureFormat(data->format);
+        if(cdata->use_texture_storage && sized_format != 0)
+        {
+            glTexStorage2D(GL_TEXTURE_2D, 1, sized_format, w, h);
+            data->immutable = 1;
+        }
+        else
+        #endif
+        {
+            // Mutable storage is allocated and filled by one call, but the GPU can clear it without the zero upload
+            if(pixels == NULL && clear && !cdata->use_clear_texture)
+                pixels = getZeroBuffer(cdata, w*h*image->bytes_per_pixel);
+            glTexImage2D(GL_TEXTURE_2D, 0, data->format, w, h, 0,
+                         data->format, GL_UNSIGNED_BYTE, pixels);
+            data->immutable = 0;
+            filled = (pixels != NULL);
+        }
+    }
+
+    if(!filled)
+    {
+        if(pixels != NULL)
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, data->format, GL_UNSIGNED_BYTE, pixels);
+        else if(clear)
+            clearTexture(cdata, image);
+    }
+
+    // Restore GL defaults
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    #ifdef SDL_GPU_USE_OPENGL
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    #endif
+
+    setImageMemory(image, (Uint64)w*h*image->bytes_per_pixel);
+    enforceMemoryBudget(renderer, image);
+    return 1;
+}
+
 
 static GPU_Image* CreateImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format)
 {
 	GPU_Image* result;
-	GLenum internal_format;
-	static unsigned char* zero_buffer = NULL;
-	static unsigned int zero_buffer_size = 0;
 
     if(format < 1)
     {
         GPU_PushErrorCode("GPU_CreateImage", GPU_ERROR_DATA_ERROR, "Unsupported image format (0x%x)", format);
         return NULL;
     }
+    if(isCompressedFormat(format))
+    {
+        GPU_PushErrorCode("GPU_CreateImage", GPU_ERROR_USER_ERROR, "Compressed images can only be created from compressed data.");
+        return NULL;
+    }
 
     result = CreateUninitializedImage(renderer, w, h, format);
 
@@ -1912,44 +4247,12 @@ static GPU_Image* CreateImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_Fo
     }
 
     changeTexturing(renderer, 1);
-    bindTexture(renderer, result);
-
-    internal_format = ((GPU_IMAGE_DATA*)(result->data))->format;
-    w = result->w;
-    h = result->h;
-    if(!(renderer->enabled_features & GPU_FEATURE_NON_POWER_OF_TWO))
-    {
-        if(!isPowerOfTwo(w))
-            w = getNearestPowerOf2(w);
-        if(!isPowerOfTwo(h))
-            h = getNearestPowerOf2(h);
-    }
-
-    // Initialize texture using a blank buffer
-    if(zero_buffer_size < (unsigned int)(w*h*result->bytes_per_pixel))
+    if(!createTextureStorage(renderer, result, NULL, 1))
     {
-        SDL_free(zero_buffer);
-        zero_buffer_size = w*h*result->bytes_per_pixel;
-        zero_buffer = (unsigned char*)SDL_malloc(zero_buffer_size);
-        memset(zero_buffer, 0, zero_buffer_size);
+        freeUninitializedImage(result);
+        GPU_PushErrorCode("GPU_CreateImage", GPU_ERROR_BACKEND_ERROR, "Could not create image as requested.");
+        return NULL;
     }
-    
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    #ifdef SDL_GPU_USE_OPENGL
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
-    #endif
-    
-    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, w, h, 0,
-                 internal_format, GL_UNSIGNED_BYTE, zero_buffer);
-    // Tell SDL_gpu what we got (power-of-two requirements have made this change)
-    result->texture_w = w;
-    result->texture_h = h;
-    
-    // Restore GL defaults
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-    #ifdef SDL_GPU_USE_OPENGL
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    #endif
 
     return result;
 }
@@ -1993,11 +4296,19 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, Uint32 handle,
             bytes_per_pixel = 2;
             break;
         case GL_RGB:
+        #ifdef SDL_GPU_USE_OPENGL
+        case GL_RGB8:  // Sized formats, as glTexStorage2D() reports them
+        #endif
+            gl_format = GL_RGB;
             format = GPU_FORMAT_RGB;
             num_layers = 1;
             bytes_per_pixel = 3;
             break;
         case GL_RGBA:
+        #ifdef SDL_GPU_USE_OPENGL
+        case GL_RGBA8:
+        #endif
+            gl_format = GL_RGBA;
             format = GPU_FORMAT_RGBA;
             num_layers = 1;
             bytes_per_pixel = 4;
@@ -2009,6 +4320,8 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, Uint32 handle,
             break;
         #ifndef SDL_GPU_USE_GLES
         case GL_RG:
+        case GL_RG8:
+            gl_format = GL_RG;
             format = GPU_FORMAT_RG;
             num_layers = 1;
             bytes_per_pixel = 2;
@@ -2091,6 +4404,17 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, Uint32 handle,
     data->handle = handle;
     data->owns_handle = take_ownership;
     data->format = gl_format;
+    // Nothing is known about how this texture was allocated
+    data->poolable = 0;
+    data->immutable = 0;
+    data->owner = NULL;
+    data->memory_bytes = 0;
+    data->padding_bytes = 0;
+    data->memory_is_target = 0;
+    data->evicted_pixels = NULL;
+    data->lru_prev = NULL;
+    data->lru_next = NULL;
+    data->memory_context = NULL;
     
 
     result = (GPU_Image*)SDL_malloc(sizeof(GPU_Image));
@@ -2113,23 +4437,177 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, Uint32 handle,
     result->data = data;
     result->is_alias = 0;
 
-    result->using_virtual_resolution = 0;
-    result->w = w;
-    result->h = h;
-    
-    result->base_w = w;
-    result->base_h = h;
-    result->texture_w = w;
-    result->texture_h = h;
+    result->using_virtual_resolution = 0;
+    result->w = w;
+    result->h = h;
+    
+    result->base_w = w;
+    result->base_h = h;
+    result->texture_w = w;
+    result->texture_h = h;
+    result->texture_x = 0;
+    result->texture_y = 0;
+
+    // Only textures that are freed with the image are counted, assuming a single level
+    data->owner = result;
+    if(take_ownership)
+        setImageMemory(result, (Uint64)w*h*bytes_per_pixel);
+
+    return result;
+    #endif
+}
+
+// From http://stackoverflow.com/questions/5309471/getting-file-extension-in-c
+static const char *get_filename_ext(const char *filename)
+{
+    const char *dot = strrchr(filename, '.');
+    if(!dot || dot == filename)
+        return "";
+    return dot + 1;
+}
+
+// Decodes compressed data into an RGBA image for renderers that can't sample the format.  Prebuilt mipmaps are regenerated instead.
+static GPU_Image* createImageFromDecompressedData(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format, int num_levels, const unsigned char* const* level_data)
+{
+    GPU_Image* result;
+    unsigned char* pixels = (unsigned char*)SDL_malloc((size_t)w*h*4);
+    if(pixels == NULL)
+    {
+        GPU_PushErrorCode("GPU_CreateImageFromCompressedData", GPU_ERROR_BACKEND_ERROR, "Failed to allocate memory for decompression.");
+        return NULL;
+    }
+
+    gpu_decompress_image(format, w, h, level_data[0], pixels);
+
+    result = CreateUninitializedImage(renderer, w, h, GPU_FORMAT_RGBA);
+    if(result == NULL)
+    {
+        SDL_free(pixels);
+        return NULL;
+    }
+
+    changeTexturing(renderer, 1);
+    // Padding for a power-of-two texture has to be cleared
+    if(!createTextureStorage(renderer, result, NULL, (result->texture_w != w || result->texture_h != h)))
+    {
+        SDL_free(pixels);
+        freeUninitializedImage(result);
+        return NULL;
+    }
+    renderer->impl->UpdateImageBytes(renderer, result, NULL, pixels, w*4);
+    SDL_free(pixels);
+
+    if(num_levels > 1)
+        renderer->impl->GenerateMipmaps(renderer, result);
+    return result;
+}
+
+static GPU_Image* CreateImageFromCompressedData(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format, int num_levels, const unsigned char* const* level_data)
+{
+    GPU_Image* result;
+    GPU_IMAGE_DATA* data;
+    GLuint handle;
+    int max_levels, i;
+    Uint64 bytes;
+
+    if(level_data == NULL || num_levels < 1)
+    {
+        GPU_PushErrorCode("GPU_CreateImageFromCompressedData", GPU_ERROR_NULL_ARGUMENT, "level_data");
+        return NULL;
+    }
+    if(!isCompressedFormat(format))
+    {
+        GPU_PushErrorCode("GPU_CreateImageFromCompressedData", GPU_ERROR_USER_ERROR, "Not a compressed format (0x%x)", format);
+        return NULL;
+    }
+    if(w == 0 || h == 0)
+    {
+        GPU_PushErrorCode("GPU_CreateImageFromCompressedData", GPU_ERROR_USER_ERROR, "Given an empty image size.");
+        return NULL;
+    }
+
+    // Blocks can't be padded out to a power-of-two texture, so those go through decompression as well
+    if(!isCompressedFormatSupported(renderer, format)
+       || (!(renderer->enabled_features & GPU_FEATURE_NON_POWER_OF_TWO) && (!isPowerOfTwo(w) || !isPowerOfTwo(h))))
+        return createImageFromDecompressedData(renderer, w, h, format, num_levels, level_data);
+
+    // A full chain goes down to 1x1
+    max_levels = 1;
+    for(i = (w > h? w : h); i > 1; i /= 2)
+        max_levels++;
+    if(num_levels > max_levels)
+        num_levels = max_levels;
+    #ifdef SDL_GPU_USE_GLES
+    // Without GL_TEXTURE_MAX_LEVEL, a partial chain leaves the texture incomplete
+    if(num_levels < max_levels)
+        num_levels = 1;
+    #endif
+
+    result = CreateUninitializedImage(renderer, w, h, format);
+    if(result == NULL)
+        return NULL;
+    data = (GPU_IMAGE_DATA*)result->data;
+
+    glGenTextures(1, &handle);
+    if(handle == 0)
+    {
+        freeUninitializedImage(result);
+        GPU_PushErrorCode("GPU_CreateImageFromCompressedData", GPU_ERROR_BACKEND_ERROR, "Failed to generate a texture handle.");
+        return NULL;
+    }
+    data->handle = handle;
+
+    changeTexturing(renderer, 1);
+    flushAndBindTexture(renderer, handle);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (num_levels > 1? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    #if defined(SDL_GPU_USE_GLES) && (SDL_GPU_GLES_TIER == 1)
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    #endif
+    #ifdef SDL_GPU_USE_OPENGL
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
+    #endif
+
+    bytes = 0;
+    for(i = 0; i < num_levels; i++)
+    {
+        Uint16 level_w = (w >> i > 0? w >> i : 1);
+        Uint16 level_h = (h >> i > 0? h >> i : 1);
+        Uint64 level_size = gpu_get_compressed_size(format, level_w, level_h);
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, data->format, level_w, level_h, 0, (GLsizei)level_size, level_data[i]);
+        bytes += level_size;
+    }
 
+    result->has_mipmaps = (num_levels > 1);
+    setImageMemory(result, bytes);
+    enforceMemoryBudget(renderer, result);
     return result;
-    #endif
 }
 
 static GPU_Image* LoadImage(GPU_Renderer* renderer, const char* filename)
 {
 	GPU_Image* result;
-    SDL_Surface* surface = GPU_LoadSurface(filename);
+    SDL_Surface* surface;
+
+    if(filename != NULL && (gpu_strcasecmp(get_filename_ext(filename), "dds") == 0 || gpu_strcasecmp(get_filename_ext(filename), "ktx") == 0))
+    {
+        const unsigned char* levels[GPU_MAX_COMPRESSED_LEVELS];
+        GPU_FormatEnum format;
+        Uint16 w, h;
+        int num_levels;
+        unsigned char* file = gpu_load_compressed_file(filename, &format, &w, &h, &num_levels, levels, GPU_MAX_COMPRESSED_LEVELS);
+        if(file == NULL)
+            return NULL;
+
+        result = CreateImageFromCompressedData(renderer, w, h, format, num_levels, levels);
+        SDL_free(file);
+        return result;
+    }
+
+    surface = GPU_LoadSurface(filename);
     if(surface == NULL)
     {
         GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Failed to load image data.");
@@ -2169,8 +4647,9 @@ static Uint8 readTargetPixels(GPU_Renderer* renderer, GPU_Target* source, GLint
     if(source == NULL)
         return 0;
     
+    flushSortedBlitsUsingTarget(renderer, source, GPU_FLUSH_CAUSE_READBACK);
     if(isCurrentTarget(renderer, source))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_READBACK);
     
     if(bindFramebuffer(renderer, source))
     {
@@ -2209,12 +4688,12 @@ static Uint8 readImagePixels(GPU_Renderer* renderer, GPU_Image* source, GLint fo
     return result;
     #else
     // Bind the texture temporarily
-    glBindTexture(GL_TEXTURE_2D, ((GPU_IMAGE_DATA*)source->data)->handle);
+    bindTextureHandle((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, ((GPU_IMAGE_DATA*)source->data)->handle);
     // Get the data
     glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, pixels);
     // Rebind the last texture
     if(((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image != NULL)
-        glBindTexture(GL_TEXTURE_2D, ((GPU_IMAGE_DATA*)(((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)->data)->handle);
+        bindTextureHandle((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, ((GPU_IMAGE_DATA*)(((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)->data)->handle);
     return 1;
     #endif
 }
@@ -2227,8 +4706,9 @@ static unsigned char* getRawTargetData(GPU_Renderer* renderer, GPU_Target* targe
 	unsigned char* copy;
 	int y;
 
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_READBACK);
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_READBACK);
     
     bytes_per_pixel = 4;
     if(target->image != NULL)
@@ -2263,13 +4743,24 @@ static unsigned char* getRawImageData(GPU_Renderer* renderer, GPU_Image* image)
 {
 	unsigned char* data;
 
+    if(image->target != NULL)
+        flushSortedBlitsUsingTarget(renderer, image->target, GPU_FLUSH_CAUSE_READBACK);
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_READBACK);
     
     data = (unsigned char*)SDL_malloc(image->texture_w * image->texture_h * image->bytes_per_pixel);
     
+    // An evicted image already has its pixels in client memory
+    if(isImageEvicted(image))
+    {
+        if(data != NULL)
+            memcpy(data, ((GPU_IMAGE_DATA*)image->data)->evicted_pixels, image->texture_w * image->texture_h * image->bytes_per_pixel);
+        return data;
+    }
+    
     // FIXME: Sometimes the texture is stored and read in RGBA even when I specify RGB.  getRawImageData() might need to return the stored format or Bpp.
-    if(!readImagePixels(renderer, image, ((GPU_IMAGE_DATA*)image->data)->format, data))
+    // Compressed textures are decompressed by the driver.
+    if(!readImagePixels(renderer, image, (isCompressedFormat(image->format)? GL_RGBA : ((GPU_IMAGE_DATA*)image->data)->format), data))
     {
         SDL_free(data);
         return NULL;
@@ -2278,13 +4769,147 @@ static unsigned char* getRawImageData(GPU_Renderer* renderer, GPU_Image* image)
     return data;
 }
 
-// From http://stackoverflow.com/questions/5309471/getting-file-extension-in-c
-static const char *get_filename_ext(const char *filename)
+// Only plain single-level textures that belong to one image can be copied out and recreated by createTextureStorage().
+// The list covers every context, but a texture is only read back and deleted in the context that made it.
+static Uint8 isImageEvictable(GPU_Context* context, GPU_IMAGE_DATA* data)
 {
-    const char *dot = strrchr(filename, '.');
-    if(!dot || dot == filename)
-        return "";
-    return dot + 1;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    GPU_Image* image = data->owner;
+    
+    if(data->memory_context != context)
+        return 0;
+    if(image == NULL || data->evicted_pixels != NULL || !data->owns_handle || !data->poolable || data->refcount > 1 || data->memory_is_target)
+        return 0;
+    if(image->target != NULL || image == cdata->white_texel || image == cdata->locked_image)
+        return 0;
+    #ifdef SDL_GPU_USE_GLES
+    // Pixels are read back through a framebuffer, which only reliably gives RGBA
+    if(image->format != GPU_FORMAT_RGBA)
+        return 0;
+    #endif
+    return 1;
+}
+
+static Uint8 evictImage(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, GPU_IMAGE_DATA* data)
+{
+    GPU_Image* image = data->owner;
+    unsigned char* pixels;
+    
+    flushAndClearBlitBufferIfCurrentTexture(renderer, image);
+    
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    pixels = getRawImageData(renderer, image);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    if(pixels == NULL)
+        return 0;
+    
+    uncountImageMemory(data);
+    deleteTextureHandle(cdata, data->handle);
+    data->handle = 0;
+    data->evicted_pixels = pixels;
+    countImageMemory(data);
+    
+    memory_stats.evictions++;
+    return 1;
+}
+
+// Uploads the pixels of an evicted image into a new texture.  Returns 0 if it couldn't, in which case the image stays evicted.
+static Uint8 restoreEvictedImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    unsigned char* pixels = data->evicted_pixels;
+    
+    if(pixels == NULL)
+        return 1;
+    
+    // Counted as resident first, so that making room for it doesn't evict it again
+    uncountImageMemory(data);
+    data->evicted_pixels = NULL;
+    countImageMemory(data);
+    
+    changeTexturing(renderer, 1);
+    if(!createTextureStorage(renderer, image, pixels, 0))
+    {
+        uncountImageMemory(data);
+        data->evicted_pixels = pixels;
+        countImageMemory(data);
+        return 0;
+    }
+    SDL_free(pixels);
+    
+    // The new texture has the default filter and wrap modes
+    if(image->filter_mode != GPU_FILTER_LINEAR)
+        renderer->impl->SetImageFilter(renderer, image, image->filter_mode);
+    if(image->wrap_mode_x != GPU_WRAP_NONE || image->wrap_mode_y != GPU_WRAP_NONE)
+        renderer->impl->SetWrapMode(renderer, image, image->wrap_mode_x, image->wrap_mode_y);
+    
+    memory_stats.restores++;
+    return 1;
+}
+
+static_inline Uint64 getTotalMemory(void)
+{
+    return memory_stats.image_bytes + memory_stats.target_bytes + memory_stats.pool_bytes;
+}
+
+// Frees pooled textures and then evicts the least recently bound images until the total is within the budget.  'keep' is never evicted.
+static void enforceMemoryBudget(GPU_Renderer* renderer, GPU_Image* keep)
+{
+    GPU_CONTEXT_DATA* cdata;
+    GPU_IMAGE_DATA* data;
+    GPU_IMAGE_DATA* next;
+    Uint8 evicted = 0;
+    
+    if(memory_stats.budget_bytes == 0 || getTotalMemory() <= memory_stats.budget_bytes || renderer->current_context_target == NULL)
+        return;
+    
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    
+    // Nothing is using the pooled textures, so they go first (oldest first)
+    while(cdata->texture_pool_size > 0 && getTotalMemory() > memory_stats.budget_bytes)
+    {
+        deleteTextureHandle(cdata, cdata->texture_pool[0].handle);
+        memory_stats.pool_bytes -= cdata->texture_pool[0].bytes;
+        cdata->texture_pool_size--;
+        memmove(cdata->texture_pool, cdata->texture_pool+1, cdata->texture_pool_size*sizeof(GPU_POOLED_TEXTURE_DATA));
+    }
+    
+    // Drawing the recorded blits binds textures, which would reorder the list while it's being walked
+    flushSortedBlits(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+    
+    for(data = memory_lru_first; data != NULL && getTotalMemory() > memory_stats.budget_bytes; data = next)
+    {
+        next = data->lru_next;
+        if((keep != NULL && data == keep->data) || !isImageEvictable(renderer->current_context_target->context, data))
+            continue;
+        
+        if(evictImage(renderer, cdata, data))
+            evicted = 1;
+    }
+    
+    // Callers expect the texture they just created to still be bound
+    if(evicted && keep != NULL && !isImageEvicted(keep))
+        flushAndBindTexture(renderer, ((GPU_IMAGE_DATA*)keep->data)->handle);
+}
+
+static Uint64 GetImageMemoryUsage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    (void)renderer;
+    return ((GPU_IMAGE_DATA*)image->data)->memory_bytes;
+}
+
+static GPU_MemoryStats GetMemoryStats(GPU_Renderer* renderer)
+{
+    GPU_MemoryStats stats = memory_stats;
+    (void)renderer;
+    stats.total_bytes = getTotalMemory();
+    return stats;
+}
+
+static void SetMemoryBudget(GPU_Renderer* renderer, Uint64 bytes)
+{
+    memory_stats.budget_bytes = bytes;
+    enforceMemoryBudget(renderer, NULL);
 }
 
 static Uint8 SaveImage(GPU_Renderer* renderer, GPU_Image* image, const char* filename, GPU_FileFormatEnum format)
@@ -2868,9 +5493,6 @@ static GPU_Image* CopyImage(GPU_Renderer* renderer, GPU_Image* image)
         case GPU_FORMAT_RG:
         // Copy via texture download and upload (slow)
 		{
-			GLenum internal_format;
-			int w;
-			int h;
             unsigned char* texture_data = getRawImageData(renderer, image);
             if(texture_data == NULL)
             {
@@ -2887,36 +5509,14 @@ static GPU_Image* CopyImage(GPU_Renderer* renderer, GPU_Image* image)
             }
             
             changeTexturing(renderer, 1);
-            bindTexture(renderer, result);
-
-            internal_format = ((GPU_IMAGE_DATA*)(result->data))->format;
-            w = result->w;
-            h = result->h;
-            if(!(renderer->enabled_features & GPU_FEATURE_NON_POWER_OF_TWO))
+            if(!createTextureStorage(renderer, result, texture_data, 0))
             {
-                if(!isPowerOfTwo(w))
-                    w = getNearestPowerOf2(w);
-                if(!isPowerOfTwo(h))
-                    h = getNearestPowerOf2(h);
+                SDL_free(texture_data);
+                freeUninitializedImage(result);
+                GPU_PushErrorCode("GPU_CopyImage", GPU_ERROR_BACKEND_ERROR, "Failed to create new image.");
+                return NULL;
             }
             
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-            #ifdef SDL_GPU_USE_OPENGL
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
-            #endif
-            
-            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, w, h, 0,
-                         internal_format, GL_UNSIGNED_BYTE, texture_data);
-            // Tell SDL_gpu what we got.
-            result->texture_w = w;
-            result->texture_h = h;
-            
-            // Restore GL defaults
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-            #ifdef SDL_GPU_USE_OPENGL
-            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-            #endif
-            
             SDL_free(texture_data);
         }
         break;
@@ -2958,6 +5558,11 @@ static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect
 
     if(image == NULL || surface == NULL)
         return;
+    if(isCompressedFormat(image->format))
+    {
+        GPU_PushErrorCode("GPU_UpdateImage", GPU_ERROR_USER_ERROR, "Compressed images can't be updated.");
+        return;
+    }
 
     data = (GPU_IMAGE_DATA*)image->data;
     original_format = data->format;
@@ -3037,9 +5642,12 @@ static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect
     }
 
 
+    flushSortedBlitsUsingImage(renderer, image);
     changeTexturing(renderer, 1);
+    if(image->target != NULL)
+        flushSortedBlitsUsingTarget(renderer, image->target, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
     bindTexture(renderer, image);
     alignment = 1;
     if(newSurface->format->BytesPerPixel == 4)
@@ -3060,7 +5668,7 @@ static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect
     pixels += (int)(newSurface->pitch * sourceRect.y + (newSurface->format->BytesPerPixel)*sourceRect.x);
     
     glTexSubImage2D(GL_TEXTURE_2D, 0,
-                    updateRect.x, updateRect.y, updateRect.w, updateRect.h,
+                    image->texture_x + updateRect.x, image->texture_y + updateRect.y, updateRect.w, updateRect.h,
                     original_format, GL_UNSIGNED_BYTE, pixels);
 
     // Delete temporary surface
@@ -3075,19 +5683,10 @@ static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect
 }
 
 
-static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+// Clips the given rectangle (or the whole image if NULL) to the image.  Returns 0 on failure.
+static Uint8 getUpdateRect(GPU_Image* image, const GPU_Rect* image_rect, GPU_Rect* result)
 {
-	GPU_IMAGE_DATA* data;
-	GLenum original_format;
-
 	GPU_Rect updateRect;
-	int alignment;
-
-    if(image == NULL || bytes == NULL)
-        return;
-
-    data = (GPU_IMAGE_DATA*)image->data;
-    original_format = data->format;
 
     if(image_rect != NULL)
     {
@@ -3121,14 +5720,25 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
         if(updateRect.w < 0.0f || updateRect.h < 0.0f)
         {
             GPU_PushErrorCode("GPU_UpdateImage", GPU_ERROR_USER_ERROR, "Given negative image rectangle.");
-            return;
+            return 0;
         }
     }
 
+    *result = updateRect;
+    return 1;
+}
+
+// Uploads to the image from 'bytes', which is an offset into the bound pixel unpack buffer if there is one.
+static void uploadImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* updateRect, const unsigned char* bytes, int bytes_per_row)
+{
+	int alignment;
 
+    flushSortedBlitsUsingImage(renderer, image);
     changeTexturing(renderer, 1);
+    if(image->target != NULL)
+        flushSortedBlitsUsingTarget(renderer, image->target, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
     bindTexture(renderer, image);
     alignment = 1;
     glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
@@ -3137,8 +5747,8 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
     #endif
     
     glTexSubImage2D(GL_TEXTURE_2D, 0,
-                    updateRect.x, updateRect.y, updateRect.w, updateRect.h,
-                    original_format, GL_UNSIGNED_BYTE, bytes);
+                    image->texture_x + updateRect->x, image->texture_y + updateRect->y, updateRect->w, updateRect->h,
+                    ((GPU_IMAGE_DATA*)image->data)->format, GL_UNSIGNED_BYTE, bytes);
     
     // Restore GL defaults
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
@@ -3147,6 +5757,195 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
     #endif
 }
 
+static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+	GPU_Rect updateRect;
+
+    if(image == NULL || bytes == NULL)
+        return;
+    if(isCompressedFormat(image->format))
+    {
+        GPU_PushErrorCode("GPU_UpdateImageBytes", GPU_ERROR_USER_ERROR, "Compressed images can't be updated.");
+        return;
+    }
+
+    if(!getUpdateRect(image, image_rect, &updateRect))
+        return;
+
+    uploadImageBytes(renderer, image, &updateRect, bytes, bytes_per_row);
+}
+
+
+static unsigned char* LockImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, int* bytes_per_row)
+{
+    GPU_CONTEXT_DATA* cdata;
+    GPU_Rect updateRect;
+    unsigned int pitch, size;
+    unsigned char* result = NULL;
+
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_LockImageBytes", GPU_ERROR_NULL_ARGUMENT, "image");
+        return NULL;
+    }
+    if(renderer != image->renderer)
+    {
+        GPU_PushErrorCode("GPU_LockImageBytes", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return NULL;
+    }
+    if(isCompressedFormat(image->format))
+    {
+        GPU_PushErrorCode("GPU_LockImageBytes", GPU_ERROR_USER_ERROR, "Compressed images can't be updated.");
+        return NULL;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->locked_image != NULL)
+    {
+        GPU_PushErrorCode("GPU_LockImageBytes", GPU_ERROR_USER_ERROR, "Another image is already locked.");
+        return NULL;
+    }
+
+    if(!getUpdateRect(image, image_rect, &updateRect) || updateRect.w <= 0 || updateRect.h <= 0)
+        return NULL;
+
+    // Restoring it later would upload from client memory while the pixel buffer is bound
+    if(!restoreEvictedImage(renderer, image))
+        return NULL;
+
+    pitch = (unsigned int)updateRect.w * image->bytes_per_pixel;
+    size = pitch * (unsigned int)updateRect.h;
+
+    #ifdef SDL_GPU_USE_BUFFER_RING
+    {
+        GPU_RING_BUFFER_DATA* ring = &cdata->upload_ring;
+
+        // Each region holds at least one upload, so a region per frame in flight is enough to not wait on the GPU
+        if(size > ring->region_size)
+            createRing(cdata, ring, GL_PIXEL_UNPACK_BUFFER, (size > 2*ring->region_size? size : 2*ring->region_size));
+
+        if(ring->VBO != 0)
+        {
+            unsigned int offset;
+
+            reserveRing(ring, size, 16);
+            offset = ring->region * ring->region_size + ring->offset;
+            if(ring->mapping != NULL)
+                result = ring->mapping + offset;
+            else
+            {
+                // The fences already guarantee that this range is not in use
+                bindRing(cdata, ring);
+                result = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                unbindRing(ring);
+            }
+        }
+    }
+    #endif
+
+    if(result == NULL)
+    {
+        if(cdata->staging_buffer_size < size)
+        {
+            SDL_free(cdata->staging_buffer);
+            cdata->staging_buffer = (unsigned char*)SDL_malloc(size);
+            cdata->staging_buffer_size = (cdata->staging_buffer == NULL? 0 : size);
+            if(cdata->staging_buffer == NULL)
+            {
+                GPU_PushErrorCode("GPU_LockImageBytes", GPU_ERROR_BACKEND_ERROR, "Failed to allocate staging memory.");
+                return NULL;
+            }
+        }
+        result = cdata->staging_buffer;
+    }
+
+    cdata->locked_image = image;
+    cdata->locked_rect = updateRect;
+    cdata->locked_bytes = result;
+    if(bytes_per_row != NULL)
+        *bytes_per_row = (int)pitch;
+    return result;
+}
+
+// Ends the lock.  The pixels are uploaded to the image if 'upload' is set, else they're dropped.
+static void endImageLock(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, Uint8 upload)
+{
+    GPU_Image* image = cdata->locked_image;
+    GPU_Rect* updateRect = &cdata->locked_rect;
+    int pitch = updateRect->w * image->bytes_per_pixel;
+
+    #ifdef SDL_GPU_USE_BUFFER_RING
+    if(cdata->locked_bytes != cdata->staging_buffer)
+    {
+        GPU_RING_BUFFER_DATA* ring = &cdata->upload_ring;
+        unsigned int offset = ring->region * ring->region_size + ring->offset;
+
+        bindRing(cdata, ring);
+        if(ring->mapping == NULL)
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        // The copy from the buffer is queued like a draw, so this returns without waiting for it
+        if(upload)
+            uploadImageBytes(renderer, image, updateRect, (const unsigned char*)(size_t)offset, pitch);
+        unbindRing(ring);
+
+        // The region's fence covers this upload once the ring moves past it
+        ring->offset += pitch * updateRect->h;
+    }
+    else
+    #endif
+    if(upload)
+        uploadImageBytes(renderer, image, updateRect, cdata->locked_bytes, pitch);
+
+    cdata->locked_image = NULL;
+    cdata->locked_bytes = NULL;
+}
+
+static void UnlockImageBytes(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_CONTEXT_DATA* cdata;
+
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_UnlockImageBytes", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    if(cdata->locked_image != image)
+    {
+        GPU_PushErrorCode("GPU_UnlockImageBytes", GPU_ERROR_USER_ERROR, "Image is not locked.");
+        return;
+    }
+
+    endImageLock(renderer, cdata, 1);
+}
+
+static void UpdateImageBytesAsync(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row)
+{
+    #ifdef SDL_GPU_USE_BUFFER_RING
+    GPU_CONTEXT_DATA* cdata;
+    unsigned char* pixels;
+    int pitch, row_size, y;
+
+    if(image == NULL || bytes == NULL)
+        return;
+
+    pixels = LockImageBytes(renderer, image, image_rect, &pitch);
+    if(pixels == NULL)
+        return;
+
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    row_size = cdata->locked_rect.w * image->bytes_per_pixel;
+    for(y = 0; y < cdata->locked_rect.h; y++)
+        memcpy(pixels + y*pitch, bytes + y*bytes_per_row, row_size);
+
+    UnlockImageBytes(renderer, image);
+    #else
+    // Without a pixel buffer ring, staging the pixels would only add a copy
+    UpdateImageBytes(renderer, image, image_rect, bytes, bytes_per_row);
+    #endif
+}
+
 
 static_inline Uint32 getPixel(SDL_Surface *Surface, int x, int y)
 {
@@ -3207,10 +6006,18 @@ static GPU_Image* CopyImageFromSurface(GPU_Renderer* renderer, SDL_Surface* surf
     else
         format = GPU_FORMAT_RGBA;
     
-    image = renderer->impl->CreateImage(renderer, surface->w, surface->h, format);
+    image = CreateUninitializedImage(renderer, surface->w, surface->h, format);
     if(image == NULL)
         return NULL;
 
+    // The surface covers the whole texture unless it was padded to a power of two, so there is nothing to clear
+    changeTexturing(renderer, 1);
+    if(!createTextureStorage(renderer, image, NULL, (image->texture_w != surface->w || image->texture_h != surface->h)))
+    {
+        freeUninitializedImage(image);
+        return NULL;
+    }
+
     renderer->impl->UpdateImage(renderer, image, NULL, surface, NULL);
 
     return image;
@@ -3254,6 +6061,10 @@ static void FreeImage(GPU_Renderer* renderer, GPU_Image* image)
         renderer->impl->FreeTarget(renderer, target);
     }
 
+    // Drop pixels that were never unlocked
+    if(renderer->current_context_target != NULL && ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->locked_image == image)
+        endImageLock(renderer, (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, 0);
+
     flushAndClearBlitBufferIfCurrentTexture(renderer, image);
     
     // Does the renderer data need to be freed too?
@@ -3261,11 +6072,22 @@ static void FreeImage(GPU_Renderer* renderer, GPU_Image* image)
     if(data->refcount > 1)
     {
         data->refcount--;
+        // The aliases don't know how to evict the texture
+        if(data->owner == image)
+            data->owner = NULL;
     }
     else
     {
-        if(data->owns_handle)
-            glDeleteTextures( 1, &data->handle);
+        if(data->owns_handle && data->evicted_pixels == NULL)
+        {
+            if(renderer->current_context_target == NULL)
+                glDeleteTextures( 1, &data->handle);
+            else if(data->poolable)
+                poolTexture((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, image);
+            else
+                deleteTextureHandle((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, data->handle);
+        }
+        forgetImageMemory(data);
         SDL_free(data);
     }
     
@@ -3294,6 +6116,9 @@ static GPU_Target* LoadTarget(GPU_Renderer* renderer, GPU_Image* image)
     if(!(renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS))
         return NULL;
 
+    if(!restoreEvictedImage(renderer, image))
+        return NULL;
+
     // Create framebuffer object
     glGenFramebuffers(1, &handle);
     flushAndBindFramebuffer(renderer, handle);
@@ -3335,6 +6160,7 @@ static GPU_Target* LoadTarget(GPU_Renderer* renderer, GPU_Image* image)
     result->use_color = 0;
 
     image->target = result;
+    setImageMemoryIsTarget((GPU_IMAGE_DATA*)image->data, 1);
     return result;
 }
 
@@ -3362,6 +6188,14 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
         
         SDL_free(cdata->blit_buffer);
         SDL_free(cdata->index_buffer);
+        SDL_free(cdata->quad_index_buffer);
+        SDL_free(cdata->sorted_blit_buffer);
+        #ifdef SDL_GPU_USE_INSTANCING
+        SDL_free(cdata->instance_buffer);
+        #endif
+        #ifndef SDL_GPU_DISABLE_SHADERS
+        freeUniforms(cdata);
+        #endif
         
         #ifdef SDL_GPU_USE_SDL2
         if(target->context->context != 0)
@@ -3383,14 +6217,20 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
         return;
     }
     
+    if(renderer->current_context_target != NULL)
+        flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+    
     if(target == renderer->current_context_target)
     {
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
         renderer->current_context_target = NULL;
     }
     
     if(!target->is_alias && target->image != NULL)
+    {
         target->image->target = NULL;  // Remove reference to this object
+        setImageMemoryIsTarget((GPU_IMAGE_DATA*)target->image->data, 0);
+    }
     
 
     // Does the renderer data need to be freed too?
@@ -3407,22 +6247,65 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
         if(renderer->current_context_target != NULL)
             flushAndClearBlitBufferIfCurrentFramebuffer(renderer, target);
         if(data->handle != 0)
+        {
+            if(renderer->current_context_target != NULL && ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->gl_framebuffer == data->handle)
+                ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->gl_framebuffer = 0;
             glDeleteFramebuffers(1, &data->handle);
+        }
     }
     
     if(target->context != NULL)
     {
         GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)target->context->data;
         
+        // The context is going away, so its white texel doesn't go through FreeImage()
+        if(cdata->white_texel != NULL)
+        {
+            glDeleteTextures(1, &((GPU_IMAGE_DATA*)cdata->white_texel->data)->handle);
+            forgetImageMemory((GPU_IMAGE_DATA*)cdata->white_texel->data);
+            SDL_free(cdata->white_texel->data);
+            SDL_free(cdata->white_texel);
+        }
+        freeTexturePool(cdata);
+        SDL_free(cdata->zero_buffer);
+        SDL_free(cdata->staging_buffer);
+        
         SDL_free(cdata->blit_buffer);
         SDL_free(cdata->index_buffer);
+        SDL_free(cdata->quad_index_buffer);
+        SDL_free(cdata->sorted_blit_buffer);
+        #ifndef SDL_GPU_DISABLE_SHADERS
+        freeUniforms(cdata);
+        #endif
+        #ifdef SDL_GPU_USE_INSTANCING
+        SDL_free(cdata->instance_buffer);
+        if(cdata->use_instancing)
+        {
+            glDeleteBuffers(1, &cdata->instance_VBO);
+            glDeleteVertexArrays(1, &cdata->instance_VAO);
+        }
+        #endif
     
         #ifdef SDL_GPU_USE_BUFFER_PIPELINE
         glDeleteBuffers(2, cdata->blit_VBO);
         glDeleteBuffers(1, &cdata->blit_IBO);
+        glDeleteBuffers(1, &cdata->blit_quad_IBO);
+            #ifdef SDL_GPU_USE_BUFFER_RING
+            freeRing(cdata, &cdata->blit_ring);
+            freeRing(cdata, &cdata->attribute_ring);
+            freeRing(cdata, &cdata->upload_ring);
+            #endif
         glDeleteBuffers(16, cdata->attribute_VBO);
             #if !defined(SDL_GPU_NO_VAO)
             glDeleteVertexArrays(1, &cdata->blit_VAO);
+            {
+                int i;
+                for(i = 0; i < GPU_VERTEX_FORMAT_CACHE_SIZE; i++)
+                {
+                    if(cdata->vertex_formats[i].VAO != 0)
+                        glDeleteVertexArrays(1, &cdata->vertex_formats[i].VAO);
+                }
+            }
             #endif
         #endif
     
@@ -3450,56 +6333,48 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
 #define SET_TEXTURED_VERTEX(x, y, s, t, r, g, b, a) \
     blit_buffer[vert_index] = x; \
     blit_buffer[vert_index+1] = y; \
-    blit_buffer[tex_index] = s; \
-    blit_buffer[tex_index+1] = t; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
-    index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices++; \
-    vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
-    tex_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
-    color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    setBlitBufferTexCoords(cdata, blit_buffer, tex_index, s, t); \
+    setBlitBufferColor(cdata, blit_buffer, color_index, r, g, b, a); \
+    setBlitBufferTextureSlot(cdata, blit_buffer, vert_index); \
+    pushIndex(cdata, cdata->blit_buffer_num_vertices++); \
+    vert_index += cdata->blit_buffer_floats_per_vertex; \
+    tex_index += cdata->blit_buffer_floats_per_vertex; \
+    color_index += cdata->blit_buffer_floats_per_vertex;
 
 #define SET_TEXTURED_VERTEX_UNINDEXED(x, y, s, t, r, g, b, a) \
     blit_buffer[vert_index] = x; \
     blit_buffer[vert_index+1] = y; \
-    blit_buffer[tex_index] = s; \
-    blit_buffer[tex_index+1] = t; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
-    vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
-    tex_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
-    color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    setBlitBufferTexCoords(cdata, blit_buffer, tex_index, s, t); \
+    setBlitBufferColor(cdata, blit_buffer, color_index, r, g, b, a); \
+    setBlitBufferTextureSlot(cdata, blit_buffer, vert_index); \
+    vert_index += cdata->blit_buffer_floats_per_vertex; \
+    tex_index += cdata->blit_buffer_floats_per_vertex; \
+    color_index += cdata->blit_buffer_floats_per_vertex;
     
 #define SET_UNTEXTURED_VERTEX(x, y, r, g, b, a) \
     blit_buffer[vert_index] = x; \
     blit_buffer[vert_index+1] = y; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
-    index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices++; \
-    vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
-    color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    setBlitBufferColor(cdata, blit_buffer, color_index, r, g, b, a); \
+    if(cdata->shapes_use_white_texel) \
+        setBlitBufferWhiteTexel(cdata, blit_buffer, vert_index); \
+    pushIndex(cdata, cdata->blit_buffer_num_vertices++); \
+    vert_index += cdata->blit_buffer_floats_per_vertex; \
+    color_index += cdata->blit_buffer_floats_per_vertex;
     
 #define SET_UNTEXTURED_VERTEX_UNINDEXED(x, y, r, g, b, a) \
     blit_buffer[vert_index] = x; \
     blit_buffer[vert_index+1] = y; \
-    blit_buffer[color_index] = r; \
-    blit_buffer[color_index+1] = g; \
-    blit_buffer[color_index+2] = b; \
-    blit_buffer[color_index+3] = a; \
-    vert_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
-    color_index += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+    setBlitBufferColor(cdata, blit_buffer, color_index, r, g, b, a); \
+    if(cdata->shapes_use_white_texel) \
+        setBlitBufferWhiteTexel(cdata, blit_buffer, vert_index); \
+    vert_index += cdata->blit_buffer_floats_per_vertex; \
+    color_index += cdata->blit_buffer_floats_per_vertex;
 
 #define SET_INDEXED_VERTEX(offset) \
-    index_buffer[cdata->index_buffer_num_vertices++] = blit_buffer_starting_index + (offset);
+    pushIndex(cdata, blit_buffer_starting_index + (offset));
 
 #define SET_RELATIVE_INDEXED_VERTEX(offset) \
-    index_buffer[cdata->index_buffer_num_vertices++] = cdata->blit_buffer_num_vertices + (offset);
+    pushIndex(cdata, cdata->blit_buffer_num_vertices + (offset));
     
 
 
@@ -3531,6 +6406,298 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
 
 
 
+#ifdef SDL_GPU_USE_INSTANCING
+// Sprite batches go through the instanced path when the default textured shader is active.
+static_inline Uint8 canInstanceSprites(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    int i;
+    
+    if(!cdata->use_instancing || context->current_shader_program != context->default_textured_shader_program)
+        return 0;
+    
+    // Attribute sources give values per vertex, which the instance records have no room for
+    for(i = 0; i < 16; i++)
+    {
+        GPU_AttributeSource* a = &cdata->shader_attributes[i];
+        if(a->attribute.values != NULL && a->attribute.location >= 0 && a->num_values > 0)
+            return 0;
+    }
+    return 1;
+}
+
+static void addSpriteInstance(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, float dx1, float dy1, float dx2, float dy2, float x, float y, float radians, float s1, float t1, float s2, float t2, float r, float g, float b, float a)
+{
+    float* instance;
+    Uint8* rgba;
+    
+    // Sprites that were batched as vertices have to go out first
+    if(cdata->blit_buffer_num_vertices > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
+    
+    if(cdata->instance_buffer_num_instances + 1 >= cdata->instance_buffer_max_num_instances)
+    {
+        if(!growInstanceBuffer(cdata, cdata->instance_buffer_num_instances + 1))
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+    }
+    
+    instance = cdata->instance_buffer + cdata->instance_buffer_num_instances*GPU_INSTANCE_BUFFER_FLOATS_PER_INSTANCE;
+    instance[0] = dx1;
+    instance[1] = dy1;
+    instance[2] = dx2;
+    instance[3] = dy2;
+    instance[4] = x;
+    instance[5] = y;
+    instance[6] = radians;
+    instance[7] = s1;
+    instance[8] = t1;
+    instance[9] = s2;
+    instance[10] = t2;
+    rgba = (Uint8*)(instance + 11);
+    rgba[0] = (Uint8)(r*255.0f + 0.5f);
+    rgba[1] = (Uint8)(g*255.0f + 0.5f);
+    rgba[2] = (Uint8)(b*255.0f + 0.5f);
+    rgba[3] = (Uint8)(a*255.0f + 0.5f);
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    instance[12] = (float)cdata->current_texture_slot;
+    #else
+    instance[12] = 0.0f;
+    #endif
+    
+    cdata->instance_buffer_num_instances++;
+}
+#endif
+
+// Adds one sprite to the current batch, as an instance when possible.  The corners are relative to (x, y), which is also the rotation origin.
+static void addSprite(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, float dx1, float dy1, float dx2, float dy2, float x, float y, float radians, float s1, float t1, float s2, float t2, float r, float g, float b, float a)
+{
+	float sinA, cosA;
+	float* blit_buffer;
+	int vert_index;
+	int tex_index;
+	int color_index;
+	
+    #ifdef SDL_GPU_USE_INSTANCING
+    if(canInstanceSprites(renderer, cdata))
+    {
+        // Rotation and translation happen in the vertex shader
+        addSpriteInstance(renderer, cdata, dx1, dy1, dx2, dy2, x, y, radians, s1, t1, s2, t2, r, g, b, a);
+        return;
+    }
+    if(cdata->instance_buffer_num_instances > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
+    #endif
+
+    if(cdata->blit_buffer_num_vertices + 4 >= cdata->blit_buffer_max_num_vertices)
+    {
+        if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + 4))
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+    }
+    if(cdata->blit_buffer_uses_index_buffer && cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
+    {
+        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + 6))
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+    }
+    
+    sinA = 0.0f;
+    cosA = 1.0f;
+    if(radians != 0.0f)
+        GPU_SinCos(radians, &sinA, &cosA);
+    
+    blit_buffer = cdata->blit_buffer;
+    
+    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex;
+    tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex;
+    color_index = cdata->blit_buffer_color_offset + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex;
+    
+    if(!cdata->packed_tex_coords && !cdata->packed_colors)
+    {
+        // All-float vertices come from the vectorized kernel
+        GPU_MakeSpriteVertices(blit_buffer + vert_index, cdata->blit_buffer_floats_per_vertex, dx1, dy1, dx2, dy2, x, y, sinA, cosA, s1, t1, s2, t2, r, g, b, a);
+        setBlitBufferTextureSlot(cdata, blit_buffer, vert_index);
+        setBlitBufferTextureSlot(cdata, blit_buffer, vert_index + cdata->blit_buffer_floats_per_vertex);
+        setBlitBufferTextureSlot(cdata, blit_buffer, vert_index + 2*cdata->blit_buffer_floats_per_vertex);
+        setBlitBufferTextureSlot(cdata, blit_buffer, vert_index + 3*cdata->blit_buffer_floats_per_vertex);
+    }
+    else
+    {
+        // Get extra vertices for rotation
+        float dx3 = dx2;
+        float dy3 = dy1;
+        float dx4 = dx1;
+        float dy4 = dy2;
+        
+        // Rotate about origin (the pivot)
+        if(radians != 0.0f)
+        {
+            float tempX = dx1;
+            dx1 = dx1*cosA - dy1*sinA;
+            dy1 = tempX*sinA + dy1*cosA;
+            tempX = dx2;
+            dx2 = dx2*cosA - dy2*sinA;
+            dy2 = tempX*sinA + dy2*cosA;
+            tempX = dx3;
+            dx3 = dx3*cosA - dy3*sinA;
+            dy3 = tempX*sinA + dy3*cosA;
+            tempX = dx4;
+            dx4 = dx4*cosA - dy4*sinA;
+            dy4 = tempX*sinA + dy4*cosA;
+        }
+        
+        // Translate to pos
+        dx1 += x;
+        dx2 += x;
+        dx3 += x;
+        dx4 += x;
+        dy1 += y;
+        dy2 += y;
+        dy3 += y;
+        dy4 += y;
+        
+        // 4 Quad vertices
+        SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, s1, t1, r, g, b, a);
+        SET_TEXTURED_VERTEX_UNINDEXED(dx3, dy3, s2, t1, r, g, b, a);
+        SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, s2, t2, r, g, b, a);
+        SET_TEXTURED_VERTEX_UNINDEXED(dx4, dy4, s1, t2, r, g, b, a);
+    }
+
+    // The 6 triangle indices come from the pre-built quad index buffer, unless triangles share the batch
+    if(cdata->blit_buffer_uses_index_buffer)
+        pushQuadIndices(cdata, cdata->blit_buffer_num_vertices, 1);
+    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+}
+
+
+// A blit recorded in GPU_BATCH_MODE_SORTED.  The sprite is kept in the same form that addSprite() takes, with the state it was blitted with.
+typedef struct GPU_SortedBlit
+{
+    unsigned int segment;
+    int layer;
+    Uint8 use_blending;
+    GPU_BlendMode blend_mode;
+    Uint32 texture;
+    unsigned int order;  // Call order, which keeps the sort stable
+    
+    GPU_Image* image;
+    GPU_Target* target;
+    float dx1, dy1, dx2, dy2;
+    float x, y, radians;
+    float s1, t1, s2, t2;
+    float r, g, b, a;
+} GPU_SortedBlit;
+
+static void addSortedBlit(GPU_CONTEXT_DATA* cdata, GPU_Image* image, GPU_Target* target, float dx1, float dy1, float dx2, float dy2, float x, float y, float radians, float s1, float t1, float s2, float t2, float r, float g, float b, float a)
+{
+    GPU_SortedBlit* blit;
+    
+    if(cdata->sorted_blit_buffer_num_blits >= cdata->sorted_blit_buffer_max_num_blits)
+    {
+        unsigned int new_max_num_blits = (cdata->sorted_blit_buffer_max_num_blits == 0? GPU_SORTED_BLIT_BUFFER_INIT_MAX_NUM_BLITS : cdata->sorted_blit_buffer_max_num_blits*2);
+        GPU_SortedBlit* new_buffer = (GPU_SortedBlit*)SDL_malloc(new_max_num_blits*sizeof(GPU_SortedBlit));
+        memcpy(new_buffer, cdata->sorted_blit_buffer, cdata->sorted_blit_buffer_num_blits*sizeof(GPU_SortedBlit));
+        SDL_free(cdata->sorted_blit_buffer);
+        cdata->sorted_blit_buffer = new_buffer;
+        cdata->sorted_blit_buffer_max_num_blits = new_max_num_blits;
+    }
+    
+    if(target != cdata->sorted_blit_last_target)
+    {
+        cdata->sorted_blit_segment++;
+        cdata->sorted_blit_last_target = target;
+        trackSortedBlitItem(cdata->sorted_blit_targets, &cdata->sorted_blit_num_targets, GPU_SORTED_BLIT_TRACKED_TARGETS, target->data);
+    }
+    trackSortedBlitItem(cdata->sorted_blit_images, &cdata->sorted_blit_num_images, GPU_SORTED_BLIT_TRACKED_IMAGES, image->data);
+    
+    blit = &cdata->sorted_blit_buffer[cdata->sorted_blit_buffer_num_blits];
+    blit->segment = cdata->sorted_blit_segment;
+    blit->layer = cdata->batch_layer;
+    blit->use_blending = image->use_blending;
+    blit->blend_mode = image->blend_mode;
+    blit->texture = ((GPU_IMAGE_DATA*)image->data)->handle;
+    blit->order = cdata->sorted_blit_buffer_num_blits;
+    
+    blit->image = image;
+    blit->target = target;
+    blit->dx1 = dx1;
+    blit->dy1 = dy1;
+    blit->dx2 = dx2;
+    blit->dy2 = dy2;
+    blit->x = x;
+    blit->y = y;
+    blit->radians = radians;
+    blit->s1 = s1;
+    blit->t1 = t1;
+    blit->s2 = s2;
+    blit->t2 = t2;
+    blit->r = r;
+    blit->g = g;
+    blit->b = b;
+    blit->a = a;
+    
+    cdata->sorted_blit_buffer_num_blits++;
+}
+
+static int compareSortedBlits(const void* a, const void* b)
+{
+    const GPU_SortedBlit* A = (const GPU_SortedBlit*)a;
+    const GPU_SortedBlit* B = (const GPU_SortedBlit*)b;
+    int result;
+    
+    if(A->segment != B->segment)
+        return (A->segment < B->segment? -1 : 1);
+    if(A->layer != B->layer)
+        return (A->layer < B->layer? -1 : 1);
+    if(A->use_blending != B->use_blending)
+        return (A->use_blending < B->use_blending? -1 : 1);
+    result = memcmp(&A->blend_mode, &B->blend_mode, sizeof(GPU_BlendMode));
+    if(result != 0)
+        return result;
+    if(A->texture != B->texture)
+        return (A->texture < B->texture? -1 : 1);
+    if(A->order != B->order)
+        return (A->order < B->order? -1 : 1);
+    return 0;
+}
+
+// Sorts the recorded blits and adds them to the normal batch.  The caller flushes whatever is left in it.
+static void submitSortedBlits(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    unsigned int i;
+    GPU_SortedBlit* blit;
+    
+    if(cdata->sorted_blit_buffer_num_blits == 0 || cdata->submitting_sorted_blits)
+        return;
+    
+    cdata->submitting_sorted_blits = 1;
+    
+    qsort(cdata->sorted_blit_buffer, cdata->sorted_blit_buffer_num_blits, sizeof(GPU_SortedBlit), &compareSortedBlits);
+    
+    for(i = 0; i < cdata->sorted_blit_buffer_num_blits; i++)
+    {
+        blit = &cdata->sorted_blit_buffer[i];
+        
+        // Only actual state changes flush here
+        prepareToRenderToTarget(renderer, blit->target);
+        prepareToRenderSprites(renderer, blit->use_blending, blit->blend_mode);
+        bindTextureSlot(renderer, blit->image);
+        if(!bindFramebuffer(renderer, blit->target))
+        {
+            GPU_PushErrorCode("GPU_FlushBlitBuffer", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+            continue;
+        }
+        
+        addSprite(renderer, cdata, blit->dx1, blit->dy1, blit->dx2, blit->dy2, blit->x, blit->y, blit->radians, blit->s1, blit->t1, blit->s2, blit->t2, blit->r, blit->g, blit->b, blit->a);
+    }
+    
+    cdata->sorted_blit_buffer_num_blits = 0;
+    cdata->sorted_blit_segment = 0;
+    cdata->sorted_blit_last_target = NULL;
+    cdata->sorted_blit_num_images = 0;
+    cdata->sorted_blit_num_targets = 0;
+    cdata->submitting_sorted_blits = 0;
+}
+
+
 static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y)
 {
 	Uint32 tex_w, tex_h;
@@ -3539,12 +6706,6 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
 	float x1, y1, x2, y2;
 	float dx1, dy1, dx2, dy2;
 	GPU_CONTEXT_DATA* cdata;
-	float* blit_buffer;
-	unsigned short* index_buffer;
-	unsigned short blit_buffer_starting_index;
-	int vert_index;
-	int tex_index;
-	int color_index;
 	float r, g, b, a;
 
     if(image == NULL)
@@ -3570,19 +6731,6 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         return;
     }
     
-    prepareToRenderToTarget(renderer, target);
-    prepareToRenderImage(renderer, target, image);
-
-    // Bind the texture to which subsequent calls refer
-    bindTexture(renderer, image);
-
-    // Bind the FBO
-    if(!bindFramebuffer(renderer, target))
-    {
-        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
-        return;
-    }
-    
     tex_w = image->texture_w;
     tex_h = image->texture_h;
     
@@ -3623,6 +6771,12 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         y2 *= image->base_h/(float)image->h;
     }
     
+    // Shift into the image's region of a shared texture
+    x1 += image->texture_x/(float)tex_w;
+    y1 += image->texture_y/(float)tex_h;
+    x2 += image->texture_x/(float)tex_w;
+    y2 += image->texture_y/(float)tex_h;
+    
     // Center the image on the given coords
     dx1 = x - w/2.0f;
     dy1 = y - h/2.0f;
@@ -3646,28 +6800,12 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         dy1 = dy2;
         dy2 = temp;
     }
+    
+    if(isCulled(renderer, target, dx1, dy1, dx2, dy2))
+        return;
 
     cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
 
-    if(cdata->blit_buffer_num_vertices + 4 >= cdata->blit_buffer_max_num_vertices)
-    {
-        if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + 4))
-            renderer->impl->FlushBlitBuffer(renderer);
-    }
-    if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
-    {
-        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + 6))
-            renderer->impl->FlushBlitBuffer(renderer);
-    }
-    
-    blit_buffer = cdata->blit_buffer;
-    index_buffer = cdata->index_buffer;
-
-    blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
-    
-    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-    tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-    color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
     if(target->use_color)
     {
         r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, image->color.r);
@@ -3683,22 +6821,29 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         a = GET_ALPHA(image->color)/255.0f;
     }
     
-    // 4 Quad vertices
-    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, x1, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy1, x2, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, x2, y2, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy2, x1, y2, r, g, b, a);
-
-    // 6 Triangle indices
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(1);
-    SET_INDEXED_VERTEX(2);
+    if(cdata->batch_mode == GPU_BATCH_MODE_SORTED)
+    {
+        // The texture handle is the sort key, so an evicted image needs its texture now
+        if(isImageEvicted(image))
+            restoreEvictedImage(renderer, image);
+        addSortedBlit(cdata, image, target, dx1, dy1, dx2, dy2, 0.0f, 0.0f, 0.0f, x1, y1, x2, y2, r, g, b, a);
+        return;
+    }
+    
+    prepareToRenderToTarget(renderer, target);
+    prepareToRenderImage(renderer, target, image);
 
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(2);
-    SET_INDEXED_VERTEX(3);
+    // Bind the texture to which subsequent calls refer
+    bindTextureSlot(renderer, image);
 
-    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    // Bind the FBO
+    if(!bindFramebuffer(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+    
+    addSprite(renderer, cdata, dx1, dy1, dx2, dy2, 0.0f, 0.0f, 0.0f, x1, y1, x2, y2, r, g, b, a);
 }
 
 
@@ -3763,15 +6908,9 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
 {
 	Uint32 tex_w, tex_h;
 	float x1, y1, x2, y2;
-	float dx1, dy1, dx2, dy2, dx3, dy3, dx4, dy4;
+	float dx1, dy1, dx2, dy2;
 	float w, h;
 	GPU_CONTEXT_DATA* cdata;
-	float* blit_buffer;
-	unsigned short* index_buffer;
-	unsigned short blit_buffer_starting_index;
-	int vert_index;
-	int tex_index;
-	int color_index;
 	float r, g, b, a;
 
     if(image == NULL)
@@ -3793,19 +6932,6 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
 
     makeContextCurrent(renderer, target);
     
-    prepareToRenderToTarget(renderer, target);
-    prepareToRenderImage(renderer, target, image);
-    
-    // Bind the texture to which subsequent calls refer
-    bindTexture(renderer, image);
-
-    // Bind the FBO
-    if(!bindFramebuffer(renderer, target))
-    {
-        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
-        return;
-    }
-    
     tex_w = image->texture_w;
     tex_h = image->texture_h;
     
@@ -3852,6 +6978,12 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
         y2 *= image->base_h/(float)image->h;
     }
     
+    // Shift into the image's region of a shared texture
+    x1 += image->texture_x/(float)tex_w;
+    y1 += image->texture_y/(float)tex_h;
+    x2 += image->texture_x/(float)tex_w;
+    y2 += image->texture_y/(float)tex_h;
+    
     // Center the image on the given coords (offset later)
     dx1 = -w/2.0f;
     dy1 = -h/2.0f;
@@ -3899,64 +7031,22 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
     dy1 -= pivot_y*scaleY;
     dx2 -= pivot_x*scaleX;
     dy2 -= pivot_y*scaleY;
-
-    // Get extra vertices for rotation
-    dx3 = dx2;
-    dy3 = dy1;
-    dx4 = dx1;
-    dy4 = dy2;
-
-    // Rotate about origin (the pivot)
-    if(degrees != 0.0f)
-    {
-        float cosA = cos(degrees*M_PI/180);
-        float sinA = sin(degrees*M_PI/180);
-        float tempX = dx1;
-        dx1 = dx1*cosA - dy1*sinA;
-        dy1 = tempX*sinA + dy1*cosA;
-        tempX = dx2;
-        dx2 = dx2*cosA - dy2*sinA;
-        dy2 = tempX*sinA + dy2*cosA;
-        tempX = dx3;
-        dx3 = dx3*cosA - dy3*sinA;
-        dy3 = tempX*sinA + dy3*cosA;
-        tempX = dx4;
-        dx4 = dx4*cosA - dy4*sinA;
-        dy4 = tempX*sinA + dy4*cosA;
-    }
-
-    // Translate to pos
-    dx1 += x;
-    dx2 += x;
-    dx3 += x;
-    dx4 += x;
-    dy1 += y;
-    dy2 += y;
-    dy3 += y;
-    dy4 += y;
-
-    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
-
-    if(cdata->blit_buffer_num_vertices + 4 >= cdata->blit_buffer_max_num_vertices)
+    
+    if(degrees == 0.0f)
     {
-        if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + 4))
-            renderer->impl->FlushBlitBuffer(renderer);
+        if(isCulled(renderer, target, x + dx1, y + dy1, x + dx2, y + dy2))
+            return;
     }
-    if(cdata->index_buffer_num_vertices + 6 >= cdata->index_buffer_max_num_vertices)
+    else
     {
-        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + 6))
-            renderer->impl->FlushBlitBuffer(renderer);
+        // Any rotation stays within this distance of the pivot
+        float extent = (fabsf(dx1) > fabsf(dx2)? fabsf(dx1) : fabsf(dx2)) + (fabsf(dy1) > fabsf(dy2)? fabsf(dy1) : fabsf(dy2));
+        if(isCulled(renderer, target, x - extent, y - extent, x + extent, y + extent))
+            return;
     }
-    
-    blit_buffer = cdata->blit_buffer;
-    index_buffer = cdata->index_buffer;
 
-    blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
-    
-    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-    tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-    color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-    
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+
     if(target->use_color)
     {
         r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, image->color.r);
@@ -3971,23 +7061,363 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
         b = image->color.b/255.0f;
         a = GET_ALPHA(image->color)/255.0f;
     }
-    
-    // 4 Quad vertices
-    SET_TEXTURED_VERTEX_UNINDEXED(dx1, dy1, x1, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx3, dy3, x2, y1, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx2, dy2, x2, y2, r, g, b, a);
-    SET_TEXTURED_VERTEX_UNINDEXED(dx4, dy4, x1, y2, r, g, b, a);
-
-    // 6 Triangle indices
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(1);
-    SET_INDEXED_VERTEX(2);
-
-    SET_INDEXED_VERTEX(0);
-    SET_INDEXED_VERTEX(2);
-    SET_INDEXED_VERTEX(3);
-
-    cdata->blit_buffer_num_vertices += GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+    
+    if(cdata->batch_mode == GPU_BATCH_MODE_SORTED)
+    {
+        // The texture handle is the sort key, so an evicted image needs its texture now
+        if(isImageEvicted(image))
+            restoreEvictedImage(renderer, image);
+        addSortedBlit(cdata, image, target, dx1, dy1, dx2, dy2, x, y, degrees*M_PI/180, x1, y1, x2, y2, r, g, b, a);
+        return;
+    }
+    
+    prepareToRenderToTarget(renderer, target);
+    prepareToRenderImage(renderer, target, image);
+    
+    // Bind the texture to which subsequent calls refer
+    bindTextureSlot(renderer, image);
+
+    // Bind the FBO
+    if(!bindFramebuffer(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+    
+    addSprite(renderer, cdata, dx1, dy1, dx2, dy2, x, y, degrees*M_PI/180, x1, y1, x2, y2, r, g, b, a);
+}
+
+
+static void BlitBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned int num_sprites, float* positions, float* src_rects, float* rotations, float* scales, float* colors, unsigned int floats_per_sprite, GPU_BlitFlagEnum flags)
+{
+	Uint8 pass_vertices, pass_texcoords, pass_colors;
+	Uint8 snap_position, snap_dimensions;
+	unsigned int position_stride, src_rect_stride, rotation_stride, scale_stride, color_stride;
+	float tex_w, tex_h;
+	float s_scale, t_scale;
+	float s_offset, t_offset;
+	float image_r, image_g, image_b, image_a;
+	GPU_CONTEXT_DATA* cdata;
+	float* blit_buffer;
+	int vert_index;
+	int tex_index;
+	int color_index;
+	unsigned int n, num_batch_sprites;
+	Uint8 make_vertices;
+	int i;
+
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitBatch", GPU_ERROR_NULL_ARGUMENT, "image");
+        return;
+    }
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitBatch", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if(renderer != image->renderer || renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_BlitBatch", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_BlitBatch", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+    
+    prepareToRenderToTarget(renderer, target);
+    prepareToRenderImage(renderer, target, image);
+
+    // Bind the texture to which subsequent calls refer
+    bindTextureSlot(renderer, image);
+
+    // Bind the FBO
+    if(!bindFramebuffer(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_BlitBatch", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+    
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    
+    #ifdef SDL_GPU_USE_INSTANCING
+    // Batches are expanded into the blit buffer
+    if(cdata->instance_buffer_num_instances > 0)
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
+    #endif
+    
+    pass_vertices = ((flags & GPU_PASSTHROUGH_VERTICES) != 0);
+    pass_texcoords = ((flags & GPU_PASSTHROUGH_TEXCOORDS) != 0);
+    pass_colors = ((flags & GPU_PASSTHROUGH_COLORS) != 0);
+    snap_position = (image->snap_mode == GPU_SNAP_POSITION || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS);
+    snap_dimensions = (image->snap_mode == GPU_SNAP_DIMENSIONS || image->snap_mode == GPU_SNAP_POSITION_AND_DIMENSIONS);
+    
+    // Interleaved data shares one stride, separate arrays are tightly packed
+    position_stride = (floats_per_sprite > 0? floats_per_sprite : (pass_vertices? 8 : 2));
+    src_rect_stride = (floats_per_sprite > 0? floats_per_sprite : (pass_texcoords? 8 : 4));
+    rotation_stride = (floats_per_sprite > 0? floats_per_sprite : 1);
+    scale_stride = (floats_per_sprite > 0? floats_per_sprite : 2);
+    color_stride = (floats_per_sprite > 0? floats_per_sprite : (pass_colors? 16 : 4));
+    
+    // Scale src_rect tex coords according to actual texture dims
+    tex_w = image->texture_w;
+    tex_h = image->texture_h;
+    s_scale = 1.0f/tex_w;
+    t_scale = 1.0f/tex_h;
+    if(image->using_virtual_resolution)
+    {
+        // Scale texture coords to fit the original dims
+        s_scale *= image->base_w/(float)image->w;
+        t_scale *= image->base_h/(float)image->h;
+    }
+    // Shift into the image's region of a shared texture
+    s_offset = image->texture_x/(float)tex_w;
+    t_offset = image->texture_y/(float)tex_h;
+    
+    if(target->use_color)
+    {
+        image_r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, image->color.r);
+        image_g = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.g, image->color.g);
+        image_b = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.b, image->color.b);
+        image_a = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(GET_ALPHA(target->color), GET_ALPHA(image->color));
+    }
+    else
+    {
+        image_r = image->color.r/255.0f;
+        image_g = image->color.g/255.0f;
+        image_b = image->color.b/255.0f;
+        image_a = GET_ALPHA(image->color)/255.0f;
+    }
+    
+    // Upright quads with one color and all-float vertices can use the vectorized kernel
+    make_vertices = (!cdata->packed_tex_coords && !cdata->packed_colors
+                     && !(pass_texcoords && src_rects != NULL) && !(pass_colors && colors != NULL));
+    
+    while(num_sprites > 0)
+    {
+        if(cdata->blit_buffer_num_vertices + num_sprites*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE >= cdata->blit_buffer_max_num_vertices)
+            growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + num_sprites*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE);
+        
+        // Take as many sprites as the blit buffer can hold
+        num_batch_sprites = (cdata->blit_buffer_max_num_vertices - cdata->blit_buffer_num_vertices)/GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+        if(num_batch_sprites == 0)
+        {
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+            continue;
+        }
+        if(num_batch_sprites > num_sprites)
+            num_batch_sprites = num_sprites;
+        if(cdata->blit_buffer_uses_index_buffer && !growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_batch_sprites*6))
+        {
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+            continue;
+        }
+        
+        blit_buffer = cdata->blit_buffer;
+        
+        vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex;
+        tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex;
+        color_index = cdata->blit_buffer_color_offset + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex;
+        
+        for(n = 0; n < num_batch_sprites; n++)
+        {
+            // Quad corners in the same order as GPU_Blit()
+            float vx[4], vy[4], vs[4], vt[4];
+            float vc[16];
+            float w2, h2;
+            Uint8 one_color;
+            
+            // Tex coords
+            if(src_rects == NULL)
+            {
+                vs[0] = vs[3] = 0.0f;
+                vt[0] = vt[1] = 0.0f;
+                vs[1] = vs[2] = image->w*s_scale;
+                vt[2] = vt[3] = image->h*t_scale;
+                w2 = image->w/2.0f;
+                h2 = image->h/2.0f;
+            }
+            else if(pass_texcoords)
+            {
+                for(i = 0; i < 4; i++)
+                {
+                    vs[i] = src_rects[2*i];
+                    vt[i] = src_rects[2*i+1];
+                }
+                w2 = 0.5f*(vs[2] - vs[0])*tex_w;
+                h2 = 0.5f*(vt[2] - vt[0])*tex_h;
+                src_rects += src_rect_stride;
+            }
+            else
+            {
+                vs[0] = vs[3] = src_rects[0]*s_scale;
+                vt[0] = vt[1] = src_rects[1]*t_scale;
+                vs[1] = vs[2] = (src_rects[0] + src_rects[2])*s_scale;
+                vt[2] = vt[3] = (src_rects[1] + src_rects[3])*t_scale;
+                w2 = src_rects[2]/2.0f;
+                h2 = src_rects[3]/2.0f;
+                src_rects += src_rect_stride;
+            }
+            for(i = 0; i < 4; i++)
+            {
+                vs[i] += s_offset;
+                vt[i] += t_offset;
+            }
+            
+            // Colors
+            one_color = (colors == NULL || !pass_colors);
+            if(colors == NULL)
+            {
+                vc[0] = image_r;
+                vc[1] = image_g;
+                vc[2] = image_b;
+                vc[3] = image_a;
+            }
+            else if(pass_colors)
+            {
+                for(i = 0; i < 16; i++)
+                    vc[i] = colors[i];
+                colors += color_stride;
+            }
+            else
+            {
+                vc[0] = colors[0]/255.0f;
+                vc[1] = colors[1]/255.0f;
+                vc[2] = colors[2]/255.0f;
+                vc[3] = colors[3]/255.0f;
+                colors += color_stride;
+            }
+            
+            // Positions
+            if(pass_vertices && positions != NULL)
+            {
+                for(i = 0; i < 4; i++)
+                {
+                    vx[i] = positions[2*i];
+                    vy[i] = positions[2*i+1];
+                }
+                positions += position_stride;
+                
+                // Passthrough vertices are already transformed
+                if(rotations != NULL)
+                    rotations += rotation_stride;
+                if(scales != NULL)
+                    scales += scale_stride;
+            }
+            else
+            {
+                float x = 0.0f, y = 0.0f;
+                float fx = 0.0f, fy = 0.0f;
+                float dx1, dy1, dx2, dy2;
+                float sinA = 0.0f, cosA = 1.0f;
+                Uint8 rotated = 0;
+                
+                if(positions != NULL)
+                {
+                    x = positions[0];
+                    y = positions[1];
+                    positions += position_stride;
+                }
+                
+                if(snap_position)
+                {
+                    x = floorf(x);
+                    y = floorf(y);
+                }
+                if(snap_dimensions)
+                {
+                    fx = w2 - floorf(w2);
+                    fy = h2 - floorf(h2);
+                }
+                
+                if(scales != NULL)
+                {
+                    w2 *= scales[0];
+                    h2 *= scales[1];
+                    scales += scale_stride;
+                }
+                
+                // Center the image on the given coords
+                dx1 = fx - w2;
+                dy1 = fy - h2;
+                dx2 = fx + w2;
+                dy2 = fy + h2;
+                
+                if(renderer->coordinate_mode == 1)
+                {
+                    float temp = dy1;
+                    dy1 = dy2;
+                    dy2 = temp;
+                }
+                
+                if(rotations != NULL)
+                {
+                    if(rotations[0] != 0.0f)
+                    {
+                        GPU_SinCos(rotations[0]*(float)(M_PI/180), &sinA, &cosA);
+                        rotated = 1;
+                    }
+                    rotations += rotation_stride;
+                }
+                
+                if(make_vertices)
+                {
+                    // All-float vertices come from the vectorized kernel, like in addSprite()
+                    GPU_MakeSpriteVertices(blit_buffer + vert_index, cdata->blit_buffer_floats_per_vertex, dx1, dy1, dx2, dy2, x, y, sinA, cosA, vs[0], vt[0], vs[2], vt[2], vc[0], vc[1], vc[2], vc[3]);
+                    for(i = 0; i < 4; i++)
+                    {
+                        setBlitBufferTextureSlot(cdata, blit_buffer, vert_index);
+                        vert_index += cdata->blit_buffer_floats_per_vertex;
+                        tex_index += cdata->blit_buffer_floats_per_vertex;
+                        color_index += cdata->blit_buffer_floats_per_vertex;
+                    }
+                    continue;
+                }
+                
+                vx[0] = vx[3] = dx1;
+                vx[1] = vx[2] = dx2;
+                vy[0] = vy[1] = dy1;
+                vy[2] = vy[3] = dy2;
+                
+                if(rotated)
+                {
+                    for(i = 0; i < 4; i++)
+                    {
+                        float tempX = vx[i];
+                        vx[i] = vx[i]*cosA - vy[i]*sinA;
+                        vy[i] = tempX*sinA + vy[i]*cosA;
+                    }
+                }
+                
+                for(i = 0; i < 4; i++)
+                {
+                    vx[i] += x;
+                    vy[i] += y;
+                }
+            }
+            
+            if(one_color)
+            {
+                for(i = 4; i < 16; i++)
+                    vc[i] = vc[i-4];
+            }
+            
+            for(i = 0; i < 4; i++)
+            {
+                SET_TEXTURED_VERTEX_UNINDEXED(vx[i], vy[i], vs[i], vt[i], vc[4*i], vc[4*i+1], vc[4*i+2], vc[4*i+3]);
+            }
+        }
+        
+        // The triangle indices come from the pre-built quad index buffer, unless triangles share the batch
+        if(cdata->blit_buffer_uses_index_buffer)
+            pushQuadIndices(cdata, cdata->blit_buffer_num_vertices, num_batch_sprites);
+        cdata->blit_buffer_num_vertices += num_batch_sprites*GPU_BLIT_BUFFER_VERTICES_PER_SPRITE;
+        num_sprites -= num_batch_sprites;
+    }
 }
 
 
@@ -4041,6 +7471,29 @@ static void refresh_attribute_data(GPU_CONTEXT_DATA* cdata)
 static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
 {
     int i;
+    #if !defined(SDL_GPU_NO_VAO)
+    // A cached vertex array keeps the pointers it was given last time
+    GPU_VERTEX_FORMAT_DATA* format = getBoundVertexFormat(cdata);
+    #endif
+    #ifdef SDL_GPU_USE_BUFFER_RING
+    unsigned int ring_bytes = 0;
+    
+    // All of the attributes go into the same region of the attribute ring, which grows when they don't fit
+    for(i = 0; i < 16; i++)
+    {
+        GPU_AttributeSource* a = &cdata->shader_attributes[i];
+        if(a->attribute.values != NULL && a->attribute.location >= 0 && a->num_values > 0)
+            ring_bytes += (a->per_vertex_storage_stride_bytes * (a->num_values < num_vertices? a->num_values : num_vertices) + 3)/4*4;
+    }
+    if(ring_bytes > 0)
+    {
+        if(ring_bytes > cdata->attribute_ring.region_size)
+            createRing(cdata, &cdata->attribute_ring, GL_ARRAY_BUFFER, (ring_bytes > 2*cdata->attribute_ring.region_size? ring_bytes : 2*cdata->attribute_ring.region_size));
+        if(cdata->attribute_ring.VBO != 0)
+            reserveRing(&cdata->attribute_ring, ring_bytes, 4);
+    }
+    #endif
+    
     for(i = 0; i < 16; i++)
     {
         GPU_AttributeSource* a = &cdata->shader_attributes[i];
@@ -4048,17 +7501,34 @@ static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
         {
             int num_values_used = num_vertices;
 			int bytes_used;
+            GLuint buffer;
+            unsigned int offset_bytes = 0;
 
             if(a->num_values < num_values_used)
                 num_values_used = a->num_values;
             
-            glBindBuffer(GL_ARRAY_BUFFER, cdata->attribute_VBO[i]);
-            
             bytes_used = a->per_vertex_storage_stride_bytes * num_values_used;
-            glBufferData(GL_ARRAY_BUFFER, bytes_used, a->next_value, GL_STREAM_DRAW);
+            #ifdef SDL_GPU_USE_BUFFER_RING
+            if(cdata->attribute_ring.VBO != 0)
+            {
+                buffer = cdata->attribute_ring.VBO;
+                offset_bytes = writeRing(cdata, &cdata->attribute_ring, bytes_used, 4, a->next_value);
+            }
+            else
+            #endif
+            {
+                buffer = cdata->attribute_VBO[i];
+                bindBuffer(cdata, GL_ARRAY_BUFFER, buffer);
+                glBufferData(GL_ARRAY_BUFFER, bytes_used, a->next_value, GL_STREAM_DRAW);
+            }
+            offset_bytes += a->per_vertex_storage_offset_bytes;
+            GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, bytes_used);
             
-            glEnableVertexAttribArray(a->attribute.location);
-            glVertexAttribPointer(a->attribute.location, a->attribute.format.num_elems_per_value, a->attribute.format.type, a->attribute.format.normalize, a->per_vertex_storage_stride_bytes, (void*)(long)a->per_vertex_storage_offset_bytes);
+            enableVertexAttribArray(cdata, a->attribute.location);
+            #if !defined(SDL_GPU_NO_VAO)
+            if(format == NULL || updateAttributePointer(format, i, a, buffer, offset_bytes))
+            #endif
+                glVertexAttribPointer(a->attribute.location, a->attribute.format.num_elems_per_value, a->attribute.format.type, a->attribute.format.normalize, a->per_vertex_storage_stride_bytes, (void*)(size_t)offset_bytes);
             
             a->enabled = 1;
             // Move the data along so we use the next values for the next flush
@@ -4071,34 +7541,28 @@ static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
     }
 }
 
+// The arrays themselves stay enabled until a draw call that doesn't use them (see disableUnusedVertexAttribArrays())
 static void disable_attribute_data(GPU_CONTEXT_DATA* cdata)
 {
     int i;
     for(i = 0; i < 16; i++)
-    {
-        GPU_AttributeSource* a = &cdata->shader_attributes[i];
-        if(a->enabled)
-        {
-            glDisableVertexAttribArray(a->attribute.location);
-            a->enabled = 0;
-        }
-    }
+        cdata->shader_attributes[i].enabled = 0;
 }
 
 #endif
 
-static int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, int cap)
+static unsigned int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, unsigned int cap)
 {
-    int lowest = cap;
+    unsigned int lowest = cap;
     
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
     int i;
     for(i = 0; i < 16; i++)
     {
         GPU_AttributeSource* a = &cdata->shader_attributes[i];
-        if(a->attribute.values != NULL && a->attribute.location >= 0)
+        if(a->attribute.values != NULL && a->attribute.location >= 0 && a->num_values >= 0)
         {
-            if(a->num_values < lowest)
+            if((unsigned int)a->num_values < lowest)
                 lowest = a->num_values;
         }
     }
@@ -4107,99 +7571,311 @@ static int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, int cap)
     return lowest;
 }
 
-static_inline void submit_buffer_data(int bytes, float* values, int bytes_indices, unsigned short* indices)
+static_inline void submit_buffer_data(int bytes, float* values, int bytes_indices, void* indices)
 {
     #ifdef SDL_GPU_USE_BUFFER_PIPELINE
         #ifdef SDL_GPU_USE_BUFFER_MAPPING
         float* data = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        unsigned short* data_i = (unsigned short*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+        void* data_i = (indices == NULL? NULL : glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
         if(data != NULL)
         {
             memcpy(data, values, bytes);
             glUnmapBuffer(GL_ARRAY_BUFFER);
         }
-        if(data_i != NULL)
+        if(data_i != NULL && indices != NULL)
         {
             memcpy(data_i, indices, bytes_indices);
             glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
         }
         #elif defined(SDL_GPU_USE_BUFFER_RESET)
         glBufferData(GL_ARRAY_BUFFER, bytes, values, GL_STREAM_DRAW);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes_indices, indices, GL_DYNAMIC_DRAW);
+        if(indices != NULL)
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes_indices, indices, GL_DYNAMIC_DRAW);
         #else
         glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, values);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes_indices, indices);
+        if(indices != NULL)
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes_indices, indices);
         #endif
     #endif
 }
 
-// Assumes the right format
-static void TriangleBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned short num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+// Uploads the blit buffer and its indices, leaving the vertex and index buffers bound.  Pass NULL indices to leave the index buffer binding to the caller.  Returns the byte offset of the vertices in the bound vertex buffer.
+static_inline unsigned int submit_blit_buffer(GPU_CONTEXT_DATA* cdata, int bytes, float* values, int bytes_indices, void* indices)
 {
-	GPU_CONTEXT_DATA* cdata;
-	int stride, offset_texcoords, offset_colors;
-	int size_vertices, size_texcoords, size_colors;
-	
-	Uint8 using_texture = (image != NULL);
-	Uint8 use_vertices = (flags & (GPU_BATCH_XY | GPU_BATCH_XYZ));
-	Uint8 use_texcoords = (flags & GPU_BATCH_ST);
-	Uint8 use_colors = (flags & (GPU_BATCH_RGB | GPU_BATCH_RGBA));
-	Uint8 use_z = (flags & GPU_BATCH_XYZ);
-	Uint8 use_a = (flags & GPU_BATCH_RGBA);
+    GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, bytes + (indices != NULL? bytes_indices : 0));
     
-    if(num_vertices == 0)
-        return;
+    #ifdef SDL_GPU_USE_BUFFER_RING
+    if(cdata->blit_ring.VBO != 0)
+    {
+        // Start on a whole vertex, so the draw can use a base vertex instead of new attribute pointers
+        unsigned int offset = writeRing(cdata, &cdata->blit_ring, bytes, GPU_BLIT_BUFFER_STRIDE(cdata), values);
+        if(indices != NULL)
+        {
+            bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes_indices, indices);
+        }
+        return offset;
+    }
+    #endif
     
-    if(target == NULL)
+    bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
+    cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
+    if(indices != NULL)
+        bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+    
+    submit_buffer_data(bytes, values, bytes_indices, indices);
+    return 0;
+}
+#endif
+
+// Finds the stride (in bytes), element counts, and offsets (in floats) of vertex data in the given GPU_BatchFlagEnum layout
+static void getBatchLayout(GPU_BatchFlagEnum flags, int* stride, int* size_vertices, int* size_texcoords, int* size_colors, int* offset_texcoords, int* offset_colors)
+{
+    *stride = 0;
+    *offset_texcoords = *offset_colors = 0;
+    *size_vertices = *size_texcoords = *size_colors = 0;
+    
+    if(flags & (GPU_BATCH_XY | GPU_BATCH_XYZ))
     {
-        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_NULL_ARGUMENT, "target");
-        return;
+        if(flags & GPU_BATCH_XYZ)
+            *size_vertices = 3;
+        else
+            *size_vertices = 2;
+        
+        *stride += *size_vertices;
+        
+        *offset_texcoords = *stride;
+        *offset_colors = *stride;
     }
-    if((image != NULL && renderer != image->renderer) || renderer != target->renderer)
+    
+    if(flags & GPU_BATCH_ST)
     {
-        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_USER_ERROR, "Mismatched renderer");
-        return;
+        *size_texcoords = 2;
+        
+        *stride += *size_texcoords;
+        
+        *offset_colors = *stride;
+    }
+    
+    if(flags & (GPU_BATCH_RGB | GPU_BATCH_RGBA))
+    {
+        if(flags & GPU_BATCH_RGBA)
+            *size_colors = 4;
+        else
+            *size_colors = 3;
+        
+        *stride += *size_colors;
     }
     
+    // Convert to a number of bytes
+    *stride *= sizeof(float);
+}
+
+// Sets up the state for drawing triangles from caller data.  Returns false if the target can't be bound.
+static Uint8 prepareToRenderTriangles(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target)
+{
     makeContextCurrent(renderer, target);
 
     // Bind the texture to which subsequent calls refer
-    if(using_texture)
+    if(image != NULL)
         bindTexture(renderer, image);
 
     // Bind the FBO
     if(!bindFramebuffer(renderer, target))
-    {
-        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
-        return;
-    }
+        return 0;
     
     prepareToRenderToTarget(renderer, target);
-    if(using_texture)
+    if(image != NULL)
         prepareToRenderImage(renderer, target, image);
     else
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
         prepareToRenderShapes(renderer, GL_TRIANGLES);
+        
+        // These vertices have no texture slot, so the white texel has to be in the first one
+        if(cdata->shapes_use_white_texel)
+            bindTexture(renderer, cdata->white_texel);
+    }
     changeViewport(target);
     changeCamera(target);
     
-    if(using_texture)
+    if(image != NULL)
         changeTexturing(renderer, 1);
 
     setClipRect(renderer, target);
     
-    #ifdef SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
-    if(!IsFeatureEnabled(renderer, GPU_FEATURE_VERTEX_SHADER))
-        applyTransforms();
-    #endif
+    #ifdef SDL_GPU_APPLY_TRANSFORMS_TO_GL_STACK
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_VERTEX_SHADER))
+        applyTransforms();
+    #endif
+    
+    return 1;
+}
+
+// Triangles can join the current batch when the blit buffer's 2D vertex format holds everything they need
+static Uint8 canBatchTriangles(GPU_CONTEXT_DATA* cdata, unsigned short num_vertices, float* values, GPU_BatchFlagEnum flags)
+{
+    if(values == NULL || num_vertices > cdata->blit_buffer_vertex_limit)
+        return 0;
+    
+    // Native data is already in the right format, and custom attributes are used for the whole batch like with sprites
+    if(flags & GPU_BATCH_NATIVE)
+        return 1;
+    
+    if(!(flags & GPU_BATCH_XY) || (flags & GPU_BATCH_XYZ))
+        return 0;
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    {
+        // Attribute arrays are consumed per draw call, so they would not line up with a merged batch
+        int i;
+        for(i = 0; i < 16; i++)
+        {
+            GPU_AttributeSource* a = &cdata->shader_attributes[i];
+            if(a->attribute.values != NULL && a->attribute.location >= 0 && a->num_values > 0)
+                return 0;
+        }
+    }
+    #endif
+    
+    return 1;
+}
+
+// Converts the triangles to the blit buffer's vertex format and appends them to the current batch, with their indices rebased onto it
+static void addTriangles(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, GPU_Image* image, GPU_Target* target, unsigned short num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+{
+	float* blit_buffer;
+	int vert_index;
+	int tex_index;
+	int color_index;
+	int stride, offset_texcoords, offset_colors;
+	int size_vertices, size_texcoords, size_colors;
+	unsigned int blit_buffer_starting_index;
+	unsigned int i;
+	float r, g, b, a;
+	
+    if(indices == NULL)
+        num_indices = num_vertices;
+    
+    if(cdata->blit_buffer_num_vertices + num_vertices >= cdata->blit_buffer_max_num_vertices)
+    {
+        if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + num_vertices))
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+    }
+    
+    if(image != NULL)
+        useIndexBufferForSprites(renderer, cdata, num_indices);
+    else if(cdata->index_buffer_num_vertices + num_indices >= cdata->index_buffer_max_num_vertices)
+    {
+        if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_indices))
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL);
+    }
+    
+    blit_buffer = cdata->blit_buffer;
+    blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
+    
+    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + blit_buffer_starting_index*cdata->blit_buffer_floats_per_vertex;
+    tex_index = GPU_BLIT_BUFFER_TEX_COORD_OFFSET + blit_buffer_starting_index*cdata->blit_buffer_floats_per_vertex;
+    color_index = cdata->blit_buffer_color_offset + blit_buffer_starting_index*cdata->blit_buffer_floats_per_vertex;
+    
+    if(flags & GPU_BATCH_NATIVE)
+    {
+        memcpy(blit_buffer + vert_index, values, num_vertices*GPU_BLIT_BUFFER_STRIDE(cdata));
+    }
+    else
+    {
+        // Vertices without colors take the color that a blit would use
+        if(image != NULL && target->use_color)
+        {
+            r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, image->color.r);
+            g = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.g, image->color.g);
+            b = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.b, image->color.b);
+            a = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(GET_ALPHA(target->color), GET_ALPHA(image->color));
+        }
+        else if(image != NULL)
+        {
+            r = image->color.r/255.0f;
+            g = image->color.g/255.0f;
+            b = image->color.b/255.0f;
+            a = GET_ALPHA(image->color)/255.0f;
+        }
+        else if(target->use_color)
+        {
+            r = target->color.r/255.0f;
+            g = target->color.g/255.0f;
+            b = target->color.b/255.0f;
+            a = GET_ALPHA(target->color)/255.0f;
+        }
+        else
+            r = g = b = a = 1.0f;
+        
+        getBatchLayout(flags, &stride, &size_vertices, &size_texcoords, &size_colors, &offset_texcoords, &offset_colors);
+        stride /= sizeof(float);
+        (void)size_vertices;
+        
+        for(i = 0; i < num_vertices; i++)
+        {
+            float* v = values + i*stride;
+            
+            if(size_colors > 0)
+            {
+                r = v[offset_colors];
+                g = v[offset_colors+1];
+                b = v[offset_colors+2];
+                a = (size_colors == 4? v[offset_colors+3] : 1.0f);
+            }
+            
+            if(image == NULL)
+            {
+                SET_UNTEXTURED_VERTEX_UNINDEXED(v[0], v[1], r, g, b, a);
+            }
+            else if(size_texcoords > 0)
+            {
+                SET_TEXTURED_VERTEX_UNINDEXED(v[0], v[1], v[offset_texcoords], v[offset_texcoords+1], r, g, b, a);
+            }
+            else
+            {
+                SET_TEXTURED_VERTEX_UNINDEXED(v[0], v[1], 0.0f, 0.0f, r, g, b, a);
+            }
+        }
+    }
+    
+    for(i = 0; i < num_indices; i++)
+    {
+        SET_INDEXED_VERTEX(indices == NULL? i : indices[i]);
+    }
+    
+    cdata->blit_buffer_num_vertices += num_vertices;
+}
+
+// Draws the triangles right away, for data that can't go through the blit buffer
+static void drawTriangleBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned short num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+{
+	GPU_CONTEXT_DATA* cdata;
+	int stride, offset_texcoords, offset_colors;
+	int size_vertices, size_texcoords, size_colors;
+	
+	Uint8 use_vertices = (flags & (GPU_BATCH_XY | GPU_BATCH_XYZ));
+	Uint8 use_texcoords = (flags & GPU_BATCH_ST);
+	Uint8 use_colors = (flags & (GPU_BATCH_RGB | GPU_BATCH_RGBA));
+	Uint8 use_z = (flags & GPU_BATCH_XYZ);
+	Uint8 use_a = (flags & GPU_BATCH_RGBA);
+    
+    if(!prepareToRenderTriangles(renderer, image, target))
+    {
+        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
     
 
     cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
 
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
 
     if(cdata->index_buffer_num_vertices + num_indices >= cdata->index_buffer_max_num_vertices)
     {
-        growBlitBuffer(cdata, cdata->index_buffer_num_vertices + num_indices);
+        growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_indices);
     }
     if(cdata->blit_buffer_num_vertices + num_vertices >= cdata->blit_buffer_max_num_vertices)
     {
@@ -4237,46 +7913,10 @@ static void TriangleBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target*
     (void)size_vertices;
     (void)size_texcoords;
     (void)size_colors;
+    (void)use_z;
+    (void)use_a;
     
-    stride = 0;
-    offset_texcoords = offset_colors = 0;
-    size_vertices = size_texcoords = size_colors = 0;
-    
-    // Determine stride, size, and offsets
-    if(use_vertices)
-    {
-        if(use_z)
-            size_vertices = 3;
-        else
-            size_vertices = 2;
-        
-        stride += size_vertices;
-        
-        offset_texcoords = stride;
-        offset_colors = stride;
-    }
-    
-    if(use_texcoords)
-    {
-        size_texcoords = 2;
-        
-        stride += size_texcoords;
-        
-        offset_colors = stride;
-    }
-    
-    if(use_colors)
-    {
-        if(use_a)
-            size_colors = 4;
-        else
-            size_colors = 3;
-        
-        stride += size_colors;
-    }
-    
-    // Convert to a number of bytes
-    stride *= sizeof(float);
+    getBatchLayout(flags, &stride, &size_vertices, &size_texcoords, &size_colors, &offset_texcoords, &offset_colors);
     
         
 #ifdef SDL_GPU_USE_ARRAY_PIPELINE
@@ -4365,74 +8005,472 @@ static void TriangleBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target*
 
         // Update the vertex array object's buffers
         #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(cdata->blit_VAO);
+        bindVertexArray(cdata, cdata->blit_VAO);
         #endif
         
         // Upload our modelviewprojection matrix
-        if(cdata->current_shader_block.modelViewProjection_loc >= 0)
-        {
-            float mvp[16];
-            GPU_GetModelViewProjection(mvp);
-            glUniformMatrix4fv(cdata->current_shader_block.modelViewProjection_loc, 1, 0, mvp);
-        }
+        setModelViewProjection(renderer, cdata, cdata->current_shader_block.modelViewProjection_loc);
         
         if(values != NULL)
         {
             // Upload blit buffer to a single buffer object
-            glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
+            bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
             cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+            bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
             
             // Copy the whole blit buffer to the GPU
             submit_buffer_data(stride * num_vertices, values, sizeof(unsigned short)*num_indices, indices);  // Fills GPU buffer with data.
+            GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, stride * num_vertices + (indices != NULL? sizeof(unsigned short)*num_indices : 0));
             
             // Specify the formatting of the blit buffer
             if(use_vertices)
             {
-                glEnableVertexAttribArray(cdata->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
+                enableVertexAttribArray(cdata, cdata->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
                 glVertexAttribPointer(cdata->current_shader_block.position_loc, size_vertices, GL_FLOAT, GL_FALSE, stride, 0);  // Tell how the data is formatted
             }
             if(use_texcoords)
             {
-                glEnableVertexAttribArray(cdata->current_shader_block.texcoord_loc);
+                enableVertexAttribArray(cdata, cdata->current_shader_block.texcoord_loc);
                 glVertexAttribPointer(cdata->current_shader_block.texcoord_loc, size_texcoords, GL_FLOAT, GL_FALSE, stride, (void*)(offset_texcoords * sizeof(float)));
             }
             if(use_colors)
             {
-                glEnableVertexAttribArray(cdata->current_shader_block.color_loc);
+                enableVertexAttribArray(cdata, cdata->current_shader_block.color_loc);
                 glVertexAttribPointer(cdata->current_shader_block.color_loc, size_colors, GL_FLOAT, GL_FALSE, stride, (void*)(offset_colors * sizeof(float)));
             }
         }
         
         upload_attribute_data(cdata, num_indices);
+        disableUnusedVertexAttribArrays(cdata);
         
         if(indices == NULL)
             glDrawArrays(GL_TRIANGLES, 0, num_indices);
         else
             glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_SHORT, (void*)0);
         
-        // Disable the vertex arrays again
-        if(use_vertices)
-            glDisableVertexAttribArray(cdata->current_shader_block.position_loc);
-        if(use_texcoords)
-            glDisableVertexAttribArray(cdata->current_shader_block.texcoord_loc);
-        if(use_colors)
-            glDisableVertexAttribArray(cdata->current_shader_block.color_loc);
-        
         disable_attribute_data(cdata);
+    }
+#endif
+    
+    countDrawCall(cdata, num_vertices, (indices != NULL? num_indices : 0));
+    
+    cdata->blit_buffer_num_vertices = 0;
+    cdata->index_buffer_num_vertices = 0;
+}
+
+// Assumes the right format
+static void TriangleBatch(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, unsigned short num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+{
+	GPU_CONTEXT_DATA* cdata;
+	
+    if(num_vertices == 0)
+        return;
+    
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if((image != NULL && renderer != image->renderer) || renderer != target->renderer)
+    {
+        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    
+    makeContextCurrent(renderer, target);
+    if(renderer->current_context_target == NULL)
+    {
+        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_USER_ERROR, "NULL context");
+        return;
+    }
+    
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    
+    if((flags & GPU_BATCH_NATIVE) && num_vertices > cdata->blit_buffer_vertex_limit)
+    {
+        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_USER_ERROR, "%d native vertices do not fit in one batch (max %u)", num_vertices, cdata->blit_buffer_vertex_limit);
+        return;
+    }
+    
+    if(!canBatchTriangles(cdata, num_vertices, values, flags))
+    {
+        drawTriangleBatch(renderer, image, target, num_vertices, values, num_indices, indices, flags);
+        return;
+    }
+    
+    // Only actual state changes flush here, so consecutive batches with the same texture, shader, and blending share a draw call
+    prepareToRenderToTarget(renderer, target);
+    if(image != NULL)
+    {
+        prepareToRenderImage(renderer, target, image);
+        
+        // Native data is copied as it is, so it can only sample from the first texture slot
+        if(flags & GPU_BATCH_NATIVE)
+            bindTexture(renderer, image);
+        else
+            bindTextureSlot(renderer, image);
+    }
+    else
+    {
+        prepareToRenderShapes(renderer, GL_TRIANGLES);
+        
+        // These are filled shapes too, so they might be sharing the sprite batch
+        if(cdata->shapes_use_white_texel)
+        {
+            image = cdata->white_texel;
+            if(flags & GPU_BATCH_NATIVE)
+                bindTexture(renderer, image);
+        }
+    }
+    
+    if(!bindFramebuffer(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_TriangleBatch", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+        return;
+    }
+    
+    addTriangles(renderer, cdata, image, target, num_vertices, values, num_indices, indices, flags);
+}
+
+
+typedef struct GPU_VertexBufferData
+{
+    Uint8 use_buffer_objects;
+    unsigned int VBO;
+    unsigned int IBO;
+    float* values;  // System memory copy for renderers that draw it with TriangleBatch() instead
+    unsigned short* indices;
+    int stride;  // In bytes
+} GPU_VertexBufferData;
+
+static Uint8 canUseVertexBufferObjects(GPU_Renderer* renderer)
+{
+    #if defined(SDL_GPU_USE_BUFFER_PIPELINE_FALLBACK)
+    return IsFeatureEnabled(renderer, GPU_FEATURE_VERTEX_SHADER);
+    #elif defined(SDL_GPU_USE_BUFFER_PIPELINE)
+    (void)renderer;
+    return 1;
+    #else
+    (void)renderer;
+    return 0;
+    #endif
+}
+
+static GPU_VertexBuffer* CreateVertexBuffer(GPU_Renderer* renderer, unsigned int num_vertices, float* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
+{
+    GPU_VertexBuffer* result;
+    GPU_VertexBufferData* data;
+    int stride, size_vertices, size_texcoords, size_colors, offset_texcoords, offset_colors;
+    
+    getBatchLayout(flags, &stride, &size_vertices, &size_texcoords, &size_colors, &offset_texcoords, &offset_colors);
+    if(stride == 0)
+    {
+        GPU_PushErrorCode("GPU_CreateVertexBuffer", GPU_ERROR_USER_ERROR, "flags do not specify any vertex data");
+        return NULL;
+    }
+    if(num_vertices == 0)
+    {
+        GPU_PushErrorCode("GPU_CreateVertexBuffer", GPU_ERROR_USER_ERROR, "num_vertices is 0");
+        return NULL;
+    }
+    if(!canUseVertexBufferObjects(renderer) && num_vertices > 65535)
+    {
+        GPU_PushErrorCode("GPU_CreateVertexBuffer", GPU_ERROR_UNSUPPORTED_FUNCTION, "Renderers without buffer objects support at most 65535 vertices per buffer");
+        return NULL;
+    }
+    
+    result = (GPU_VertexBuffer*)SDL_malloc(sizeof(GPU_VertexBuffer));
+    data = (GPU_VertexBufferData*)SDL_malloc(sizeof(GPU_VertexBufferData));
+    memset(data, 0, sizeof(GPU_VertexBufferData));
+    result->renderer = renderer;
+    result->flags = flags;
+    result->num_vertices = num_vertices;
+    result->num_indices = num_indices;
+    result->data = data;
+    data->stride = stride;
+    data->use_buffer_objects = canUseVertexBufferObjects(renderer);
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(data->use_buffer_objects)
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        
+        // The index buffer binding belongs to the bound VAO, and the blit VAO rebinds its own before every draw
+        #if !defined(SDL_GPU_NO_VAO)
+        bindVertexArray(cdata, cdata->blit_VAO);
+        #endif
+        
+        glGenBuffers(1, &data->VBO);
+        bindBuffer(cdata, GL_ARRAY_BUFFER, data->VBO);
+        glBufferData(GL_ARRAY_BUFFER, stride * num_vertices, values, GL_STATIC_DRAW);
+        if(values != NULL)
+            GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, stride * num_vertices);
+        
+        if(num_indices > 0)
+        {
+            glGenBuffers(1, &data->IBO);
+            bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, data->IBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * num_indices, indices, GL_STATIC_DRAW);
+            if(indices != NULL)
+                GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, sizeof(unsigned short) * num_indices);
+        }
+        
+        return result;
+    }
+    #endif
+    
+    data->values = (float*)SDL_malloc(stride * num_vertices);
+    if(values != NULL)
+        memcpy(data->values, values, stride * num_vertices);
+    if(num_indices > 0)
+    {
+        data->indices = (unsigned short*)SDL_malloc(sizeof(unsigned short) * num_indices);
+        if(indices != NULL)
+            memcpy(data->indices, indices, sizeof(unsigned short) * num_indices);
+    }
+    return result;
+}
+
+static void UpdateVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_vertex, unsigned int num_vertices, float* values)
+{
+    GPU_VertexBufferData* data;
+    
+    if(renderer != buffer->renderer)
+    {
+        GPU_PushErrorCode("GPU_UpdateVertexBuffer", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    if(first_vertex + num_vertices > buffer->num_vertices)
+    {
+        GPU_PushErrorCode("GPU_UpdateVertexBuffer", GPU_ERROR_USER_ERROR, "Vertices %u to %u are past the end of the buffer (%u vertices)", first_vertex, first_vertex + num_vertices - 1, buffer->num_vertices);
+        return;
+    }
+    
+    data = (GPU_VertexBufferData*)buffer->data;
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(data->use_buffer_objects)
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        bindBuffer(cdata, GL_ARRAY_BUFFER, data->VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, data->stride * first_vertex, data->stride * num_vertices, values);
+        GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, data->stride * num_vertices);
+        return;
+    }
+    #endif
+    
+    memcpy((char*)data->values + data->stride * first_vertex, values, data->stride * num_vertices);
+}
+
+static void UpdateVertexBufferIndices(GPU_Renderer* renderer, GPU_VertexBuffer* buffer, unsigned int first_index, unsigned int num_indices, unsigned short* indices)
+{
+    GPU_VertexBufferData* data;
+    
+    if(renderer != buffer->renderer)
+    {
+        GPU_PushErrorCode("GPU_UpdateVertexBufferIndices", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    if(first_index + num_indices > buffer->num_indices)
+    {
+        GPU_PushErrorCode("GPU_UpdateVertexBufferIndices", GPU_ERROR_USER_ERROR, "Indices %u to %u are past the end of the buffer (%u indices)", first_index, first_index + num_indices - 1, buffer->num_indices);
+        return;
+    }
+    
+    data = (GPU_VertexBufferData*)buffer->data;
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(data->use_buffer_objects)
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        #if !defined(SDL_GPU_NO_VAO)
+        bindVertexArray(cdata, cdata->blit_VAO);
+        #endif
+        bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, data->IBO);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * first_index, sizeof(unsigned short) * num_indices, indices);
+        GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, sizeof(unsigned short) * num_indices);
+        return;
+    }
+    #endif
+    
+    memcpy(data->indices + first_index, indices, sizeof(unsigned short) * num_indices);
+}
+
+static void DrawVertexBuffer(GPU_Renderer* renderer, GPU_Image* image, GPU_Target* target, GPU_VertexBuffer* buffer)
+{
+    GPU_VertexBufferData* data;
+    
+    if(target == NULL)
+    {
+        GPU_PushErrorCode("GPU_DrawVertexBuffer", GPU_ERROR_NULL_ARGUMENT, "target");
+        return;
+    }
+    if((image != NULL && renderer != image->renderer) || renderer != target->renderer || renderer != buffer->renderer)
+    {
+        GPU_PushErrorCode("GPU_DrawVertexBuffer", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    
+    data = (GPU_VertexBufferData*)buffer->data;
+    if(!data->use_buffer_objects)
+    {
+        renderer->impl->TriangleBatch(renderer, image, target, (unsigned short)buffer->num_vertices, data->values, buffer->num_indices, data->indices, buffer->flags);
+        return;
+    }
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    {
+        GPU_CONTEXT_DATA* cdata;
+        int stride, offset_texcoords, offset_colors;
+        int size_vertices, size_texcoords, size_colors;
+        unsigned int num_indices = (buffer->num_indices > 0? buffer->num_indices : buffer->num_vertices);
+        
+        if(!prepareToRenderTriangles(renderer, image, target))
+        {
+            GPU_PushErrorCode("GPU_DrawVertexBuffer", GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer.");
+            return;
+        }
+        
+        cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
+        refresh_attribute_data(cdata);
+        
+        getBatchLayout(buffer->flags, &stride, &size_vertices, &size_texcoords, &size_colors, &offset_texcoords, &offset_colors);
+        
+        // Skip attributes the shader does not have
+        if(cdata->current_shader_block.position_loc < 0)
+            size_vertices = 0;
+        if(cdata->current_shader_block.texcoord_loc < 0)
+            size_texcoords = 0;
+        if(cdata->current_shader_block.color_loc < 0)
+            size_colors = 0;
         
         #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(0);
+        bindVertexArray(cdata, cdata->blit_VAO);
         #endif
+        
+        // Upload our modelviewprojection matrix
+        setModelViewProjection(renderer, cdata, cdata->current_shader_block.modelViewProjection_loc);
+        
+        // The vertex data is already on the GPU
+        bindBuffer(cdata, GL_ARRAY_BUFFER, data->VBO);
+        if(buffer->num_indices > 0)
+            bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, data->IBO);
+        
+        if(size_vertices > 0)
+        {
+            enableVertexAttribArray(cdata, cdata->current_shader_block.position_loc);
+            glVertexAttribPointer(cdata->current_shader_block.position_loc, size_vertices, GL_FLOAT, GL_FALSE, stride, 0);
+        }
+        if(size_texcoords > 0)
+        {
+            enableVertexAttribArray(cdata, cdata->current_shader_block.texcoord_loc);
+            glVertexAttribPointer(cdata->current_shader_block.texcoord_loc, size_texcoords, GL_FLOAT, GL_FALSE, stride, (void*)(offset_texcoords * sizeof(float)));
+        }
+        if(size_colors > 0)
+        {
+            enableVertexAttribArray(cdata, cdata->current_shader_block.color_loc);
+            glVertexAttribPointer(cdata->current_shader_block.color_loc, size_colors, GL_FLOAT, GL_FALSE, stride, (void*)(offset_colors * sizeof(float)));
+        }
+        
+        upload_attribute_data(cdata, num_indices);
+        disableUnusedVertexAttribArrays(cdata);
+        
+        if(buffer->num_indices == 0)
+            glDrawArrays(GL_TRIANGLES, 0, buffer->num_vertices);
+        else
+            glDrawElements(GL_TRIANGLES, buffer->num_indices, GL_UNSIGNED_SHORT, (void*)0);
+        countDrawCall(cdata, buffer->num_vertices, buffer->num_indices);
+        
+        disable_attribute_data(cdata);
+    }
+    #endif
+}
+
+static void FreeVertexBuffer(GPU_Renderer* renderer, GPU_VertexBuffer* buffer)
+{
+    GPU_VertexBufferData* data;
+    
+    if(buffer == NULL)
+        return;
+    if(renderer != buffer->renderer)
+    {
+        GPU_PushErrorCode("GPU_FreeVertexBuffer", GPU_ERROR_USER_ERROR, "Mismatched renderer");
+        return;
+    }
+    
+    data = (GPU_VertexBufferData*)buffer->data;
+    
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    if(data->use_buffer_objects)
+    {
+        if(renderer->current_context_target != NULL)
+        {
+            GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+            forgetBuffers(cdata, 1, &data->VBO);
+            forgetBuffers(cdata, 1, &data->IBO);
+        }
+        glDeleteBuffers(1, &data->VBO);
+        if(data->IBO != 0)
+            glDeleteBuffers(1, &data->IBO);
+    }
+    #endif
+    
+    SDL_free(data->values);
+    SDL_free(data->indices);
+    SDL_free(data);
+    SDL_free(buffer);
+}
+
+#ifdef SDL_GPU_USE_OPENGL
+// Immutable storage is created with a single level, so it has to be replaced by a texture with room for the mipmaps.
+static Uint8 addMipmapStorage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    unsigned char* pixels;
+    GLuint handle;
+    GLsizei levels;
+    int size;
+
+    pixels = getRawImageData(renderer, image);
+    if(pixels == NULL)
+        return 0;
+
+    glGenTextures(1, &handle);
+    if(handle == 0)
+    {
+        SDL_free(pixels);
+        return 0;
     }
-#endif
-    
-    
-    cdata->blit_buffer_num_vertices = 0;
-    cdata->index_buffer_num_vertices = 0;
 
-    unsetClipRect(renderer, target);
+    levels = 1;
+    for(size = (image->texture_w > image->texture_h? image->texture_w : image->texture_h); size > 1; size /= 2)
+        levels++;
+
+    flushAndClearBlitBufferIfCurrentTexture(renderer, image);
+
+    flushAndBindTexture(renderer, handle);
+    glTexStorage2D(GL_TEXTURE_2D, levels, getSizedTextureFormat(data->format), image->texture_w, image->texture_h);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, image->texture_w);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image->texture_w, image->texture_h, data->format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    SDL_free(pixels);
+
+    deleteTextureHandle((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, data->handle);
+    data->handle = handle;
+
+    if(image->target != NULL && bindFramebuffer(renderer, image->target))
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, handle, 0);
+
+    renderer->impl->SetImageFilter(renderer, image, image->filter_mode);
+    renderer->impl->SetWrapMode(renderer, image, image->wrap_mode_x, image->wrap_mode_y);
+    return 1;
 }
+#endif
 
 static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
 {
@@ -4440,12 +8478,49 @@ static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
     GLint filter;
     if(image == NULL)
         return;
+    if(isCompressedFormat(image->format))
+    {
+        GPU_PushErrorCode("GPU_GenerateMipmaps", GPU_ERROR_USER_ERROR, "Mipmaps of compressed images have to be loaded with them.");
+        return;
+    }
+    if(!restoreEvictedImage(renderer, image))
+        return;
     
+    flushSortedBlitsUsingImage(renderer, image);
+    if(image->target != NULL)
+        flushSortedBlitsUsingTarget(renderer, image->target, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
+    #ifdef SDL_GPU_USE_OPENGL
+    if(((GPU_IMAGE_DATA*)image->data)->immutable && ((GPU_IMAGE_DATA*)image->data)->poolable)
+    {
+        if(!addMipmapStorage(renderer, image))
+        {
+            GPU_PushErrorCode("GPU_GenerateMipmaps", GPU_ERROR_BACKEND_ERROR, "Failed to allocate storage for mipmaps.");
+            return;
+        }
+    }
+    #endif
     bindTexture(renderer, image);
     glGenerateMipmap(GL_TEXTURE_2D);
     image->has_mipmaps = 1;
+    // The texture has more than one level now
+    ((GPU_IMAGE_DATA*)image->data)->poolable = 0;
+    if(((GPU_IMAGE_DATA*)image->data)->memory_bytes != 0)
+    {
+        Uint64 bytes = 0;
+        Uint16 level_w = image->texture_w;
+        Uint16 level_h = image->texture_h;
+        while(1)
+        {
+            bytes += (Uint64)level_w*level_h*image->bytes_per_pixel;
+            if(level_w == 1 && level_h == 1)
+                break;
+            level_w = (level_w > 1? level_w/2 : 1);
+            level_h = (level_h > 1? level_h/2 : 1);
+        }
+        setImageMemory(image, bytes);
+    }
 
     glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filter);
     if(filter == GL_LINEAR)
@@ -4465,8 +8540,9 @@ static GPU_Rect SetClip(GPU_Renderer* renderer, GPU_Target* target, Sint16 x, Si
         return r;
     }
 
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_STATE);
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
     target->use_clip_rect = 1;
 
     r = target->clip_rect;
@@ -4486,8 +8562,9 @@ static void UnsetClip(GPU_Renderer* renderer, GPU_Target* target)
 
     makeContextCurrent(renderer, target);
     
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_STATE);
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
     // Leave the clip rect values intact so they can still be useful as storage
     target->use_clip_rect = 0;
 }
@@ -4507,8 +8584,9 @@ static SDL_Color GetPixel(GPU_Renderer* renderer, GPU_Target* target, Sint16 x,
     if(x < 0 || y < 0 || x >= target->w || y >= target->h)
         return result;
 
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_READBACK);
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_READBACK);
     if(bindFramebuffer(renderer, target))
     {
         unsigned char pixels[4];
@@ -4656,32 +8734,32 @@ static void ClearRGBA(GPU_Renderer* renderer, GPU_Target* target, Uint8 r, Uint8
 
     makeContextCurrent(renderer, target);
     
+    flushSortedBlitsUsingTarget(renderer, target, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
     if(isCurrentTarget(renderer, target))
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_IMAGE_UPDATE);
     if(bindFramebuffer(renderer, target))
     {
         setClipRect(renderer, target);
 
         glClearColor(r/255.0f, g/255.0f, b/255.0f, a/255.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-
-        unsetClipRect(renderer, target);
     }
 }
 
-static void DoPartialFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsigned short num_vertices, float* blit_buffer, unsigned int num_indices, unsigned short* index_buffer)
+static void DoPartialFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsigned int num_vertices, float* blit_buffer, unsigned int num_indices, void* index_buffer)
 {
 	(void)renderer;
+    countDrawCall(cdata, num_vertices, num_indices);
 #ifdef SDL_GPU_USE_ARRAY_PIPELINE
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
     
-    glVertexPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET);
-    glTexCoordPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_TEX_COORD_OFFSET);
-    glColorPointer(4, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_COLOR_OFFSET);
+    glVertexPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE(cdata), blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET);
+    glTexCoordPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE(cdata), blit_buffer + GPU_BLIT_BUFFER_TEX_COORD_OFFSET);
+    glColorPointer(4, (cdata->packed_colors? GL_UNSIGNED_BYTE : GL_FLOAT), GPU_BLIT_BUFFER_STRIDE(cdata), blit_buffer + cdata->blit_buffer_color_offset);
 
-    glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, index_buffer);
+    glDrawElements(cdata->last_shape, num_indices, cdata->index_type, index_buffer);
 
     glDisableClientState(GL_COLOR_ARRAY);
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -4696,18 +8774,18 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsi
 #endif
 #ifdef SDL_GPU_USE_FIXED_FUNCTION_PIPELINE
     {
-        unsigned short i;
+        unsigned int i;
         unsigned int index;
         float* vertex_pointer = blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET;
         float* texcoord_pointer = blit_buffer + GPU_BLIT_BUFFER_TEX_COORD_OFFSET;
-        float* color_pointer = blit_buffer + GPU_BLIT_BUFFER_COLOR_OFFSET;
+        float* color_pointer = blit_buffer + cdata->blit_buffer_color_offset;
         
         glBegin(cdata->last_shape);
         for(i = 0; i < num_indices; i++)
         {
-            index = index_buffer[i]*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-            glColor4f( color_pointer[index], color_pointer[index+1], color_pointer[index+2], color_pointer[index+3] );
-            glTexCoord2f( texcoord_pointer[index], texcoord_pointer[index+1] );
+            index = getIndex(cdata, index_buffer, i)*cdata->blit_buffer_floats_per_vertex;
+            sendBlitBufferColor(cdata, color_pointer + index);
+            sendBlitBufferTexCoords(cdata, texcoord_pointer + index);
             glVertex3f( vertex_pointer[index], vertex_pointer[index+1], 0.0f );
         }
         glEnd();
@@ -4721,77 +8799,82 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsi
 
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
         {
-            // Update the vertex array object's buffers
+            unsigned int vertex_offset;
             #if !defined(SDL_GPU_NO_VAO)
-            glBindVertexArray(cdata->blit_VAO);
+            GPU_VERTEX_FORMAT_DATA* format;
+            unsigned int base_vertex;
+            
+            // Bind a vertex array that is already set up for this format.  It has to come first, since it holds the index buffer binding.
+            format = bindVertexFormat(cdata, getBlitBufferVBO(cdata), 1);
             #endif
             
             // Upload our modelviewprojection matrix
-            if(cdata->current_shader_block.modelViewProjection_loc >= 0)
+            setModelViewProjection(renderer, cdata, cdata->current_shader_block.modelViewProjection_loc);
+            
+            // Copy the whole blit buffer to the GPU.  Sprite indices are already in the immutable quad index buffer.
+            if(index_buffer == cdata->quad_index_buffer && cdata->blit_quad_IBO != 0)
             {
-                float mvp[16];
-                GPU_GetModelViewProjection(mvp);
-                glUniformMatrix4fv(cdata->current_shader_block.modelViewProjection_loc, 1, 0, mvp);
+                vertex_offset = submit_blit_buffer(cdata, GPU_BLIT_BUFFER_STRIDE(cdata) * num_vertices, blit_buffer, 0, NULL);  // Fills GPU buffer with data.
+                bindBuffer(cdata, GL_ELEMENT_ARRAY_BUFFER, cdata->blit_quad_IBO);
             }
+            else
+                vertex_offset = submit_blit_buffer(cdata, GPU_BLIT_BUFFER_STRIDE(cdata) * num_vertices, blit_buffer, getIndexSize(cdata)*num_indices, index_buffer);  // Fills GPU buffer with data.
             
-            // Upload blit buffer to a single buffer object
-            glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
-            cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
-            
-            // Copy the whole blit buffer to the GPU
-            submit_buffer_data(GPU_BLIT_BUFFER_STRIDE * num_vertices, blit_buffer, sizeof(unsigned short)*num_indices, index_buffer);  // Fills GPU buffer with data.
-            
+            #if !defined(SDL_GPU_NO_VAO)
+            base_vertex = settleVertexFormat(cdata, format, vertex_offset);
+            #else
             // Specify the formatting of the blit buffer
             if(cdata->current_shader_block.position_loc >= 0)
             {
-                glEnableVertexAttribArray(cdata->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
-                glVertexAttribPointer(cdata->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, 0);  // Tell how the data is formatted
+                enableVertexAttribArray(cdata, cdata->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
+                glVertexAttribPointer(cdata->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE(cdata), (void*)(size_t)vertex_offset);  // Tell how the data is formatted
             }
             if(cdata->current_shader_block.texcoord_loc >= 0)
             {
-                glEnableVertexAttribArray(cdata->current_shader_block.texcoord_loc);
-                glVertexAttribPointer(cdata->current_shader_block.texcoord_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_TEX_COORD_OFFSET * sizeof(float)));
+                enableVertexAttribArray(cdata, cdata->current_shader_block.texcoord_loc);
+                glVertexAttribPointer(cdata->current_shader_block.texcoord_loc, 2, (cdata->packed_tex_coords? GL_UNSIGNED_SHORT : GL_FLOAT), cdata->packed_tex_coords, GPU_BLIT_BUFFER_STRIDE(cdata), (void*)(vertex_offset + GPU_BLIT_BUFFER_TEX_COORD_OFFSET * sizeof(float)));
             }
             if(cdata->current_shader_block.color_loc >= 0)
             {
-                glEnableVertexAttribArray(cdata->current_shader_block.color_loc);
-                glVertexAttribPointer(cdata->current_shader_block.color_loc, 4, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
+                enableVertexAttribArray(cdata, cdata->current_shader_block.color_loc);
+                glVertexAttribPointer(cdata->current_shader_block.color_loc, 4, (cdata->packed_colors? GL_UNSIGNED_BYTE : GL_FLOAT), cdata->packed_colors, GPU_BLIT_BUFFER_STRIDE(cdata), (void*)(vertex_offset + cdata->blit_buffer_color_offset * sizeof(float)));
+            }
+            #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+            if(cdata->blit_buffer_uses_texture_slots && cdata->texture_slot_loc >= 0)
+            {
+                enableVertexAttribArray(cdata, cdata->texture_slot_loc);
+                glVertexAttribPointer(cdata->texture_slot_loc, 1, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE(cdata), (void*)(vertex_offset + cdata->blit_buffer_texture_slot_offset * sizeof(float)));
             }
+            #endif
+            #endif
             
             upload_attribute_data(cdata, num_vertices);
-            
-            glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, (void*)0);
-            
-            // Disable the vertex arrays again
-            if(cdata->current_shader_block.position_loc >= 0)
-                glDisableVertexAttribArray(cdata->current_shader_block.position_loc);
-            if(cdata->current_shader_block.texcoord_loc >= 0)
-                glDisableVertexAttribArray(cdata->current_shader_block.texcoord_loc);
-            if(cdata->current_shader_block.color_loc >= 0)
-                glDisableVertexAttribArray(cdata->current_shader_block.color_loc);
-            
-            disable_attribute_data(cdata);
+            disableUnusedVertexAttribArrays(cdata);
             
             #if !defined(SDL_GPU_NO_VAO)
-            glBindVertexArray(0);
+            drawVertexFormat(cdata, base_vertex, num_indices);
+            #else
+            glDrawElements(cdata->last_shape, num_indices, cdata->index_type, (void*)0);
             #endif
+            
+            disable_attribute_data(cdata);
         }
 #endif
 }
 
-static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsigned short num_vertices, float* blit_buffer, unsigned int num_indices, unsigned short* index_buffer)
+static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsigned int num_vertices, float* blit_buffer, unsigned int num_indices, void* index_buffer)
 {
 	(void)renderer;
+    countDrawCall(cdata, num_vertices, num_indices);
 
 #ifdef SDL_GPU_USE_ARRAY_PIPELINE
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
     
-    glVertexPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET);
-    glColorPointer(4, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE, blit_buffer + GPU_BLIT_BUFFER_COLOR_OFFSET);
+    glVertexPointer(2, GL_FLOAT, GPU_BLIT_BUFFER_STRIDE(cdata), blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET);
+    glColorPointer(4, (cdata->packed_colors? GL_UNSIGNED_BYTE : GL_FLOAT), GPU_BLIT_BUFFER_STRIDE(cdata), blit_buffer + cdata->blit_buffer_color_offset);
 
-    glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, index_buffer);
+    glDrawElements(cdata->last_shape, num_indices, cdata->index_type, index_buffer);
 
     glDisableClientState(GL_COLOR_ARRAY);
     glDisableClientState(GL_VERTEX_ARRAY);
@@ -4803,16 +8886,16 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, u
 #endif
 #ifdef SDL_GPU_USE_FIXED_FUNCTION_PIPELINE
     {
-        unsigned short i;
+        unsigned int i;
         unsigned int index;
         float* vertex_pointer = blit_buffer + GPU_BLIT_BUFFER_VERTEX_OFFSET;
-        float* color_pointer = blit_buffer + GPU_BLIT_BUFFER_COLOR_OFFSET;
+        float* color_pointer = blit_buffer + cdata->blit_buffer_color_offset;
         
         glBegin(cdata->last_shape);
         for(i = 0; i < num_indices; i++)
         {
-            index = index_buffer[i]*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
-            glColor4f( color_pointer[index], color_pointer[index+1], color_pointer[index+2], color_pointer[index+3] );
+            index = getIndex(cdata, index_buffer, i)*cdata->blit_buffer_floats_per_vertex;
+            sendBlitBufferColor(cdata, color_pointer + index);
             glVertex3f( vertex_pointer[index], vertex_pointer[index+1], 0.0f );
         }
         glEnd();
@@ -4823,74 +8906,111 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, u
 
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
     {
-        // Update the vertex array object's buffers
+        unsigned int vertex_offset;
         #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(cdata->blit_VAO);
+        GPU_VERTEX_FORMAT_DATA* format;
+        unsigned int base_vertex;
+        
+        // Bind a vertex array that is already set up for this format.  It has to come first, since it holds the index buffer binding.
+        format = bindVertexFormat(cdata, getBlitBufferVBO(cdata), 0);
         #endif
         
         // Upload our modelviewprojection matrix
-        if(cdata->current_shader_block.modelViewProjection_loc >= 0)
-        {
-            float mvp[16];
-            GPU_GetModelViewProjection(mvp);
-            glUniformMatrix4fv(cdata->current_shader_block.modelViewProjection_loc, 1, 0, mvp);
-        }
-        
-        // Upload blit buffer to a single buffer object
-        glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
-        cdata->blit_VBO_flop = !cdata->blit_VBO_flop;
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
+        setModelViewProjection(renderer, cdata, cdata->current_shader_block.modelViewProjection_loc);
         
         // Copy the whole blit buffer to the GPU
-        submit_buffer_data(GPU_BLIT_BUFFER_STRIDE * num_vertices, blit_buffer, sizeof(unsigned short)*num_indices, index_buffer);  // Fills GPU buffer with data.
+        vertex_offset = submit_blit_buffer(cdata, GPU_BLIT_BUFFER_STRIDE(cdata) * num_vertices, blit_buffer, getIndexSize(cdata)*num_indices, index_buffer);  // Fills GPU buffer with data.
         
+        #if !defined(SDL_GPU_NO_VAO)
+        base_vertex = settleVertexFormat(cdata, format, vertex_offset);
+        #else
         // Specify the formatting of the blit buffer
         if(cdata->current_shader_block.position_loc >= 0)
         {
-            glEnableVertexAttribArray(cdata->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
-            glVertexAttribPointer(cdata->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, 0);  // Tell how the data is formatted
+            enableVertexAttribArray(cdata, cdata->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
+            glVertexAttribPointer(cdata->current_shader_block.position_loc, 2, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE(cdata), (void*)(size_t)vertex_offset);  // Tell how the data is formatted
         }
         if(cdata->current_shader_block.color_loc >= 0)
         {
-            glEnableVertexAttribArray(cdata->current_shader_block.color_loc);
-            glVertexAttribPointer(cdata->current_shader_block.color_loc, 4, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
+            enableVertexAttribArray(cdata, cdata->current_shader_block.color_loc);
+            glVertexAttribPointer(cdata->current_shader_block.color_loc, 4, (cdata->packed_colors? GL_UNSIGNED_BYTE : GL_FLOAT), cdata->packed_colors, GPU_BLIT_BUFFER_STRIDE(cdata), (void*)(vertex_offset + cdata->blit_buffer_color_offset * sizeof(float)));
         }
+        #endif
         
         upload_attribute_data(cdata, num_vertices);
-        
-        glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, (void*)0);
-        
-        // Disable the vertex arrays again
-        if(cdata->current_shader_block.position_loc >= 0)
-            glDisableVertexAttribArray(cdata->current_shader_block.position_loc);
-        if(cdata->current_shader_block.color_loc >= 0)
-            glDisableVertexAttribArray(cdata->current_shader_block.color_loc);
-        
-        disable_attribute_data(cdata);
+        disableUnusedVertexAttribArrays(cdata);
         
         #if !defined(SDL_GPU_NO_VAO)
-        glBindVertexArray(0);
+        drawVertexFormat(cdata, base_vertex, num_indices);
+        #else
+        glDrawElements(cdata->last_shape, num_indices, cdata->index_type, (void*)0);
         #endif
+        
+        disable_attribute_data(cdata);
     }
 #endif
 }
 
 #define MAX(a, b) ((a) > (b)? (a) : (b))
 
-static void FlushBlitBuffer(GPU_Renderer* renderer)
+#ifdef SDL_GPU_USE_INSTANCING
+static void DoInstancedFlush(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata)
+{
+    useProgram(cdata, cdata->instanced_shader_program);
+    
+    // Upload our modelviewprojection matrix
+    setModelViewProjection(renderer, cdata, cdata->instanced_modelViewProjection_loc);
+    
+    bindVertexArray(cdata, cdata->instance_VAO);
+    bindBuffer(cdata, GL_ARRAY_BUFFER, cdata->instance_VBO);
+    glBufferData(GL_ARRAY_BUFFER, GPU_INSTANCE_BUFFER_STRIDE * cdata->instance_buffer_num_instances, cdata->instance_buffer, GL_STREAM_DRAW);
+    GPU_ADD_FRAME_STAT(cdata, bytes_uploaded, GPU_INSTANCE_BUFFER_STRIDE * cdata->instance_buffer_num_instances);
+    
+    // Each instance is a 4-vertex strip whose corners come from gl_VertexID
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, cdata->instance_buffer_num_instances);
+    countDrawCall(cdata, 4*cdata->instance_buffer_num_instances, 0);
+    
+    useProgram(cdata, renderer->current_context_target->context->current_shader_program);
+    GPU_ADD_FRAME_STAT(cdata, shader_switches, 2);
+    
+    cdata->instance_buffer_num_instances = 0;
+}
+#endif
+
+static void flushBlitBuffer(GPU_Renderer* renderer)
 {
     GPU_CONTEXT_DATA* cdata;
+    #ifndef SDL_GPU_DISABLE_FRAME_STATS
+    GPU_FlushCauseEnum cause;
+    #endif
     if(renderer->current_context_target == NULL)
         return;
     
     cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
-    if(cdata->blit_buffer_num_vertices > 0 && cdata->last_target != NULL)
+    
+    #ifndef SDL_GPU_DISABLE_FRAME_STATS
+    // Flushes from replaying sorted blits count under their own causes
+    cause = (GPU_FlushCauseEnum)cdata->flush_cause;
+    cdata->flush_cause = GPU_FLUSH_CAUSE_USER;
+    #endif
+    
+    submitSortedBlits(renderer, cdata);
+    
+    if((cdata->blit_buffer_num_vertices > 0
+        #ifdef SDL_GPU_USE_INSTANCING
+        || cdata->instance_buffer_num_instances > 0
+        #endif
+        ) && cdata->last_target != NULL)
     {
 		GPU_Target* dest = cdata->last_target;
-		int num_vertices;
-		int num_indices;
+		unsigned int num_vertices;
+		unsigned int num_indices;
 		float* blit_buffer;
-		unsigned short* index_buffer;
+        
+        #ifndef SDL_GPU_DISABLE_FRAME_STATS
+        cdata->frame_stats.flushes++;
+        cdata->frame_stats.flushes_by_cause[cause]++;
+        #endif
         
         changeViewport(dest);
         changeCamera(dest);
@@ -4909,38 +9029,183 @@ static void FlushBlitBuffer(GPU_Renderer* renderer)
         #endif
         
         blit_buffer = cdata->blit_buffer;
-        index_buffer = cdata->index_buffer;
         
         if(cdata->last_use_texturing)
         {
+            #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+            GPU_ShaderBlock saved_shader_block = cdata->current_shader_block;
+            #endif
+            
+            #ifdef SDL_GPU_USE_INSTANCING
+            if(cdata->instance_buffer_num_instances > 0)
+                DoInstancedFlush(renderer, cdata);
+            #endif
+            
+            #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+            // Sprites from more than one texture need the shader that picks a slot per vertex
+            if(cdata->blit_buffer_uses_texture_slots && cdata->blit_buffer_num_vertices > 0)
+            {
+                useProgram(cdata, cdata->texture_slots_shader_program);
+                cdata->current_shader_block = cdata->texture_slots_shader_block;
+                GPU_ADD_FRAME_STAT(cdata, shader_switches, 2);
+            }
+            #endif
+            
+            if(cdata->blit_buffer_uses_index_buffer)
+            {
+                // Triangles were batched with the sprites, so everything has its own indices
+                DoPartialFlush(renderer, cdata, cdata->blit_buffer_num_vertices, blit_buffer, cdata->index_buffer_num_vertices, cdata->index_buffer);
+                cdata->blit_buffer_num_vertices = 0;
+            }
+            
             while(cdata->blit_buffer_num_vertices > 0)
             {
                 num_vertices = MAX(cdata->blit_buffer_num_vertices, get_lowest_attribute_num_values(cdata, cdata->blit_buffer_num_vertices));
                 num_indices = num_vertices * 3 / 2;  // 6 indices per sprite / 4 vertices per sprite = 3/2
                 
-                DoPartialFlush(renderer, cdata, num_vertices, blit_buffer, num_indices, index_buffer);
+                // Every partial flush starts its own sprites at vertex 0, so the quad indices always start from the beginning
+                DoPartialFlush(renderer, cdata, num_vertices, blit_buffer, num_indices, cdata->quad_index_buffer);
                 
                 cdata->blit_buffer_num_vertices -= num_vertices;
-                // Move our pointers ahead
-                blit_buffer += GPU_BLIT_BUFFER_FLOATS_PER_VERTEX*num_vertices;
-                index_buffer += num_indices;
+                // Move our pointer ahead
+                blit_buffer += cdata->blit_buffer_floats_per_vertex*num_vertices;
+            }
+            
+            #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+            if(cdata->blit_buffer_uses_texture_slots)
+            {
+                useProgram(cdata, renderer->current_context_target->context->current_shader_program);
+                cdata->current_shader_block = saved_shader_block;
+                cdata->blit_buffer_uses_texture_slots = 0;
             }
+            #endif
         }
         else
         {
-            DoUntexturedFlush(renderer, cdata, cdata->blit_buffer_num_vertices, blit_buffer, cdata->index_buffer_num_vertices, index_buffer);
+            DoUntexturedFlush(renderer, cdata, cdata->blit_buffer_num_vertices, blit_buffer, cdata->index_buffer_num_vertices, cdata->index_buffer);
         }
 
         cdata->blit_buffer_num_vertices = 0;
         cdata->index_buffer_num_vertices = 0;
+        cdata->blit_buffer_uses_index_buffer = 0;
+    }
+}
+
+// GPU_FlushBlitBuffer() is where the application may continue with its own GL calls, so this also undoes the state that flushes otherwise leave in place
+static void FlushBlitBuffer(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata;
+    
+    flushBlitBuffer(renderer);
+    if(renderer->current_context_target == NULL)
+        return;
+    
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    setScissorTest(cdata, 0);
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    #if !defined(SDL_GPU_NO_VAO)
+    bindVertexArray(cdata, 0);
+    #else
+    disableUnusedVertexAttribArrays(cdata);
+    #endif
+    #endif
+}
+
+static GPU_TypeEnum GetIndexType(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    return (cdata->index_type == GL_UNSIGNED_INT? GPU_TYPE_UNSIGNED_INT : GPU_TYPE_UNSIGNED_SHORT);
+}
+
+static GPU_NativeVertexLayout GetNativeVertexLayout(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    GPU_NativeVertexLayout layout;
+    
+    layout.stride = GPU_BLIT_BUFFER_STRIDE(cdata);
+    layout.position_offset = GPU_BLIT_BUFFER_VERTEX_OFFSET * sizeof(float);
+    layout.texcoord_offset = GPU_BLIT_BUFFER_TEX_COORD_OFFSET * sizeof(float);
+    layout.texcoord_type = (cdata->packed_tex_coords? GPU_TYPE_UNSIGNED_SHORT : GPU_TYPE_FLOAT);
+    layout.color_offset = cdata->blit_buffer_color_offset * sizeof(float);
+    layout.color_type = (cdata->packed_colors? GPU_TYPE_UNSIGNED_BYTE : GPU_TYPE_FLOAT);
+    layout.texture_slot_offset = -1;
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    if(cdata->use_texture_slots)
+        layout.texture_slot_offset = cdata->blit_buffer_texture_slot_offset * sizeof(float);
+    #endif
+    layout.max_vertices = cdata->blit_buffer_vertex_limit;
+    
+    return layout;
+}
 
-        unsetClipRect(renderer, dest);
+static void SetBatchMode(GPU_Renderer* renderer, GPU_BatchModeEnum mode)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    
+    if(mode != GPU_BATCH_MODE_IMMEDIATE && mode != GPU_BATCH_MODE_SORTED)
+    {
+        GPU_PushErrorCode("GPU_SetBatchMode", GPU_ERROR_USER_ERROR, "Unsupported value for mode (0x%x)", mode);
+        return;
     }
+    
+    if(cdata->batch_mode == mode)
+        return;
+    
+    // Everything batched so far goes out the way it was batched
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_USER);
+    cdata->batch_mode = mode;
+}
+
+static GPU_BatchModeEnum GetBatchMode(GPU_Renderer* renderer)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    return (GPU_BatchModeEnum)cdata->batch_mode;
+}
+
+static void SetBatchLayer(GPU_Renderer* renderer, int layer)
+{
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->batch_layer = layer;
+}
+
+static int GetBatchLayer(GPU_Renderer* renderer)
+{
+    return ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->batch_layer;
+}
+
+static void SetCulling(GPU_Renderer* renderer, Uint8 enable)
+{
+    ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->use_culling = (enable? 1 : 0);
+}
+
+static Uint8 GetCulling(GPU_Renderer* renderer)
+{
+    return ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->use_culling;
+}
+
+static GPU_FrameStats GetFrameStats(GPU_Renderer* renderer)
+{
+    #ifndef SDL_GPU_DISABLE_FRAME_STATS
+    return ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->frame_stats;
+    #else
+    GPU_FrameStats stats;
+    (void)renderer;
+    memset(&stats, 0, sizeof(GPU_FrameStats));
+    return stats;
+    #endif
+}
+
+static void ResetFrameStats(GPU_Renderer* renderer)
+{
+    #ifndef SDL_GPU_DISABLE_FRAME_STATS
+    memset(&((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->frame_stats, 0, sizeof(GPU_FrameStats));
+    #else
+    (void)renderer;
+    #endif
 }
 
 static void Flip(GPU_Renderer* renderer, GPU_Target* target)
 {
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_FLIP);
     
     makeContextCurrent(renderer, target);
 
@@ -5309,6 +9574,10 @@ static Uint8 LinkShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
     
 	glLinkProgram(program_object);
 	
+	// Linking resets the uniforms
+	forgetModelViewProjection((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, program_object);
+	forgetProgramUniforms((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, program_object);
+	
 	glGetProgramiv(program_object, GL_LINK_STATUS, &linked);
 	
 	if(!linked)
@@ -5345,7 +9614,12 @@ static void FreeShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
 	(void)program_object;
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+    {
+        // The name can be reused by a new program
+        forgetModelViewProjection((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, program_object);
+        forgetProgramUniforms((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, program_object);
         glDeleteProgram(program_object);
+    }
     #endif
 }
 
@@ -5388,12 +9662,15 @@ static void ActivateShaderProgram(GPU_Renderer* renderer, Uint32 program_object,
             program_object = target->context->default_untextured_shader_program;
         }
         
-        renderer->impl->FlushBlitBuffer(renderer);
-        glUseProgram(program_object);
+        // Pending values go to the program they were set for
+        commitUniforms(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
+        useProgram((GPU_CONTEXT_DATA*)target->context->data, program_object);
     
 		{
 			// Set up our shader attribute and uniform locations
 			GPU_CONTEXT_DATA* cdata = ((GPU_CONTEXT_DATA*)target->context->data);
+			GPU_ADD_FRAME_STAT(cdata, shader_switches, 1);
 			if(block == NULL)
 			{
 				if(program_object == target->context->default_textured_shader_program)
@@ -5514,25 +9791,43 @@ static void SetShaderImage(GPU_Renderer* renderer, GPU_Image* image, int locatio
     // TODO: OpenGL 1 needs to check for ARB_multitexture to use glActiveTexture().
     #ifndef SDL_GPU_DISABLE_SHADERS
 	Uint32 new_texture;
+	GPU_CONTEXT_DATA* cdata;
 	
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
     
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
     if(renderer->current_context_target->context->current_shader_program == 0 || image_unit < 0)
         return;
     
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
     new_texture = 0;
     if(image != NULL)
+    {
+        restoreEvictedImage(renderer, image);
+        touchImageMemory((GPU_IMAGE_DATA*)image->data);
         new_texture = ((GPU_IMAGE_DATA*)image->data)->handle;
+    }
     
     // Set the new image unit
+    forgetUniform(cdata, renderer->current_context_target->context->current_shader_program, location);
     glUniform1i(location, image_unit);
-    glActiveTexture(GL_TEXTURE0 + image_unit);
-    glBindTexture(GL_TEXTURE_2D, new_texture);
+    bindTextureHandleToUnit(cdata, image_unit, new_texture);
     
-    if(image_unit != 0)
-        glActiveTexture(GL_TEXTURE0);
+    #ifdef SDL_GPU_USE_TEXTURE_SLOTS
+    // The texture slots no longer hold what we think they do
+    if((unsigned int)image_unit < cdata->num_texture_slots_used)
+        cdata->num_texture_slots_used = image_unit;
+    
+    // Keep later sprite batches from binding slots over this image
+    if(image_unit > 0 && image_unit < GPU_MAX_TEXTURE_SLOTS)
+    {
+        if(image != NULL)
+            cdata->shader_image_units |= (1u << image_unit);
+        else
+            cdata->shader_image_units &= ~(1u << image_unit);
+    }
+    #endif
     
 	#endif
 
@@ -5554,8 +9849,10 @@ static void GetUniformiv(GPU_Renderer* renderer, Uint32 program_object, int loca
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
     program_object = get_proper_program_id(renderer, program_object);
-    if(program_object != 0)
-        glGetUniformiv(program_object, location, values);
+    if(program_object == 0 || getShadowedUniform(renderer, program_object, location, GPU_UNIFORM_TYPE_INT, values))
+        return;
+    commitUniforms(renderer);
+    glGetUniformiv(program_object, location, values);
     #endif
 }
 
@@ -5568,10 +9865,9 @@ static void SetUniformi(GPU_Renderer* renderer, int location, int value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
-    glUniform1i(location, value);
+    setShadowedUniform(renderer, location, GPU_UNIFORM_TYPE_INT, 1, 1, 1, 0, &value, sizeof(int));
     #endif
 }
 
@@ -5586,24 +9882,11 @@ static void SetUniformiv(GPU_Renderer* renderer, int location, int num_elements_
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
-    switch(num_elements_per_value)
-    {
-        case 1:
-        glUniform1iv(location, num_values, values);
-        break;
-        case 2:
-        glUniform2iv(location, num_values, values);
-        break;
-        case 3:
-        glUniform3iv(location, num_values, values);
-        break;
-        case 4:
-        glUniform4iv(location, num_values, values);
-        break;
-    }
+    if(num_elements_per_value < 1 || num_elements_per_value > 4)
+        return;
+    setShadowedUniform(renderer, location, GPU_UNIFORM_TYPE_INT, num_elements_per_value, 1, num_values, 0, values, num_elements_per_value*num_values*sizeof(int));
     #endif
 }
 
@@ -5619,12 +9902,14 @@ static void GetUniformuiv(GPU_Renderer* renderer, Uint32 program_object, int loc
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
     program_object = get_proper_program_id(renderer, program_object);
-    if(program_object != 0)
-        #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
-        glGetUniformiv(program_object, location, (int*)values);
-        #else
-        glGetUniformuiv(program_object, location, values);
-        #endif
+    if(program_object == 0 || getShadowedUniform(renderer, program_object, location, GPU_UNIFORM_TYPE_UINT, values))
+        return;
+    commitUniforms(renderer);
+    #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
+    glGetUniformiv(program_object, location, (int*)values);
+    #else
+    glGetUniformuiv(program_object, location, values);
+    #endif
     #endif
 }
 
@@ -5637,14 +9922,9 @@ static void SetUniformui(GPU_Renderer* renderer, int location, unsigned int valu
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
-    #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
-    glUniform1i(location, (int)value);
-    #else
-    glUniform1ui(location, value);
-    #endif
+    setShadowedUniform(renderer, location, GPU_UNIFORM_TYPE_UINT, 1, 1, 1, 0, &value, sizeof(unsigned int));
     #endif
 }
 
@@ -5659,42 +9939,11 @@ static void SetUniformuiv(GPU_Renderer* renderer, int location, int num_elements
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
-    #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
-    switch(num_elements_per_value)
-    {
-        case 1:
-        glUniform1iv(location, num_values, (int*)values);
-        break;
-        case 2:
-        glUniform2iv(location, num_values, (int*)values);
-        break;
-        case 3:
-        glUniform3iv(location, num_values, (int*)values);
-        break;
-        case 4:
-        glUniform4iv(location, num_values, (int*)values);
-        break;
-    }
-    #else
-    switch(num_elements_per_value)
-    {
-        case 1:
-        glUniform1uiv(location, num_values, values);
-        break;
-        case 2:
-        glUniform2uiv(location, num_values, values);
-        break;
-        case 3:
-        glUniform3uiv(location, num_values, values);
-        break;
-        case 4:
-        glUniform4uiv(location, num_values, values);
-        break;
-    }
-    #endif
+    if(num_elements_per_value < 1 || num_elements_per_value > 4)
+        return;
+    setShadowedUniform(renderer, location, GPU_UNIFORM_TYPE_UINT, num_elements_per_value, 1, num_values, 0, values, num_elements_per_value*num_values*sizeof(unsigned int));
     #endif
 }
 
@@ -5710,8 +9959,10 @@ static void GetUniformfv(GPU_Renderer* renderer, Uint32 program_object, int loca
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
     program_object = get_proper_program_id(renderer, program_object);
-    if(program_object != 0)
-        glGetUniformfv(program_object, location, values);
+    if(program_object == 0 || getShadowedUniform(renderer, program_object, location, GPU_UNIFORM_TYPE_FLOAT, values))
+        return;
+    commitUniforms(renderer);
+    glGetUniformfv(program_object, location, values);
     #endif
 }
 
@@ -5724,10 +9975,9 @@ static void SetUniformf(GPU_Renderer* renderer, int location, float value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
-    glUniform1f(location, value);
+    setShadowedUniform(renderer, location, GPU_UNIFORM_TYPE_FLOAT, 1, 1, 1, 0, &value, sizeof(float));
     #endif
 }
 
@@ -5742,24 +9992,11 @@ static void SetUniformfv(GPU_Renderer* renderer, int location, int num_elements_
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
-    switch(num_elements_per_value)
-    {
-        case 1:
-        glUniform1fv(location, num_values, values);
-        break;
-        case 2:
-        glUniform2fv(location, num_values, values);
-        break;
-        case 3:
-        glUniform3fv(location, num_values, values);
-        break;
-        case 4:
-        glUniform4fv(location, num_values, values);
-        break;
-    }
+    if(num_elements_per_value < 1 || num_elements_per_value > 4)
+        return;
+    setShadowedUniform(renderer, location, GPU_UNIFORM_TYPE_FLOAT, num_elements_per_value, 1, num_values, 0, values, num_elements_per_value*num_values*sizeof(float));
     #endif
 }
 
@@ -5776,7 +10013,6 @@ static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_mat
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     if(num_rows < 2 || num_rows > 4 || num_columns < 2 || num_columns > 4)
@@ -5785,13 +10021,6 @@ static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_mat
         return;
     }
     #if defined(SDL_GPU_USE_GLES)
-    // Hide these symbols so it compiles, but make sure they never get called because GLES only supports square matrices.
-    #define glUniformMatrix2x3fv glUniformMatrix2fv
-    #define glUniformMatrix2x4fv glUniformMatrix2fv
-    #define glUniformMatrix3x2fv glUniformMatrix2fv
-    #define glUniformMatrix3x4fv glUniformMatrix2fv
-    #define glUniformMatrix4x2fv glUniformMatrix2fv
-    #define glUniformMatrix4x3fv glUniformMatrix2fv
     if(num_rows != num_columns)
     {
         GPU_PushErrorCode("GPU_SetUniformMatrixfv", GPU_ERROR_DATA_ERROR, "GLES renderers do not accept non-square matrices (given %dx%d)", num_rows, num_columns);
@@ -5799,33 +10028,9 @@ static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_mat
     }
     #endif
     
-    switch(num_rows)
-    {
-    case 2:
-        if(num_columns == 2)
-            glUniformMatrix2fv(location, num_matrices, transpose, values);
-        else if(num_columns == 3)
-            glUniformMatrix2x3fv(location, num_matrices, transpose, values);
-        else if(num_columns == 4)
-            glUniformMatrix2x4fv(location, num_matrices, transpose, values);
-        break;
-    case 3:
-        if(num_columns == 2)
-            glUniformMatrix3x2fv(location, num_matrices, transpose, values);
-        else if(num_columns == 3)
-            glUniformMatrix3fv(location, num_matrices, transpose, values);
-        else if(num_columns == 4)
-            glUniformMatrix3x4fv(location, num_matrices, transpose, values);
-        break;
-    case 4:
-        if(num_columns == 2)
-            glUniformMatrix4x2fv(location, num_matrices, transpose, values);
-        else if(num_columns == 3)
-            glUniformMatrix4x3fv(location, num_matrices, transpose, values);
-        else if(num_columns == 4)
-            glUniformMatrix4fv(location, num_matrices, transpose, values);
-        break;
-    }
+    // This might overwrite the model-view-projection matrix
+    forgetModelViewProjection((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data, renderer->current_context_target->context->current_shader_program);
+    setShadowedUniform(renderer, location, GPU_UNIFORM_TYPE_MATRIX, num_rows, num_columns, num_matrices, transpose, values, num_rows*num_columns*num_matrices*sizeof(float));
     #endif
 }
 
@@ -5839,7 +10044,7 @@ static void SetAttributef(GPU_Renderer* renderer, int location, float value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     
@@ -5866,7 +10071,7 @@ static void SetAttributei(GPU_Renderer* renderer, int location, int value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     
@@ -5893,7 +10098,7 @@ static void SetAttributeui(GPU_Renderer* renderer, int location, unsigned int va
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     
@@ -5922,7 +10127,7 @@ static void SetAttributefv(GPU_Renderer* renderer, int location, int num_element
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     
@@ -5963,7 +10168,7 @@ static void SetAttributeiv(GPU_Renderer* renderer, int location, int num_element
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     
@@ -6005,7 +10210,7 @@ static void SetAttributeuiv(GPU_Renderer* renderer, int location, int num_elemen
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
+    flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_SHADER);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     
@@ -6113,16 +10318,23 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->CreateImage = &CreateImage; \
     impl->CreateImageUsingTexture = &CreateImageUsingTexture; \
     impl->LoadImage = &LoadImage; \
+    impl->CreateImageFromCompressedData = &CreateImageFromCompressedData; \
     impl->CreateAliasImage = &CreateAliasImage; \
     impl->SaveImage = &SaveImage; \
     impl->CopyImage = &CopyImage; \
     impl->UpdateImage = &UpdateImage; \
     impl->UpdateImageBytes = &UpdateImageBytes; \
+    impl->LockImageBytes = &LockImageBytes; \
+    impl->UnlockImageBytes = &UnlockImageBytes; \
+    impl->UpdateImageBytesAsync = &UpdateImageBytesAsync; \
     impl->CopyImageFromSurface = &CopyImageFromSurface; \
     impl->CopyImageFromTarget = &CopyImageFromTarget; \
     impl->CopySurfaceFromTarget = &CopySurfaceFromTarget; \
     impl->CopySurfaceFromImage = &CopySurfaceFromImage; \
     impl->FreeImage = &FreeImage; \
+    impl->GetImageMemoryUsage = &GetImageMemoryUsage; \
+    impl->GetMemoryStats = &GetMemoryStats; \
+    impl->SetMemoryBudget = &SetMemoryBudget; \
  \
     impl->LoadTarget = &LoadTarget; \
     impl->FreeTarget = &FreeTarget; \
@@ -6132,7 +10344,13 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->BlitScale = &BlitScale; \
     impl->BlitTransform = &BlitTransform; \
     impl->BlitTransformX = &BlitTransformX; \
+    impl->BlitBatch = &BlitBatch; \
     impl->TriangleBatch = &TriangleBatch; \
+    impl->CreateVertexBuffer = &CreateVertexBuffer; \
+    impl->UpdateVertexBuffer = &UpdateVertexBuffer; \
+    impl->UpdateVertexBufferIndices = &UpdateVertexBufferIndices; \
+    impl->DrawVertexBuffer = &DrawVertexBuffer; \
+    impl->FreeVertexBuffer = &FreeVertexBuffer; \
  \
     impl->GenerateMipmaps = &GenerateMipmaps; \
  \
@@ -6145,6 +10363,16 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
  \
     impl->ClearRGBA = &ClearRGBA; \
     impl->FlushBlitBuffer = &FlushBlitBuffer; \
+    impl->GetIndexType = &GetIndexType; \
+    impl->GetNativeVertexLayout = &GetNativeVertexLayout; \
+    impl->SetBatchMode = &SetBatchMode; \
+    impl->GetBatchMode = &GetBatchMode; \
+    impl->SetBatchLayer = &SetBatchLayer; \
+    impl->GetBatchLayer = &GetBatchLayer; \
+    impl->SetCulling = &SetCulling; \
+    impl->GetCulling = &GetCulling; \
+    impl->GetFrameStats = &GetFrameStats; \
+    impl->ResetFrameStats = &ResetFrameStats; \
     impl->Flip = &Flip; \
      \
     impl->CompileShader_RW = &CompileShader_RW; \
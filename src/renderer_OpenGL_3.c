@@ -22,6 +22,9 @@ void GPU_FreeRenderer_OpenGL_3(GPU_Renderer* renderer) {}
 #define SDL_GPU_GLSL_VERSION_CORE 150
 #define SDL_GPU_GL_MAJOR_VERSION 3
 #define SDL_GPU_ENABLE_CORE_SHADERS
+#define SDL_GPU_USE_BUFFER_RING
+#define SDL_GPU_USE_INSTANCING
+#define SDL_GPU_USE_TEXTURE_SLOTS
 
 #include "renderer_GL_common.inl"
 #include "renderer_shapes_GL_common.inl"
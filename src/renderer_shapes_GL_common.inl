@@ -15,15 +15,71 @@ See a particular renderer's *.c file for specifics. */
 
 
 
+// Box around two corners in any order, grown on every side by margin (e.g. a radius or half of the line thickness)
+static GPU_Rect makeShapeBounds(float x1, float y1, float x2, float y2, float margin)
+{
+    GPU_Rect bounds;
+    margin = fabsf(margin);
+    bounds.x = (x1 < x2? x1 : x2) - margin;
+    bounds.y = (y1 < y2? y1 : y2) - margin;
+    bounds.w = fabsf(x2 - x1) + 2*margin;
+    bounds.h = fabsf(y2 - y1) + 2*margin;
+    return bounds;
+}
+
+static GPU_Rect makeTriangleBounds(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    GPU_Rect bounds = makeShapeBounds(x1, y1, x2, y2, 0.0f);
+    if(x3 < bounds.x)
+    {
+        bounds.w += bounds.x - x3;
+        bounds.x = x3;
+    }
+    else if(x3 > bounds.x + bounds.w)
+        bounds.w = x3 - bounds.x;
+    if(y3 < bounds.y)
+    {
+        bounds.h += bounds.y - y3;
+        bounds.y = y3;
+    }
+    else if(y3 > bounds.y + bounds.h)
+        bounds.h = y3 - bounds.y;
+    return bounds;
+}
+
+static GPU_Rect makePolygonBounds(unsigned int num_vertices, float* vertices)
+{
+    float min_x = vertices[0];
+    float min_y = vertices[1];
+    float max_x = vertices[0];
+    float max_y = vertices[1];
+    unsigned int i;
+    
+    for(i = 1; i < num_vertices; i++)
+    {
+        float x = vertices[2*i];
+        float y = vertices[2*i+1];
+        if(x < min_x)
+            min_x = x;
+        else if(x > max_x)
+            max_x = x;
+        if(y < min_y)
+            min_y = y;
+        else if(y > max_y)
+            max_y = y;
+    }
+    return GPU_MakeRect(min_x, min_y, max_x - min_x, max_y - min_y);
+}
+
 // All shapes start this way for setup and so they can access the blit buffer properly
-#define BEGIN_UNTEXTURED(function_name, shape, num_additional_vertices, num_additional_indices) \
+// The bounds are only evaluated when culling is enabled.
+#define BEGIN_UNTEXTURED(function_name, shape, num_additional_vertices, num_additional_indices, bounds) \
 	GPU_CONTEXT_DATA* cdata; \
 	float* blit_buffer; \
-	unsigned short* index_buffer; \
 	int vert_index; \
 	int color_index; \
 	float r, g, b, a; \
-	unsigned short blit_buffer_starting_index; \
+	unsigned int blit_buffer_starting_index; \
     if(target == NULL) \
     { \
         GPU_PushErrorCode(function_name, GPU_ERROR_NULL_ARGUMENT, "target"); \
@@ -42,6 +98,13 @@ See a particular renderer's *.c file for specifics. */
         return; \
     } \
      \
+    if(((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->use_culling) \
+    { \
+        GPU_Rect culling_bounds = (bounds); \
+        if(isCulled(renderer, target, culling_bounds.x, culling_bounds.y, culling_bounds.x + culling_bounds.w, culling_bounds.y + culling_bounds.h)) \
+            return; \
+    } \
+     \
     if(!bindFramebuffer(renderer, target)) \
     { \
         GPU_PushErrorCode(function_name, GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer."); \
@@ -56,19 +119,20 @@ See a particular renderer's *.c file for specifics. */
     if(cdata->blit_buffer_num_vertices + (num_additional_vertices) >= cdata->blit_buffer_max_num_vertices) \
     { \
         if(!growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + (num_additional_vertices))) \
-            renderer->impl->FlushBlitBuffer(renderer); \
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL); \
     } \
-    if(cdata->index_buffer_num_vertices + (num_additional_indices) >= cdata->index_buffer_max_num_vertices) \
+    if(cdata->shapes_use_white_texel) \
+        useIndexBufferForSprites(renderer, cdata, (num_additional_indices)); \
+    else if(cdata->index_buffer_num_vertices + (num_additional_indices) >= cdata->index_buffer_max_num_vertices) \
     { \
         if(!growIndexBuffer(cdata, cdata->index_buffer_num_vertices + (num_additional_indices))) \
-            renderer->impl->FlushBlitBuffer(renderer); \
+            flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_BUFFER_FULL); \
     } \
      \
     blit_buffer = cdata->blit_buffer; \
-    index_buffer = cdata->index_buffer; \
      \
-    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
-    color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
+    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex; \
+    color_index = cdata->blit_buffer_color_offset + cdata->blit_buffer_num_vertices*cdata->blit_buffer_floats_per_vertex; \
      \
     if(target->use_color) \
     { \
@@ -100,7 +164,7 @@ static float SetLineThickness(GPU_Renderer* renderer, float thickness)
     
 	old = renderer->current_context_target->context->line_thickness;
 	if(old != thickness)
-        renderer->impl->FlushBlitBuffer(renderer);
+        flushBlitBufferFor(renderer, GPU_FLUSH_CAUSE_STATE);
     
 	renderer->current_context_target->context->line_thickness = thickness;
 	#ifndef SDL_GPU_SKIP_LINE_WIDTH
@@ -116,7 +180,7 @@ static float GetLineThickness(GPU_Renderer* renderer)
 
 static void Pixel(GPU_Renderer* renderer, GPU_Target* target, float x, float y, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_Pixel", GL_POINTS, 1, 1);
+    BEGIN_UNTEXTURED("GPU_Pixel", GL_POINTS, 1, 1, GPU_MakeRect(x, y, 0.0f, 0.0f));
     
     SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);
 }
@@ -130,7 +194,7 @@ static void Line(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1,
     float tc = t*cosf(line_angle);
     float ts = t*sinf(line_angle);
 
-    BEGIN_UNTEXTURED("GPU_Line", GL_TRIANGLES, 4, 6);
+    BEGIN_UNTEXTURED("GPU_Line", GL_TRIANGLES, 4, 6, makeShapeBounds(x1, y1, x2, y2, t));
     
     SET_UNTEXTURED_VERTEX(x1 + ts, y1 - tc, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x1 - ts, y1 + tc, r, g, b, a);
@@ -198,7 +262,7 @@ static void Arc(GPU_Renderer* renderer, GPU_Target* target, float x, float y, fl
 		return;
     
 	{
-		BEGIN_UNTEXTURED("GPU_Arc", GL_TRIANGLES, 2*(numSegments), 6*(numSegments));
+		BEGIN_UNTEXTURED("GPU_Arc", GL_TRIANGLES, 2*(numSegments), 6*(numSegments), makeShapeBounds(x, y, x, y, outer_radius));
 		
         c = cos(dt);
         s = sin(dt);
@@ -278,7 +342,7 @@ static void ArcFilled(GPU_Renderer* renderer, GPU_Target* target, float x, float
 		return;
 
 	{
-		BEGIN_UNTEXTURED("GPU_ArcFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3);
+		BEGIN_UNTEXTURED("GPU_ArcFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3, makeShapeBounds(x, y, x, y, radius));
         
         c = cos(dt);
         s = sin(dt);
@@ -340,7 +404,7 @@ static void Circle(GPU_Renderer* renderer, GPU_Target* target, float x, float y,
     float c = cos(dt);
     float s = sin(dt);
     
-    BEGIN_UNTEXTURED("GPU_Circle", GL_TRIANGLES, 2*(numSegments), 6*(numSegments));
+    BEGIN_UNTEXTURED("GPU_Circle", GL_TRIANGLES, 2*(numSegments), 6*(numSegments), makeShapeBounds(x, y, x, y, outer_radius));
     
     if(inner_radius < 0.0f)
         inner_radius = 0.0f;
@@ -373,7 +437,7 @@ static void CircleFilled(GPU_Renderer* renderer, GPU_Target* target, float x, fl
     float c = cos(dt);
     float s = sin(dt);
     
-    BEGIN_UNTEXTURED("GPU_CircleFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3);
+    BEGIN_UNTEXTURED("GPU_CircleFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3, makeShapeBounds(x, y, x, y, radius));
     
     // First triangle
     SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);  // Center
@@ -423,7 +487,7 @@ static void Ellipse(GPU_Renderer* renderer, GPU_Target* target, float x, float y
     float inner_trans_x, inner_trans_y;
     float outer_trans_x, outer_trans_y;
     
-    BEGIN_UNTEXTURED("GPU_Ellipse", GL_TRIANGLES, 2*(numSegments), 6*(numSegments));
+    BEGIN_UNTEXTURED("GPU_Ellipse", GL_TRIANGLES, 2*(numSegments), 6*(numSegments), makeShapeBounds(x, y, x, y, (outer_radius_x > outer_radius_y? outer_radius_x : outer_radius_y)));
     
     if(inner_radius_x < 0.0f)
         inner_radius_x = 0.0f;
@@ -469,7 +533,7 @@ static void EllipseFilled(GPU_Renderer* renderer, GPU_Target* target, float x, f
     float s = sin(dt);
     float trans_x, trans_y;
     
-    BEGIN_UNTEXTURED("GPU_EllipseFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3);
+    BEGIN_UNTEXTURED("GPU_EllipseFilled", GL_TRIANGLES, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3, makeShapeBounds(x, y, x, y, (fabsf(rx) > fabsf(ry)? rx : ry)));
     
     // First triangle
     SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);  // Center
@@ -614,7 +678,7 @@ static void SectorFilled(GPU_Renderer* renderer, GPU_Target* target, float x, fl
 	{
 		int i;
 		Uint8 use_inner;
-		BEGIN_UNTEXTURED("GPU_SectorFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3);
+		BEGIN_UNTEXTURED("GPU_SectorFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3, makeShapeBounds(x, y, x, y, outer_radius));
 
 		use_inner = 0;  // Switches between the radii for the next point
 
@@ -687,7 +751,7 @@ static void SectorFilled(GPU_Renderer* renderer, GPU_Target* target, float x, fl
 
 static void Tri(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_Tri", GL_LINES, 3, 6);
+    BEGIN_UNTEXTURED("GPU_Tri", GL_LINES, 3, 6, makeTriangleBounds(x1, y1, x2, y2, x3, y3));
     
     SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a);
@@ -701,7 +765,7 @@ static void Tri(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1,
 
 static void TriFilled(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1, float x2, float y2, float x3, float y3, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_TriFilled", GL_TRIANGLES, 3, 3);
+    BEGIN_UNTEXTURED("GPU_TriFilled", GL_TRIANGLES, 3, 3, makeTriangleBounds(x1, y1, x2, y2, x3, y3));
     
     SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a);
@@ -733,7 +797,7 @@ static void Rectangle(GPU_Renderer* renderer, GPU_Target* target, float x1, floa
 
 		// Thick lines via filled triangles
 
-		BEGIN_UNTEXTURED("GPU_Rectangle", GL_TRIANGLES, 12, 24);
+		BEGIN_UNTEXTURED("GPU_Rectangle", GL_TRIANGLES, 12, 24, makeShapeBounds(x1, y1, x2, y2, outer));
 		
 		// Adjust inner thickness offsets to avoid overdraw on narrow/small rects
 		if(x1 + inner_x > x2 - inner_x)
@@ -778,7 +842,7 @@ static void Rectangle(GPU_Renderer* renderer, GPU_Target* target, float x1, floa
 
 static void RectangleFilled(GPU_Renderer* renderer, GPU_Target* target, float x1, float y1, float x2, float y2, SDL_Color color)
 {
-    BEGIN_UNTEXTURED("GPU_RectangleFilled", GL_TRIANGLES, 4, 6);
+    BEGIN_UNTEXTURED("GPU_RectangleFilled", GL_TRIANGLES, 4, 6, makeShapeBounds(x1, y1, x2, y2, 0.0f));
 
     SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a);
     SET_UNTEXTURED_VERTEX(x1, y2, r, g, b, a);
@@ -848,7 +912,7 @@ static void RectangleRound(GPU_Renderer* renderer, GPU_Target* target, float x1,
             float s = sin(dt);
             
             // Add another 4 for the extra corner vertices
-            BEGIN_UNTEXTURED("GPU_RectangleRound", GL_TRIANGLES, 2*(numSegments + 4), 6*(numSegments + 4));
+            BEGIN_UNTEXTURED("GPU_RectangleRound", GL_TRIANGLES, 2*(numSegments + 4), 6*(numSegments + 4), makeShapeBounds(x1, y1, x2, y2, outer_radius));
             
             if(inner_radius < 0.0f)
                 inner_radius = 0.0f;
@@ -939,7 +1003,7 @@ static void RectangleRoundFilled(GPU_Renderer* renderer, GPU_Target* target, flo
 		int last_index = 2;
 		int i;
 
-		BEGIN_UNTEXTURED("GPU_RectangleRoundFilled", GL_TRIANGLES, 6 + 4 * (verts_per_corner - 1) - 1, 15 + 4 * (verts_per_corner - 1) * 3 - 3);
+		BEGIN_UNTEXTURED("GPU_RectangleRoundFilled", GL_TRIANGLES, 6 + 4 * (verts_per_corner - 1) - 1, 15 + 4 * (verts_per_corner - 1) * 3 - 3, makeShapeBounds(x1, y1, x2, y2, 0.0f));
 
 
 		// First triangle
@@ -1007,7 +1071,7 @@ static void Polygon(GPU_Renderer* renderer, GPU_Target* target, unsigned int num
 		int last_index = 0;
 		int i;
 
-		BEGIN_UNTEXTURED("GPU_Polygon", GL_LINES, num_vertices, numSegments);
+		BEGIN_UNTEXTURED("GPU_Polygon", GL_LINES, num_vertices, numSegments, makePolygonBounds(num_vertices, vertices));
 
 		SET_UNTEXTURED_VERTEX(vertices[0], vertices[1], r, g, b, a);
 		for (i = 2; i < numSegments; i += 2)
@@ -1029,7 +1093,7 @@ static void PolygonFilled(GPU_Renderer* renderer, GPU_Target* target, unsigned i
 		int numSegments = 2 * num_vertices;
 
 		// Using a fan of triangles assumes that the polygon is convex
-		BEGIN_UNTEXTURED("GPU_PolygonFilled", GL_TRIANGLES, num_vertices, 3 + (num_vertices - 3) * 3);
+		BEGIN_UNTEXTURED("GPU_PolygonFilled", GL_TRIANGLES, num_vertices, 3 + (num_vertices - 3) * 3, makePolygonBounds(num_vertices, vertices));
 
 		// First triangle
 		SET_UNTEXTURED_VERTEX(vertices[0], vertices[1], r, g, b, a);
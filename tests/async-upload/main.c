@@ -0,0 +1,138 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+#define FRAME_W 1920
+#define FRAME_H 1080
+
+enum
+{
+    UPLOAD_SYNC,
+    UPLOAD_ASYNC,
+    UPLOAD_LOCK,
+    NUM_UPLOAD_MODES
+};
+
+static const char* mode_names[NUM_UPLOAD_MODES] = {"GPU_UpdateImageBytes", "GPU_UpdateImageBytesAsync", "GPU_LockImageBytes"};
+
+
+// Stands in for a decoded video frame
+static void fill_frame(unsigned char* pixels, int bytes_per_row, int frame)
+{
+    int x, y;
+    for(y = 0; y < FRAME_H; y++)
+    {
+        unsigned char* p = pixels + y*bytes_per_row;
+        for(x = 0; x < FRAME_W; x++)
+        {
+            p[0] = (Uint8)(x + frame);
+            p[1] = (Uint8)(y + frame);
+            p[2] = (Uint8)(x + y);
+            p[3] = 255;
+            p += 4;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+	GPU_SetPreInitFlags(GPU_INIT_DISABLE_VSYNC);
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* image;
+        unsigned char* frame_pixels;
+        int mode;
+
+        image = GPU_CreateImage(FRAME_W, FRAME_H, GPU_FORMAT_RGBA);
+        if(image == NULL)
+            return -1;
+
+        frame_pixels = (unsigned char*)malloc(FRAME_W*FRAME_H*4);
+
+        mode = UPLOAD_ASYNC;
+        GPU_LogError("Press SPACE to switch the upload method.\nUsing %s\n", mode_names[mode]);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                    {
+                        mode = (mode + 1) % NUM_UPLOAD_MODES;
+                        GPU_LogError("Using %s\n", mode_names[mode]);
+                        frameCount = 0;
+                        startTime = SDL_GetTicks();
+                    }
+                }
+            }
+
+            // Locking writes the frame straight into the staging buffer, the others copy it from client memory
+            if(mode == UPLOAD_LOCK)
+            {
+                int bytes_per_row;
+                unsigned char* pixels;
+
+                pixels = GPU_LockImageBytes(image, NULL, &bytes_per_row);
+                if(pixels != NULL)
+                {
+                    fill_frame(pixels, bytes_per_row, frameCount);
+                    GPU_UnlockImageBytes(image);
+                }
+            }
+            else
+            {
+                fill_frame(frame_pixels, FRAME_W*4, frameCount);
+
+                if(mode == UPLOAD_ASYNC)
+                    GPU_UpdateImageBytesAsync(image, NULL, frame_pixels, FRAME_W*4);
+                else
+                    GPU_UpdateImageBytes(image, NULL, frame_pixels, FRAME_W*4);
+            }
+
+            GPU_Clear(screen);
+            GPU_BlitScale(image, NULL, screen, screen->w/2, screen->h/2, screen->w/(float)FRAME_W, screen->h/(float)FRAME_H);
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(SDL_GetTicks() - startTime > 5000)
+            {
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+                frameCount = 0;
+                startTime = SDL_GetTicks();
+            }
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        free(frame_pixels);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
+
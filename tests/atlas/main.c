@@ -0,0 +1,134 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+#define NUM_SOURCES 3
+
+static const char* source_files[NUM_SOURCES] = {"data/small_test.png", "data/happy_50x50.bmp", "data/happy_52x63.bmp"};
+
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+	GPU_SetPreInitFlags(GPU_INIT_DISABLE_VSYNC);
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        int numSprites = 2000;
+        float* x = (float*)malloc(sizeof(float)*numSprites);
+        float* y = (float*)malloc(sizeof(float)*numSprites);
+        int i;
+
+        GPU_Atlas* atlas;
+        GPU_Image* images[NUM_SOURCES];
+        GPU_Image* entries[NUM_SOURCES];
+        GPU_Image** current;
+        GPU_FrameStats stats;
+
+        // One page is plenty for these, and 1 pixel of extrusion keeps linear filtering from bleeding between them
+        atlas = GPU_CreateAtlas(256, 256, 1, 1);
+        for(i = 0; i < NUM_SOURCES; i++)
+        {
+            SDL_Surface* surface = GPU_LoadSurface(source_files[i]);
+            if(surface == NULL)
+                return -1;
+
+            images[i] = GPU_CopyImageFromSurface(surface);
+            entries[i] = GPU_AddToAtlas(atlas, surface);
+            SDL_FreeSurface(surface);
+            if(images[i] == NULL || entries[i] == NULL)
+                return -1;
+        }
+        GPU_LogError("Atlas: %d page(s) for %d images\n", atlas->num_pages, NUM_SOURCES);
+
+        // Removing one and defragmenting should keep the others drawing the same
+        GPU_RemoveFromAtlas(atlas, entries[0]);
+        {
+            SDL_Surface* surface = GPU_LoadSurface(source_files[0]);
+            entries[0] = GPU_AddToAtlas(atlas, surface);
+            SDL_FreeSurface(surface);
+        }
+        if(!GPU_DefragmentAtlas(atlas))
+            GPU_LogError("Failed to defragment the atlas.\n");
+
+        for(i = 0; i < numSprites; i++)
+        {
+            x[i] = rand()%screen->w;
+            y[i] = rand()%screen->h;
+        }
+
+        current = entries;
+        GPU_LogError("Press SPACE to switch between atlas entries and separate images.\n");
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+        GPU_ResetFrameStats();
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                    {
+                        current = (current == entries? images : entries);
+                        GPU_LogError("Drawing %s\n", (current == entries? "atlas entries" : "separate images"));
+                        frameCount = 0;
+                        startTime = SDL_GetTicks();
+                        GPU_ResetFrameStats();
+                    }
+                }
+            }
+
+            GPU_Clear(screen);
+
+            // Interleaved images, which needs a texture change per sprite unless they share a page
+            for(i = 0; i < numSprites; i++)
+            {
+                GPU_Blit(current[i%NUM_SOURCES], NULL, screen, x[i], y[i]);
+            }
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(SDL_GetTicks() - startTime > 5000)
+            {
+                stats = GPU_GetFrameStats();
+                printf("Average FPS: %.2f, %u draw calls/frame, %u texture binds/frame\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime), (unsigned int)(stats.draw_calls/frameCount), (unsigned int)(stats.texture_binds/frameCount));
+                frameCount = 0;
+                startTime = SDL_GetTicks();
+                GPU_ResetFrameStats();
+            }
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        free(x);
+        free(y);
+
+        for(i = 0; i < NUM_SOURCES; i++)
+            GPU_FreeImage(images[i]);
+        GPU_FreeAtlas(atlas);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,129 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+#define IMAGE_SIZE 256
+
+
+// Builds a BC1 mip chain of solid color blocks, a different color per level so the selected mip level is visible
+static unsigned char* create_bc1_levels(int* num_levels, const unsigned char** levels)
+{
+    static const Uint16 colors[] = {0xF800, 0x07E0, 0x001F, 0xFFE0, 0xF81F, 0x07FF, 0xFFFF, 0x0000, 0x8410};
+    unsigned char* data;
+    unsigned char* p;
+    int size, level, i, total;
+
+    total = 0;
+    for(size = IMAGE_SIZE; size > 0; size /= 2)
+        total += ((size + 3)/4)*((size + 3)/4)*8;
+
+    data = (unsigned char*)malloc(total);
+    p = data;
+    level = 0;
+    for(size = IMAGE_SIZE; size > 0; size /= 2)
+    {
+        int num_blocks = ((size + 3)/4)*((size + 3)/4);
+        Uint16 c = colors[level%9];
+
+        levels[level] = p;
+        for(i = 0; i < num_blocks; i++)
+        {
+            // Checker the blocks between the level color and black so that filtering shows up too
+            Uint16 color = ((i + i/((size + 3)/4))%2 == 0? c : 0x0000);
+            p[0] = color & 0xFF;
+            p[1] = color >> 8;
+            p[2] = color & 0xFF;
+            p[3] = color >> 8;
+            p[4] = p[5] = p[6] = p[7] = 0;
+            p += 8;
+        }
+        level++;
+    }
+
+    *num_levels = level;
+    return data;
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* image;
+        const unsigned char* levels[16];
+        unsigned char* data;
+        int num_levels;
+        float scale = 1.0f;
+
+        GPU_LogError("BCn support: %s\n", (GPU_IsFeatureEnabled(GPU_FEATURE_COMPRESSED_BC)? "yes" : "no (decompressed on load)"));
+        GPU_LogError("ETC2 support: %s\n", (GPU_IsFeatureEnabled(GPU_FEATURE_COMPRESSED_ETC2)? "yes" : "no (decompressed on load)"));
+
+        // A .dds or .ktx file can be given on the command line, otherwise a generated BC1 image is used
+        if(argc > 1)
+            image = GPU_LoadImage(argv[1]);
+        else
+        {
+            data = create_bc1_levels(&num_levels, levels);
+            image = GPU_CreateImageFromCompressedData(IMAGE_SIZE, IMAGE_SIZE, GPU_FORMAT_BC1, num_levels, levels);
+            free(data);
+        }
+        if(image == NULL)
+            return -1;
+
+        GPU_SetImageFilter(image, GPU_FILTER_LINEAR_MIPMAP);
+        GPU_LogError("Use the UP and DOWN keys to scale the image through its mipmap levels.\n");
+
+		startTime = SDL_GetTicks();
+		frameCount = 0;
+
+		done = 0;
+		while(!done)
+		{
+			while(SDL_PollEvent(&event))
+			{
+				if(event.type == SDL_QUIT)
+					done = 1;
+				else if(event.type == SDL_KEYDOWN)
+				{
+					if(event.key.keysym.sym == SDLK_ESCAPE)
+						done = 1;
+					else if(event.key.keysym.sym == SDLK_UP)
+						scale *= 1.25f;
+					else if(event.key.keysym.sym == SDLK_DOWN)
+						scale /= 1.25f;
+				}
+			}
+
+			GPU_Clear(screen);
+
+			GPU_BlitScale(image, NULL, screen, screen->w/2, screen->h/2, scale, scale);
+
+			GPU_Flip(screen);
+
+			frameCount++;
+			if(frameCount%500 == 0)
+				printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+		}
+
+		printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+		GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
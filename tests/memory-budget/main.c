@@ -0,0 +1,128 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+#define NUM_IMAGES 64
+#define IMAGE_SIZE 500
+
+
+static void printMemoryStats(void)
+{
+    GPU_MemoryStats stats = GPU_GetMemoryStats();
+    printf("Texture memory: %.1f MB (images %.1f MB, targets %.1f MB, pool %.1f MB, padding %.1f MB), budget %.1f MB\n",
+           stats.total_bytes/1048576.0, stats.image_bytes/1048576.0, stats.target_bytes/1048576.0, stats.pool_bytes/1048576.0, stats.padding_bytes/1048576.0, stats.budget_bytes/1048576.0);
+    printf("  %u images, %u evicted (%.1f MB in client memory), %u evictions, %u restores\n",
+           stats.num_images, stats.num_evicted_images, stats.evicted_bytes/1048576.0, stats.evictions, stats.restores);
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* images[NUM_IMAGES];
+        unsigned char* pixels;
+        int i, x, y;
+        int num_visible = 8;
+        int first = 0;
+
+        // Stands in for a big content library: many large images, of which only a few are shown at a time
+        pixels = (unsigned char*)malloc(IMAGE_SIZE*IMAGE_SIZE*4);
+        for(i = 0; i < NUM_IMAGES; i++)
+        {
+            images[i] = GPU_CreateImage(IMAGE_SIZE, IMAGE_SIZE, GPU_FORMAT_RGBA);
+            if(images[i] == NULL)
+                return -1;
+
+            for(y = 0; y < IMAGE_SIZE; y++)
+            {
+                for(x = 0; x < IMAGE_SIZE; x++)
+                {
+                    unsigned char* p = pixels + 4*(y*IMAGE_SIZE + x);
+                    p[0] = (Uint8)(i*40 + x);
+                    p[1] = (Uint8)(i*90 + y);
+                    p[2] = (Uint8)(i*20);
+                    p[3] = 255;
+                }
+            }
+            GPU_UpdateImageBytes(images[i], NULL, pixels, IMAGE_SIZE*4);
+        }
+        free(pixels);
+
+        GPU_LogError("Each image takes %.1f MB.\n", GPU_GetImageMemoryUsage(images[0])/1048576.0);
+        printMemoryStats();
+
+        // Room for a bit more than the visible images, so the rest get evicted as the view moves along
+        GPU_SetMemoryBudget((num_visible + 2)*GPU_GetImageMemoryUsage(images[0]));
+        printMemoryStats();
+
+        GPU_LogError("Use the LEFT and RIGHT keys to scroll through the images.  Press SPACE to toggle the budget.\n");
+
+		startTime = SDL_GetTicks();
+		frameCount = 0;
+
+		done = 0;
+		while(!done)
+		{
+			while(SDL_PollEvent(&event))
+			{
+				if(event.type == SDL_QUIT)
+					done = 1;
+				else if(event.type == SDL_KEYDOWN)
+				{
+					if(event.key.keysym.sym == SDLK_ESCAPE)
+						done = 1;
+					else if(event.key.keysym.sym == SDLK_RIGHT)
+						first = (first + 1)%NUM_IMAGES;
+					else if(event.key.keysym.sym == SDLK_LEFT)
+						first = (first + NUM_IMAGES - 1)%NUM_IMAGES;
+					else if(event.key.keysym.sym == SDLK_SPACE)
+					{
+						GPU_SetMemoryBudget(GPU_GetMemoryBudget() == 0? (num_visible + 2)*GPU_GetImageMemoryUsage(images[0]) : 0);
+						printMemoryStats();
+					}
+				}
+			}
+
+			GPU_Clear(screen);
+
+			for(i = 0; i < num_visible; i++)
+			{
+				GPU_BlitScale(images[(first + i)%NUM_IMAGES], NULL, screen, 100 + (i%4)*200, 150 + (i/4)*300, 0.35f, 0.35f);
+			}
+
+			GPU_Flip(screen);
+
+			frameCount++;
+			if(SDL_GetTicks() - startTime > 5000)
+			{
+				printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+				printMemoryStats();
+				frameCount = 0;
+				startTime = SDL_GetTicks();
+			}
+		}
+
+		printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+		for(i = 0; i < NUM_IMAGES; i++)
+			GPU_FreeImage(images[i]);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
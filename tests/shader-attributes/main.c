@@ -124,6 +124,8 @@ int main(int argc, char* argv[])
         float colors[4*4*MAX_SPRITES];
         float expanded_colors[4*MAX_SPRITES];
         float src_rects[4*MAX_SPRITES];
+        float tint_colors[4*3] = {1.0f, 0.5f, 0.5f, 1.0f,  0.5f, 1.0f, 0.5f, 1.0f,  0.5f, 0.5f, 1.0f, 1.0f};
+        GPU_Attribute tint_attr;
         Uint32 v, f, p;
         GPU_ShaderBlock block;
         Uint8 shader_index;
@@ -272,6 +274,15 @@ int main(int argc, char* argv[])
             
             set_shader(0, NULL);
             
+            // Per-sprite colors for the default shader's gpu_Color, which replace the colors in the blit buffer
+            tint_attr = color_attr;
+            tint_attr.format.is_per_sprite = 1;
+            tint_attr.values = tint_colors;
+            GPU_SetAttributeSource(3, tint_attr);
+            for(i = 0; i < 3; i++)
+                GPU_Blit(image, NULL, screen, 650, 200 + 75*i);
+            GPU_FlushBlitBuffer();
+            
             GPU_BlitScale(image, NULL, screen, 75, 75, 3.0f, 3.0f);
             GPU_Rectangle(screen, 3*src_rect.x, 3*src_rect.y, 3*(src_rect.x + src_rect.w), 3*(src_rect.y + src_rect.h), red);
             GPU_CircleFilled(screen, 3*src_rect.x, 3*src_rect.y, 4, blue);
@@ -0,0 +1,134 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+	GPU_SetPreInitFlags(GPU_INIT_DISABLE_VSYNC);
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+	
+	printCurrentRenderer();
+	
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+		
+        int maxSprites = 20000;
+        int numSprites = 1000;
+        
+        float* x = (float*)malloc(sizeof(float)*maxSprites);
+        float* y = (float*)malloc(sizeof(float)*maxSprites);
+        int i;
+        
+        GPU_Image* images[3];
+        GPU_BatchModeEnum mode = GPU_BATCH_MODE_SORTED;
+        
+        images[0] = GPU_LoadImage("data/small_test.png");
+        images[1] = GPU_LoadImage("data/test3.png");
+        images[2] = GPU_LoadImage("data/small_test.png");
+        if(images[0] == NULL || images[1] == NULL || images[2] == NULL)
+            return -1;
+        
+        GPU_SetBlendMode(images[2], GPU_BLEND_ADD);
+        
+        for(i = 0; i < maxSprites; i++)
+        {
+            x[i] = rand()%screen->w;
+            y[i] = rand()%screen->h;
+        }
+        
+        GPU_LogError("Press SPACE to switch between sorted and immediate batching.\n");
+        GPU_SetBatchMode(mode);
+        
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+        
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                    {
+                        mode = (mode == GPU_BATCH_MODE_SORTED? GPU_BATCH_MODE_IMMEDIATE : GPU_BATCH_MODE_SORTED);
+                        GPU_SetBatchMode(mode);
+                        GPU_LogError("Batch mode: %s\n", (mode == GPU_BATCH_MODE_SORTED? "sorted" : "immediate"));
+                        frameCount = 0;
+                        startTime = SDL_GetTicks();
+                    }
+                    else if(event.key.keysym.sym == SDLK_EQUALS || event.key.keysym.sym == SDLK_PLUS)
+                    {
+                        if(numSprites < maxSprites)
+                            numSprites += 500;
+                        GPU_LogError("Sprites: %d\n", numSprites);
+                        frameCount = 0;
+                        startTime = SDL_GetTicks();
+                    }
+                    else if(event.key.keysym.sym == SDLK_MINUS)
+                    {
+                        if(numSprites > 500)
+                            numSprites -= 500;
+                        GPU_LogError("Sprites: %d\n", numSprites);
+                        frameCount = 0;
+                        startTime = SDL_GetTicks();
+                    }
+                }
+            }
+            
+            GPU_Clear(screen);
+            
+            // World: interleaved textures, which forces a flush per sprite in immediate mode
+            GPU_SetBatchLayer(0);
+            for(i = 0; i < numSprites; i++)
+            {
+                GPU_BlitRotate(images[i%2], NULL, screen, x[i], y[i], (i*7)%360);
+            }
+            
+            // UI: additive highlights that have to stay on top of the world
+            GPU_SetBatchLayer(1);
+            for(i = 0; i < numSprites/10; i++)
+            {
+                GPU_Blit(images[2], NULL, screen, x[i], y[i]);
+                GPU_Blit(images[0], NULL, screen, screen->w - x[i], y[i]);
+            }
+            
+            GPU_Flip(screen);
+            
+            frameCount++;
+            if(SDL_GetTicks() - startTime > 5000)
+            {
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+                frameCount = 0;
+                startTime = SDL_GetTicks();
+            }
+        }
+        
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        
+        free(x);
+        free(y);
+        
+        for(i = 0; i < 3; i++)
+            GPU_FreeImage(images[i]);
+	}
+	
+	GPU_Quit();
+	
+	return 0;
+}
+
+
@@ -0,0 +1,156 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <math.h>
+
+
+#define GRID_W 64
+#define GRID_H 48
+
+// Fills one textured, colored quad (4 vertices of x, y, s, t, r, g, b, a)
+static void fill_quad(float* values, float x, float y, float size, float r, float g, float b)
+{
+    float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    int i;
+    for(i = 0; i < 4; i++)
+    {
+        float* v = values + i*8;
+        v[0] = x + corners[i][0]*size;
+        v[1] = y + corners[i][1]*size;
+        v[2] = corners[i][0];
+        v[3] = corners[i][1];
+        v[4] = r;
+        v[5] = g;
+        v[6] = b;
+        v[7] = 1.0f;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+	GPU_SetPreInitFlags(GPU_INIT_DISABLE_VSYNC);
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+	
+	printCurrentRenderer();
+	
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+		
+        GPU_Image* image;
+        GPU_VertexBuffer* buffer;
+        GPU_Camera camera;
+        float* values;
+        unsigned short* indices;
+        float quad[4*8];
+        float size = 12.0f;
+        int num_quads = GRID_W*GRID_H;
+        int i, j;
+        
+        image = GPU_LoadImage("data/small_test.png");
+        if(image == NULL)
+            return -1;
+        
+        values = (float*)malloc(sizeof(float)*8*4*num_quads);
+        indices = (unsigned short*)malloc(sizeof(unsigned short)*6*num_quads);
+        for(j = 0; j < GRID_H; j++)
+        {
+            for(i = 0; i < GRID_W; i++)
+            {
+                int n = j*GRID_W + i;
+                fill_quad(values + n*4*8, i*size, j*size, size - 1, i/(float)GRID_W, j/(float)GRID_H, 0.5f);
+                
+                indices[n*6] = n*4;
+                indices[n*6 + 1] = n*4 + 1;
+                indices[n*6 + 2] = n*4 + 2;
+                indices[n*6 + 3] = n*4;
+                indices[n*6 + 4] = n*4 + 2;
+                indices[n*6 + 5] = n*4 + 3;
+            }
+        }
+        
+        // The grid is uploaded once and never rebuilt
+        buffer = GPU_CreateVertexBuffer(4*num_quads, values, 6*num_quads, indices, GPU_BATCH_XY_ST_RGBA);
+        free(values);
+        free(indices);
+        if(buffer == NULL)
+            return -1;
+        
+        camera = GPU_GetDefaultCamera();
+        
+        GPU_LogError("Use the arrow keys to move the camera.\n");
+        
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+        
+        done = 0;
+        while(!done)
+        {
+            const Uint8* keystates;
+            float t;
+            
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                }
+            }
+            
+            keystates = SDL_GetKeyboardState(NULL);
+            if(keystates[SDL_SCANCODE_LEFT])
+                camera.x -= 2;
+            if(keystates[SDL_SCANCODE_RIGHT])
+                camera.x += 2;
+            if(keystates[SDL_SCANCODE_UP])
+                camera.y -= 2;
+            if(keystates[SDL_SCANCODE_DOWN])
+                camera.y += 2;
+            
+            // Only one quad changes per frame, so only its vertices are uploaded
+            t = SDL_GetTicks()/1000.0f;
+            i = (int)(t*10) % num_quads;
+            fill_quad(quad, (i%GRID_W)*size, (i/GRID_W)*size, size - 1, 1.0f, 1.0f, 0.5f + 0.5f*sinf(t*5));
+            GPU_UpdateVertexBuffer(buffer, i*4, 4, quad);
+            
+            GPU_Clear(screen);
+            
+            GPU_SetCamera(screen, &camera);
+            GPU_DrawVertexBuffer(image, screen, buffer);
+            
+            GPU_SetCamera(screen, NULL);
+            GPU_Blit(image, NULL, screen, screen->w - image->w/2, image->h/2);
+            
+            GPU_Flip(screen);
+            
+            frameCount++;
+            if(SDL_GetTicks() - startTime > 5000)
+            {
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+                frameCount = 0;
+                startTime = SDL_GetTicks();
+            }
+        }
+        
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        
+        GPU_FreeVertexBuffer(buffer);
+        GPU_FreeImage(image);
+	}
+	
+	GPU_Quit();
+	
+	return 0;
+}
+
+
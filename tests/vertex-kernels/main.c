@@ -0,0 +1,187 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Runs on the CPU only, so no window or GL context is created.
+
+#define NUM_SPRITES 10000
+#define NUM_REPEATS 200
+#define NUM_ANGLES 1000000
+
+typedef struct Sprite
+{
+    float dx1, dy1, dx2, dy2;
+    float x, y;
+    float sin_angle, cos_angle;
+    float s1, t1, s2, t2;
+    float r, g, b, a;
+} Sprite;
+
+static float random_float(float low, float high)
+{
+    return low + (high - low)*(rand()/(float)RAND_MAX);
+}
+
+static const char* get_simd_name(GPU_SIMDEnum simd)
+{
+    switch(simd)
+    {
+    case GPU_SIMD_SSE2:
+        return "SSE2";
+    case GPU_SIMD_NEON:
+        return "NEON";
+    default:
+        return "scalar";
+    }
+}
+
+static double make_vertices(Sprite* sprites, float* result, int floats_per_vertex)
+{
+    clock_t start = clock();
+    int n, i;
+    for(n = 0; n < NUM_REPEATS; n++)
+    {
+        float* v = result;
+        for(i = 0; i < NUM_SPRITES; i++)
+        {
+            Sprite* s = &sprites[i];
+            GPU_MakeSpriteVertices(v, floats_per_vertex, s->dx1, s->dy1, s->dx2, s->dy2, s->x, s->y, s->sin_angle, s->cos_angle, s->s1, s->t1, s->s2, s->t2, s->r, s->g, s->b, s->a);
+            v += 4*floats_per_vertex;
+        }
+    }
+    return (clock() - start)*1000.0/CLOCKS_PER_SEC;
+}
+
+int main(int argc, char* argv[])
+{
+    Sprite* sprites;
+    float* expected;
+    float* result;
+    GPU_SIMDEnum default_simd;
+    GPU_SIMDEnum simd_sets[2] = {GPU_SIMD_SSE2, GPU_SIMD_NEON};
+    double scalar_ms;
+    double libm_ms, sincos_ms;
+    double max_sincos_error;
+    volatile float sink;
+    clock_t start;
+    int floats_per_vertex;
+    int failed = 0;
+    int i, j;
+
+    (void)argc;
+    (void)argv;
+
+    sprites = (Sprite*)malloc(sizeof(Sprite)*NUM_SPRITES);
+    for(i = 0; i < NUM_SPRITES; i++)
+    {
+        Sprite* s = &sprites[i];
+        s->dx1 = random_float(-64, 0);
+        s->dy1 = random_float(-64, 0);
+        s->dx2 = random_float(0, 64);
+        s->dy2 = random_float(0, 64);
+        s->x = random_float(0, 1920);
+        s->y = random_float(0, 1080);
+        GPU_SinCos((i%4 == 0? 0.0f : random_float(-20, 20)), &s->sin_angle, &s->cos_angle);
+        s->s1 = random_float(0, 0.5f);
+        s->t1 = random_float(0, 0.5f);
+        s->s2 = random_float(0.5f, 1);
+        s->t2 = random_float(0.5f, 1);
+        s->r = random_float(0, 1);
+        s->g = random_float(0, 1);
+        s->b = random_float(0, 1);
+        s->a = random_float(0, 1);
+    }
+
+    // GPU_SinCos() against double precision
+    max_sincos_error = 0.0;
+    for(i = 0; i < NUM_ANGLES; i++)
+    {
+        float angle = -100.0f + 200.0f*i/NUM_ANGLES;
+        float s, c;
+        GPU_SinCos(angle, &s, &c);
+        if(fabs(s - sin(angle)) > max_sincos_error)
+            max_sincos_error = fabs(s - sin(angle));
+        if(fabs(c - cos(angle)) > max_sincos_error)
+            max_sincos_error = fabs(c - cos(angle));
+    }
+    printf("GPU_SinCos max error: %g\n", max_sincos_error);
+    if(max_sincos_error > 1e-5)
+    {
+        printf("FAILED: GPU_SinCos is not close enough to sin() and cos()\n");
+        failed = 1;
+    }
+
+    sink = 0.0f;
+    start = clock();
+    for(i = 0; i < NUM_ANGLES; i++)
+    {
+        float angle = -100.0f + 200.0f*i/NUM_ANGLES;
+        sink += (float)cos(angle) + (float)sin(angle);
+    }
+    libm_ms = (clock() - start)*1000.0/CLOCKS_PER_SEC;
+
+    start = clock();
+    for(i = 0; i < NUM_ANGLES; i++)
+    {
+        float angle = -100.0f + 200.0f*i/NUM_ANGLES;
+        float s, c;
+        GPU_SinCos(angle, &s, &c);
+        sink += c + s;
+    }
+    sincos_ms = (clock() - start)*1000.0/CLOCKS_PER_SEC;
+    printf("%d angles: cos() and sin() %.1f ms, GPU_SinCos() %.1f ms\n", NUM_ANGLES, libm_ms, sincos_ms);
+
+    default_simd = GPU_GetSIMD();
+    printf("Default instruction set: %s\n", get_simd_name(default_simd));
+
+    // 8 floats is the default layout, 9 has a texture slot after the color
+    for(floats_per_vertex = 8; floats_per_vertex <= 9; floats_per_vertex++)
+    {
+        int num_floats = NUM_SPRITES*4*floats_per_vertex;
+        expected = (float*)calloc(num_floats, sizeof(float));
+        result = (float*)calloc(num_floats, sizeof(float));
+
+        GPU_SetSIMD(GPU_SIMD_NONE);
+        scalar_ms = make_vertices(sprites, expected, floats_per_vertex);
+        printf("%d floats per vertex, %d sprites x %d: scalar %.1f ms\n", floats_per_vertex, NUM_SPRITES, NUM_REPEATS, scalar_ms);
+
+        for(j = 0; j < 2; j++)
+        {
+            double ms;
+            float max_error = 0.0f;
+
+            if(GPU_SetSIMD(simd_sets[j]) != simd_sets[j])
+                continue;
+
+            ms = make_vertices(sprites, result, floats_per_vertex);
+
+            // Allow for a different rounding order (e.g. fused multiply-add)
+            for(i = 0; i < num_floats; i++)
+            {
+                float error = fabsf(result[i] - expected[i])/(1.0f + fabsf(expected[i]));
+                if(error > max_error)
+                    max_error = error;
+            }
+
+            printf("    %s %.1f ms (%.2fx), max relative difference %g\n", get_simd_name(simd_sets[j]), ms, (ms > 0.0? scalar_ms/ms : 0.0), max_error);
+            if(max_error > 1e-6f)
+            {
+                printf("FAILED: %s output does not match the scalar path\n", get_simd_name(simd_sets[j]));
+                failed = 1;
+            }
+        }
+
+        free(expected);
+        free(result);
+    }
+
+    GPU_SetSIMD(default_simd);
+    free(sprites);
+
+    (void)sink;
+    return failed;
+}
+